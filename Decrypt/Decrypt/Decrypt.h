@@ -15,6 +15,7 @@
 extern "C" {
 	DECRYPT_API bool decrypt3DES(const char* filePath, const char* fileName, const char* dstPath);
 	DECRYPT_API bool decryptAES(const char* filePath, const char* fileName, const char* dstPath);
+	DECRYPT_API bool decryptFile(const char* filePath, const char* fileName, const char* password, const char* dstPath);
 	DECRYPT_API const char* getVersion();
 	DECRYPT_API bool initialize();
 	DECRYPT_API void cleanup();
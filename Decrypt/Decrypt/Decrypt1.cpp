@@ -10,7 +10,9 @@
 #include <sstream>
 #include <windows.h>
 #include <wincrypt.h>
+#include <bcrypt.h>
 #pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "bcrypt.lib")
 
 class FileDecryptor {
 private:
@@ -228,8 +230,174 @@ private:
         return true;
     }
 
+    // ļʽEncrypt.cppLinuxͬΪСˣ
+    //   ͷ  "ENCF" | u8 汾 | u8 㷨 | u8 Կ㷨 | u8  | u32  | u32 ֿС
+    //         | 16ֽ | 12ֽļ | 4ֽڱ48ֽڣ
+    //   ֿ   | 16ֽ֤ǩļ¼һ飩
+    // ɰCryptoAPIûGCMPBKDF2ʹCNGbcrypt
+    static const BYTE CONTAINER_VERSION = 1;
+    static const BYTE ALGORITHM_AES_256_GCM = 1;
+    static const BYTE KDF_PBKDF2_SHA256 = 1;
+    static const ULONG MAX_KDF_ITERATIONS = 10000000;
+    static const DWORD CONTAINER_HEADER_SIZE = 48;
+    static const DWORD SALT_OFFSET = 16;
+    static const DWORD SALT_SIZE = 16;
+    static const DWORD NONCE_OFFSET = 32;
+    static const DWORD GCM_NONCE_SIZE = 12;
+    static const DWORD GCM_TAG_SIZE = 16;
+    static const DWORD GCM_MIN_CHUNK = 4 * 1024;
+    static const DWORD GCM_MAX_CHUNK = 64 * 1024 * 1024;
+
+    // ֻеļĩβʱsize
+    static bool readFully(HANDLE hFile, BYTE* buffer, DWORD size, DWORD& total) {
+        total = 0;
+        while (total < size) {
+            DWORD bytesRead = 0;
+            if (!ReadFile(hFile, buffer + total, size - total, &bytesRead, NULL)) {
+                return false;
+            }
+            if (bytesRead == 0) break;
+            total += bytesRead;
+        }
+        return true;
+    }
+
+    static bool writeFully(HANDLE hFile, const BYTE* data, DWORD size) {
+        while (size > 0) {
+            DWORD written = 0;
+            if (!WriteFile(hFile, data, size, &written, NULL) || written == 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    static DWORD getLE32(const BYTE* p) {
+        return static_cast<DWORD>(p[0]) | static_cast<DWORD>(p[1]) << 8 |
+            static_cast<DWORD>(p[2]) << 16 | static_cast<DWORD>(p[3]) << 24;
+    }
+
+    // ɿ256λԿPBKDF2-HMAC-SHA256
+    static bool deriveContainerKey(const std::string& password, const BYTE* salt, ULONG iterations, BYTE* key) {
+        BCRYPT_ALG_HANDLE hPrf = NULL;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&hPrf, BCRYPT_SHA256_ALGORITHM, NULL, BCRYPT_ALG_HANDLE_HMAC_FLAG))) {
+            return false;
+        }
+        NTSTATUS status = BCryptDeriveKeyPBKDF2(hPrf, (PUCHAR)password.data(), static_cast<ULONG>(password.length()),
+            (PUCHAR)salt, SALT_SIZE, iterations, key, 32, 0);
+        BCryptCloseAlgorithmProvider(hPrf, 0);
+        return BCRYPT_SUCCESS(status);
+    }
+
+    // ԭؽһֿ鲢Уǩnonce͸֤ݵĹܶͬ
+    static bool openChunk(BCRYPT_KEY_HANDLE hKey, const BYTE* header, ULONGLONG index, bool last,
+        BYTE* data, ULONG length, BYTE* tag) {
+        BYTE nonce[GCM_NONCE_SIZE];
+        memcpy(nonce, header + NONCE_OFFSET, GCM_NONCE_SIZE);
+        for (int i = 0; i < 8; i++) {
+            nonce[GCM_NONCE_SIZE - 1 - i] ^= static_cast<BYTE>(index >> (8 * i));
+        }
+        BYTE aad[CONTAINER_HEADER_SIZE + 1];
+        memcpy(aad, header, CONTAINER_HEADER_SIZE);
+        aad[CONTAINER_HEADER_SIZE] = last ? 1 : 0;
+
+        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+        BCRYPT_INIT_AUTH_MODE_INFO(info);
+        info.pbNonce = nonce;
+        info.cbNonce = GCM_NONCE_SIZE;
+        info.pbAuthData = aad;
+        info.cbAuthData = sizeof(aad);
+        info.pbTag = tag;
+        info.cbTag = GCM_TAG_SIZE;
+
+        ULONG written = 0;
+        return BCRYPT_SUCCESS(BCryptDecrypt(hKey, data, length, &info, NULL, 0, data, length, &written, 0));
+    }
+
+    // hInʽдhOut˶ǹܵȫȡͷ
+    // ÿ֤ͨд
+    static bool decryptContainer(HANDLE hIn, HANDLE hOut, const std::string& password) {
+        BYTE header[CONTAINER_HEADER_SIZE];
+        DWORD got = 0;
+        if (!readFully(hIn, header, CONTAINER_HEADER_SIZE, got) || got != CONTAINER_HEADER_SIZE ||
+            memcmp(header, "ENCF", 4) != 0) {
+            std::cerr << "Ǽļ" << std::endl;
+            return false;
+        }
+        if (header[4] != CONTAINER_VERSION || header[5] != ALGORITHM_AES_256_GCM || header[6] != KDF_PBKDF2_SHA256) {
+            std::cerr << "ֵ֧汾㷨" << std::endl;
+            return false;
+        }
+        ULONG iterations = getLE32(header + 8);
+        DWORD chunkSize = getLE32(header + 12);
+        if (iterations == 0 || iterations > MAX_KDF_ITERATIONS || chunkSize < GCM_MIN_CHUNK || chunkSize > GCM_MAX_CHUNK) {
+            std::cerr << "ͷЧ" << std::endl;
+            return false;
+        }
+
+        BYTE key[32];
+        if (!deriveContainerKey(password, header + SALT_OFFSET, iterations, key)) {
+            std::cerr << "Կʧ" << std::endl;
+            return false;
+        }
+
+        BCRYPT_ALG_HANDLE hAlg = NULL;
+        BCRYPT_KEY_HANDLE hKey = NULL;
+        bool success = false;
+
+        do {
+            if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_AES_ALGORITHM, NULL, 0))) {
+                break;
+            }
+            if (!BCRYPT_SUCCESS(BCryptSetProperty(hAlg, BCRYPT_CHAINING_MODE, (PUCHAR)BCRYPT_CHAIN_MODE_GCM,
+                sizeof(BCRYPT_CHAIN_MODE_GCM), 0))) {
+                break;
+            }
+            if (!BCRYPT_SUCCESS(BCryptGenerateSymmetricKey(hAlg, &hKey, NULL, 0, key, sizeof(key), 0))) {
+                break;
+            }
+
+            // ļ¼һ飬֮
+            const DWORD recordSize = chunkSize + GCM_TAG_SIZE;
+            std::vector<BYTE> buffer(recordSize);
+            ULONGLONG index = 0;
+            while (true) {
+                if (!readFully(hIn, buffer.data(), recordSize, got)) {
+                    break;
+                }
+                if (got < GCM_TAG_SIZE) {
+                    std::cerr << "ļѽض" << std::endl;
+                    break;
+                }
+                bool last = got < recordSize;
+                DWORD length = got - GCM_TAG_SIZE;
+                if (!openChunk(hKey, header, index++, last, buffer.data(), length, buffer.data() + length)) {
+                    std::cerr << "ֿ֤ʧܣ𻵻Կ" << std::endl;
+                    break;
+                }
+                if (!writeFully(hOut, buffer.data(), length)) {
+                    break;
+                }
+                if (last) {
+                    BYTE extra;
+                    success = readFully(hIn, &extra, 1, got) && got == 0;
+                    break;
+                }
+            }
+
+        } while (false);
+
+        SecureZeroMemory(key, sizeof(key));
+        if (hKey) BCryptDestroyKey(hKey);
+        if (hAlg) BCryptCloseAlgorithmProvider(hAlg, 0);
+
+        return success;
+    }
+
 public:
-    // 3DES
+    // 3DESܣɸʽԿȡļIVȡļʱ䣬ļƺ޷ܣ¸ʽʹdecryptFile
     static bool decrypt3DES(const std::string& filePath, const std::string& fileName, 
                            const std::string& dstPath) {
         try {
@@ -311,7 +479,7 @@ public:
         }
     }
 
-    // AES
+    // AESܣɸʽͬϣ
     static bool decryptAES(const std::string& filePath, const std::string& fileName, 
                           const std::string& dstPath) {
         try {
@@ -393,6 +561,59 @@ public:
             return false;
         }
     }
+
+    // Encrypt.cppencryptFileԿκļͷ
+    // ļļʱ޹ءдʱļȫֿ֤ͨŸΪļ
+    static bool decryptFile(const std::string& filePath, const std::string& fileName,
+                           const std::string& password, const std::string& dstPath) {
+        try {
+            std::string inputPath = filePath + fileName;
+            std::string outputFileName = fileName;
+            if (outputFileName.length() > 4 && outputFileName.compare(outputFileName.length() - 4, 4, ".gcm") == 0) {
+                outputFileName.resize(outputFileName.length() - 4);
+            }
+            std::string outputPath = dstPath + outputFileName;
+            std::string tempPath = outputPath + ".part";
+            
+            // ȷĿ¼
+            CreateDirectoryA(dstPath.c_str(), NULL);
+            
+            HANDLE hIn = CreateFileA(inputPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hIn == INVALID_HANDLE_VALUE) {
+                std::cerr << "޷ļ: " << inputPath << std::endl;
+                return false;
+            }
+            HANDLE hOut = CreateFileA(tempPath.c_str(), GENERIC_WRITE, 0, NULL,
+                                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hOut == INVALID_HANDLE_VALUE) {
+                std::cerr << "޷ļ: " << tempPath << std::endl;
+                CloseHandle(hIn);
+                return false;
+            }
+            
+            bool success = decryptContainer(hIn, hOut, password);
+            CloseHandle(hIn);
+            if (!CloseHandle(hOut)) {
+                success = false;
+            }
+            if (success && !MoveFileExA(tempPath.c_str(), outputPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                std::cerr << "޷дļ: " << outputPath << std::endl;
+                success = false;
+            }
+            if (!success) {
+                DeleteFileA(tempPath.c_str());
+                return false;
+            }
+            
+            std::cout << ": " << outputPath << std::endl;
+            return true;
+            
+        } catch (const std::exception& e) {
+            std::cerr << "ܴ: " << e.what() << std::endl;
+            return false;
+        }
+    }
 };
 
 // Ժ
@@ -447,6 +668,14 @@ int main() {
         std::cout << "AESʧ!" << std::endl;
     }
     
+    // ܣԿɿȡļͷļ⸴ơ
+    std::cout << "\n=== ʼ ===" << std::endl;
+    if (FileDecryptor::decryptFile(filePath, "test.txt.gcm", "MySecretKey12345", dstPath)) {
+        std::cout << "ܳɹ!" << std::endl;
+    } else {
+        std::cout << "ʧ!" << std::endl;
+    }
+    
     std::cout << "ɣ˳..." << std::endl;
     std::cin.get();
     
@@ -10,8 +10,10 @@
 #include <sstream>
 #include <windows.h>
 #include <wincrypt.h>
+#include <bcrypt.h>
 
 #pragma comment(lib, "advapi32.lib")
+#pragma comment(lib, "bcrypt.lib")
 
 // DLLڵ
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserved) {
@@ -49,20 +51,100 @@ private:
         return ss.str();
     }
 
-    static std::vector<BYTE> addPKCS7Padding(const std::vector<BYTE>& data, size_t blockSize) {
-        if (data.empty()) return data;
+    // ʽܵĶдС3DESAESСļϸ
+    static const DWORD STREAM_BUFFER_SIZE = 1024 * 1024;
 
-        size_t padLen = blockSize - (data.size() % blockSize);
-        std::vector<BYTE> paddedData = data;
-        for (size_t i = 0; i < padLen; ++i) {
-            paddedData.push_back(static_cast<BYTE>(padLen));
+    // ֻеļĩβʱsize
+    static bool readFully(HANDLE hFile, BYTE* buffer, DWORD size, DWORD& total) {
+        total = 0;
+        while (total < size) {
+            DWORD bytesRead = 0;
+            if (!ReadFile(hFile, buffer + total, size - total, &bytesRead, NULL)) {
+                return false;
+            }
+            if (bytesRead == 0) break;
+            total += bytesRead;
+        }
+        return true;
+    }
+
+    static bool writeFully(HANDLE hFile, const BYTE* data, DWORD size) {
+        while (size > 0) {
+            DWORD written = 0;
+            if (!WriteFile(hFile, data, size, &written, NULL) || written == 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    // úIVģʽԿʽܣFinal=FALSEܣһȲһPKCS7
+    // Final=TRUEܣCryptoAPIٲһ㣩ļһμͬڴռļС޹
+    static bool encryptFileWithKey(HCRYPTKEY hKey, DWORD blockSize,
+        const std::string& inputPath, const std::string& outputPath) {
+        HANDLE hIn = CreateFileA(inputPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hIn == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        // ļ
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(hIn, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(hIn);
+            return false;
+        }
+
+        HANDLE hOut = CreateFileA(outputPath.c_str(), GENERIC_WRITE, 0, NULL,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hOut == INVALID_HANDLE_VALUE) {
+            CloseHandle(hIn);
+            return false;
+        }
+
+        std::vector<BYTE> buffer(STREAM_BUFFER_SIZE + 2 * blockSize);
+        bool success = false;
+        while (true) {
+            DWORD got = 0;
+            if (!readFully(hIn, buffer.data(), STREAM_BUFFER_SIZE, got)) {
+                break;
+            }
+
+            BOOL last = got < STREAM_BUFFER_SIZE;
+            DWORD dataLen = got;
+            if (last) {
+                // PKCS7
+                DWORD padLen = blockSize - (got % blockSize);
+                memset(buffer.data() + got, static_cast<int>(padLen), padLen);
+                dataLen += padLen;
+            }
+
+            if (!CryptEncrypt(hKey, 0, last, 0, buffer.data(), &dataLen, static_cast<DWORD>(buffer.size()))) {
+                break;
+            }
+            if (!writeFully(hOut, buffer.data(), dataLen)) {
+                break;
+            }
+            if (last) {
+                success = true;
+                break;
+            }
         }
-        return paddedData;
+
+        CloseHandle(hIn);
+        if (!CloseHandle(hOut)) {
+            success = false;
+        }
+        if (!success) {
+            DeleteFileA(outputPath.c_str());
+        }
+        return success;
     }
 
-    static bool encrypt3DESWithCryptoAPI(const std::vector<BYTE>& plainData,
-        const std::string& key, const std::string& iv,
-        std::vector<BYTE>& encryptedData) {
+    static bool encrypt3DESWithCryptoAPI(const std::string& inputPath, const std::string& outputPath,
+        const std::string& key, const std::string& iv) {
         HCRYPTPROV hProv = NULL;
         HCRYPTKEY hKey = NULL;
         HCRYPTHASH hHash = NULL;
@@ -94,18 +176,8 @@ private:
                 break;
             }
 
-            // PKCS7
-            std::vector<BYTE> paddedData = addPKCS7Padding(plainData, 8);
-
-            DWORD dataLen = static_cast<DWORD>(paddedData.size());
-            encryptedData = paddedData;
-
-            if (!CryptEncrypt(hKey, 0, TRUE, 0, encryptedData.data(), &dataLen, static_cast<DWORD>(encryptedData.size()))) {
-                break;
-            }
-
-            encryptedData.resize(dataLen);
-            success = true;
+            // ʽд
+            success = encryptFileWithKey(hKey, 8, inputPath, outputPath);
 
         } while (false);
 
@@ -117,9 +189,8 @@ private:
         return success;
     }
 
-    static bool encryptAESWithCryptoAPI(const std::vector<BYTE>& plainData,
-        const std::string& key, const std::string& iv,
-        std::vector<BYTE>& encryptedData) {
+    static bool encryptAESWithCryptoAPI(const std::string& inputPath, const std::string& outputPath,
+        const std::string& key, const std::string& iv) {
         HCRYPTPROV hProv = NULL;
         HCRYPTKEY hKey = NULL;
         HCRYPTHASH hHash = NULL;
@@ -153,25 +224,138 @@ private:
                 break;
             }
 
-            // PKCS7
-            std::vector<BYTE> paddedData = addPKCS7Padding(plainData, 16);
+            // ʽд
+            success = encryptFileWithKey(hKey, 16, inputPath, outputPath);
+
+        } while (false);
+
+        // Դ
+        if (hKey) CryptDestroyKey(hKey);
+        if (hHash) CryptDestroyHash(hHash);
+        if (hProv) CryptReleaseContext(hProv, 0);
+
+        return success;
+    }
+
+    // ļʽLinuxencrypt.cppͬΪСˣ
+    //   ͷ  "ENCF" | u8 汾 | u8 㷨 | u8 Կ㷨 | u8  | u32  | u32 ֿС
+    //         | 16ֽ | 12ֽļ | 4ֽڱ48ֽڣ
+    //   ֿ  ģһΪֿС| 16ֽ֤ǩ
+    // ɰCryptoAPIûGCMPBKDF2ʹCNGbcrypt
+    static const BYTE CONTAINER_VERSION = 1;
+    static const BYTE ALGORITHM_AES_256_GCM = 1;
+    static const BYTE KDF_PBKDF2_SHA256 = 1;
+    static const ULONG KDF_ITERATIONS = 100000;
+    static const DWORD CONTAINER_HEADER_SIZE = 48;
+    static const DWORD SALT_OFFSET = 16;
+    static const DWORD SALT_SIZE = 16;
+    static const DWORD NONCE_OFFSET = 32;
+    static const DWORD GCM_CHUNK_SIZE = STREAM_BUFFER_SIZE;
+    static const DWORD GCM_NONCE_SIZE = 12;
+    static const DWORD GCM_TAG_SIZE = 16;
+
+    // ɿ256λԿPBKDF2-HMAC-SHA256
+    static bool deriveContainerKey(const std::string& password, const BYTE* salt, ULONG iterations, BYTE* key) {
+        BCRYPT_ALG_HANDLE hPrf = NULL;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&hPrf, BCRYPT_SHA256_ALGORITHM, NULL, BCRYPT_ALG_HANDLE_HMAC_FLAG))) {
+            return false;
+        }
+        NTSTATUS status = BCryptDeriveKeyPBKDF2(hPrf, (PUCHAR)password.data(), static_cast<ULONG>(password.length()),
+            (PUCHAR)salt, SALT_SIZE, iterations, key, 32, 0);
+        BCryptCloseAlgorithmProvider(hPrf, 0);
+        return BCRYPT_SUCCESS(status);
+    }
+
+    // inonceΪļĺ8ֽiˣͷ͡Ƿһ顱־Ϊ֤
+    static bool sealChunk(BCRYPT_KEY_HANDLE hKey, const BYTE* header, ULONGLONG index, bool last,
+        BYTE* data, ULONG length, BYTE* tag) {
+        BYTE nonce[GCM_NONCE_SIZE];
+        memcpy(nonce, header + NONCE_OFFSET, GCM_NONCE_SIZE);
+        for (int i = 0; i < 8; i++) {
+            nonce[GCM_NONCE_SIZE - 1 - i] ^= static_cast<BYTE>(index >> (8 * i));
+        }
+        BYTE aad[CONTAINER_HEADER_SIZE + 1];
+        memcpy(aad, header, CONTAINER_HEADER_SIZE);
+        aad[CONTAINER_HEADER_SIZE] = last ? 1 : 0;
+
+        BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+        BCRYPT_INIT_AUTH_MODE_INFO(info);
+        info.pbNonce = nonce;
+        info.cbNonce = GCM_NONCE_SIZE;
+        info.pbAuthData = aad;
+        info.cbAuthData = sizeof(aad);
+        info.pbTag = tag;
+        info.cbTag = GCM_TAG_SIZE;
+
+        ULONG written = 0;
+        return BCRYPT_SUCCESS(BCryptEncrypt(hKey, data, length, &info, NULL, 0, data, length, &written, 0));
+    }
+
+    // hInеļΪʽдhOut˶ǹܵGetStdHandleõľ
+    static bool encryptContainer(HANDLE hIn, HANDLE hOut, const std::string& password) {
+        BYTE header[CONTAINER_HEADER_SIZE] = {};
+        memcpy(header, "ENCF", 4);
+        header[4] = CONTAINER_VERSION;
+        header[5] = ALGORITHM_AES_256_GCM;
+        header[6] = KDF_PBKDF2_SHA256;
+        for (int i = 0; i < 4; i++) {
+            header[8 + i] = static_cast<BYTE>(KDF_ITERATIONS >> (8 * i));
+            header[12 + i] = static_cast<BYTE>(GCM_CHUNK_SIZE >> (8 * i));
+        }
+        if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, header + SALT_OFFSET, SALT_SIZE, BCRYPT_USE_SYSTEM_PREFERRED_RNG)) ||
+            !BCRYPT_SUCCESS(BCryptGenRandom(NULL, header + NONCE_OFFSET, GCM_NONCE_SIZE, BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
+            return false;
+        }
+
+        BYTE key[32];
+        if (!deriveContainerKey(password, header + SALT_OFFSET, KDF_ITERATIONS, key)) {
+            return false;
+        }
 
-            DWORD dataLen = static_cast<DWORD>(paddedData.size());
-            encryptedData = paddedData;
+        BCRYPT_ALG_HANDLE hAlg = NULL;
+        BCRYPT_KEY_HANDLE hKey = NULL;
+        bool success = false;
 
-            if (!CryptEncrypt(hKey, 0, TRUE, 0, encryptedData.data(), &dataLen, static_cast<DWORD>(encryptedData.size()))) {
+        do {
+            if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_AES_ALGORITHM, NULL, 0))) {
+                break;
+            }
+            if (!BCRYPT_SUCCESS(BCryptSetProperty(hAlg, BCRYPT_CHAINING_MODE, (PUCHAR)BCRYPT_CHAIN_MODE_GCM,
+                sizeof(BCRYPT_CHAIN_MODE_GCM), 0))) {
+                break;
+            }
+            if (!BCRYPT_SUCCESS(BCryptGenerateSymmetricKey(hAlg, &hKey, NULL, 0, key, sizeof(key), 0))) {
+                break;
+            }
+            if (!writeFully(hOut, header, CONTAINER_HEADER_SIZE)) {
                 break;
             }
 
-            encryptedData.resize(dataLen);
-            success = true;
+            // ĳǡΪֿСʱĩβһյһ
+            std::vector<BYTE> buffer(GCM_CHUNK_SIZE);
+            BYTE tag[GCM_TAG_SIZE];
+            ULONGLONG index = 0;
+            while (true) {
+                DWORD got = 0;
+                if (!readFully(hIn, buffer.data(), GCM_CHUNK_SIZE, got)) {
+                    break;
+                }
+                bool last = got < GCM_CHUNK_SIZE;
+                if (!sealChunk(hKey, header, index++, last, buffer.data(), got, tag) ||
+                    !writeFully(hOut, buffer.data(), got) || !writeFully(hOut, tag, GCM_TAG_SIZE)) {
+                    break;
+                }
+                if (last) {
+                    success = true;
+                    break;
+                }
+            }
 
         } while (false);
 
-        // Դ
-        if (hKey) CryptDestroyKey(hKey);
-        if (hHash) CryptDestroyHash(hHash);
-        if (hProv) CryptReleaseContext(hProv, 0);
+        SecureZeroMemory(key, sizeof(key));
+        if (hKey) BCryptDestroyKey(hKey);
+        if (hAlg) BCryptCloseAlgorithmProvider(hAlg, 0);
 
         return success;
     }
@@ -190,43 +374,13 @@ public:
                 iv.append(8 - iv.length(), '0');
             }
 
-            // ȡԭʼļ
-            std::string inputFilePath = filePath + fileName;
-            std::ifstream inFile(inputFilePath.c_str(), std::ios::binary);
-            if (!inFile) {
-                return false;
-            }
-
-            std::vector<BYTE> plainData(
-                (std::istreambuf_iterator<char>(inFile)),
-                std::istreambuf_iterator<char>()
-            );
-            inFile.close();
-
-            if (plainData.empty()) {
-                return false;
-            }
-
-            // 
-            std::vector<BYTE> encryptedData;
-            if (!encrypt3DESWithCryptoAPI(plainData, key, iv, encryptedData)) {
-                return false;
-            }
-
             // ļʽ3DES_key_filename
+            std::string inputFilePath = filePath + fileName;
             std::string outputFileName = "3DES_" + key + "_" + fileName;
             std::string outputPath = filePath + outputFileName;
 
-            // дļ
-            std::ofstream outFile(outputPath.c_str(), std::ios::binary);
-            if (!outFile) {
-                return false;
-            }
-
-            outFile.write(reinterpret_cast<const char*>(encryptedData.data()), encryptedData.size());
-            outFile.close();
-
-            return true;
+            // ߶߼д
+            return encrypt3DESWithCryptoAPI(inputFilePath, outputPath, key, iv);
         }
         catch (...) {
             return false;
@@ -254,43 +408,47 @@ public:
                 iv.append(16 - iv.length(), '0');
             }
 
-            // ȡԭʼļ
+            // ļʽAES_key_filename
             std::string inputFilePath = filePath + fileName;
-            std::ifstream inFile(inputFilePath.c_str(), std::ios::binary);
-            if (!inFile) {
-                return false;
-            }
+            std::string outputFileName = "AES_" + key + "_" + fileName;
+            std::string outputPath = filePath + outputFileName;
 
-            std::vector<BYTE> plainData(
-                (std::istreambuf_iterator<char>(inFile)),
-                std::istreambuf_iterator<char>()
-            );
-            inFile.close();
+            // ߶߼д
+            return encryptAESWithCryptoAPI(inputFilePath, outputPath, key, iv);
+        }
+        catch (...) {
+            return false;
+        }
+    }
 
-            if (plainData.empty()) {
-                return false;
-            }
+    // ΪAES-256-GCMļͷΪ ļ.gcm
+    // ļļʱ䣬κθܽ
+    static bool encryptFile(const std::string& filePath, const std::string& fileName, const std::string& password) {
+        try {
+            std::string inputPath = filePath + fileName;
+            std::string outputPath = inputPath + ".gcm";
 
-            // 
-            std::vector<BYTE> encryptedData;
-            if (!encryptAESWithCryptoAPI(plainData, key, iv, encryptedData)) {
+            HANDLE hIn = CreateFileA(inputPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hIn == INVALID_HANDLE_VALUE) {
                 return false;
             }
-
-            // ļʽAES_key_filename
-            std::string outputFileName = "AES_" + key + "_" + fileName;
-            std::string outputPath = filePath + outputFileName;
-
-            // дļ
-            std::ofstream outFile(outputPath.c_str(), std::ios::binary);
-            if (!outFile) {
+            HANDLE hOut = CreateFileA(outputPath.c_str(), GENERIC_WRITE, 0, NULL,
+                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hOut == INVALID_HANDLE_VALUE) {
+                CloseHandle(hIn);
                 return false;
             }
 
-            outFile.write(reinterpret_cast<const char*>(encryptedData.data()), encryptedData.size());
-            outFile.close();
-
-            return true;
+            bool success = encryptContainer(hIn, hOut, password);
+            CloseHandle(hIn);
+            if (!CloseHandle(hOut)) {
+                success = false;
+            }
+            if (!success) {
+                DeleteFileA(outputPath.c_str());
+            }
+            return success;
         }
         catch (...) {
             return false;
@@ -313,6 +471,13 @@ ENCRYPT_API bool encryptAES(const char* filePath, const char* fileName, const ch
     return FileEncryptor::encryptAES(filePath, fileName, key);
 }
 
+ENCRYPT_API bool encryptFile(const char* filePath, const char* fileName, const char* password) {
+    if (!filePath || !fileName || !password) {
+        return false;
+    }
+    return FileEncryptor::encryptFile(filePath, fileName, password);
+}
+
 ENCRYPT_API const char* getVersion() {
     return "FileEncryptor DLL v1.0";
 }
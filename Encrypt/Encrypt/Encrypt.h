@@ -15,6 +15,7 @@
 extern "C" {
 	ENCRYPT_API bool encrypt3DES(const char* filePath, const char* fileName, const char* dstPath);
 	ENCRYPT_API bool encryptAES(const char* filePath, const char* fileName, const char* dstPath);
+	ENCRYPT_API bool encryptFile(const char* filePath, const char* fileName, const char* password);
 	ENCRYPT_API const char* getVersion();
 	ENCRYPT_API bool initialize();
 	ENCRYPT_API void cleanup();
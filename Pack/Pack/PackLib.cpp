@@ -1,13 +1,14 @@
 #include "pch.h"
 #include "PackLib.h"
 #include <windows.h>
-#include <shellapi.h>
-#include <strsafe.h>
 #include <string>
 #include <vector>
-#include <sstream>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+
+#include <archive.h>
+#include <archive_entry.h>
 
 namespace CompressionLib
 {
@@ -89,307 +90,149 @@ namespace CompressionLib
             return path.substr(pos + 1);
         }
 
-        // 򻯵ZIPļC++ʵ֣
-        bool CreateSimpleZip(const std::string& zipPath, const std::vector<std::string>& filesToAdd)
+        // ȡlibarchiveϢ
+        std::string ArchiveErrorString(struct archive* a)
         {
-            // յZIPļ
-            std::ofstream zipFile(zipPath, std::ios::binary);
-            if (!zipFile)
-            {
-                SetLastError("Failed to create ZIP file: " + zipPath);
-                return false;
-            }
+            const char* msg = archive_error_string(a);
+            return msg ? msg : "unknown error";
+        }
+
+        // תΪ鵵·ͳһʹ'/'ָ
+        std::string ToArchivePath(const std::string& path)
+        {
+            std::string result = path;
+            std::replace(result.begin(), result.end(), '\\', '/');
+            while (!result.empty() && result.back() == '/')
+                result.pop_back();
+            return result;
+        }
 
-            std::vector<uint32_t> fileOffsets;
-            std::vector<uint32_t> fileSizes;
+        // Ŀ¼д鵵
+        bool AddDiskTree(struct archive* disk, struct archive* writer,
+            const std::string& diskRoot, const std::string& archiveRoot)
+        {
+            char buffer[64 * 1024];
 
-            // ÿļZIP
-            for (const auto& file : filesToAdd)
+            for (;;)
             {
-                if (!PathExists(file))
-                    continue;
+                struct archive_entry* entry = archive_entry_new();
+                int r = archive_read_next_header2(disk, entry);
+                if (r == ARCHIVE_EOF)
+                {
+                    archive_entry_free(entry);
+                    return true;
+                }
+                if (r < ARCHIVE_WARN)
+                {
+                    SetLastError("Failed to read directory: " + diskRoot + " - " + ArchiveErrorString(disk));
+                    archive_entry_free(entry);
+                    return false;
+                }
 
-                uint32_t fileOffset = static_cast<uint32_t>(zipFile.tellp());
+                archive_read_disk_descend(disk);
 
-                if (IsDirectory(file))
+                // ·Ŀл̵ǰĿ¼
+                std::string diskPath = ToArchivePath(archive_entry_sourcepath(entry));
+                std::string rootPath = ToArchivePath(diskRoot);
+                std::string entryName = archiveRoot + diskPath.substr(std::min(rootPath.length(), diskPath.length()));
+                if (archive_entry_filetype(entry) == AE_IFDIR)
+                    entryName += "/";
+                archive_entry_set_pathname(entry, entryName.c_str());
+
+                if (archive_write_header(writer, entry) < ARCHIVE_WARN)
                 {
-                    // Ŀ¼Ŀ
-                    std::string dirName = GetFileName(file) + "/";
-
-                    // ļͷ
-                    const char* header = "PK\x03\x04"; // Local file header signature
-                    zipFile.write(header, 4);
-
-                    uint16_t version = 20;
-                    uint16_t flags = 0;
-                    uint16_t compression = 0; // Store
-                    uint16_t modTime = 0;
-                    uint16_t modDate = 0;
-                    uint32_t crc32 = 0;
-                    uint32_t compressedSize = 0;
-                    uint32_t uncompressedSize = 0;
-                    uint16_t nameLength = static_cast<uint16_t>(dirName.length());
-                    uint16_t extraLength = 0;
-
-                    zipFile.write(reinterpret_cast<const char*>(&version), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&flags), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&compression), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&modTime), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&modDate), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&crc32), 4);
-                    zipFile.write(reinterpret_cast<const char*>(&compressedSize), 4);
-                    zipFile.write(reinterpret_cast<const char*>(&uncompressedSize), 4);
-                    zipFile.write(reinterpret_cast<const char*>(&nameLength), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&extraLength), 2);
-                    zipFile.write(dirName.c_str(), nameLength);
-
-                    fileOffsets.push_back(fileOffset);
-                    fileSizes.push_back(0);
+                    SetLastError("Failed to write entry header: " + entryName + " - " + ArchiveErrorString(writer));
+                    archive_entry_free(entry);
+                    return false;
                 }
-                else
+
+                if (archive_entry_filetype(entry) == AE_IFREG && archive_entry_size(entry) > 0)
                 {
-                    // ļĿ
-                    std::ifstream inputFile(file, std::ios::binary);
-                    if (!inputFile)
-                        continue;
-
-                    // ȡļ
-                    inputFile.seekg(0, std::ios::end);
-                    size_t fileSize = inputFile.tellg();
-                    inputFile.seekg(0, std::ios::beg);
-
-                    std::vector<char> fileData(fileSize);
-                    inputFile.read(fileData.data(), fileSize);
-
-                    std::string fileName = GetFileName(file);
-
-                    // ļͷ
-                    const char* header = "PK\x03\x04"; // Local file header signature
-                    zipFile.write(header, 4);
-
-                    uint16_t version = 20;
-                    uint16_t flags = 0;
-                    uint16_t compression = 0; // Store (no compression)
-                    uint16_t modTime = 0;
-                    uint16_t modDate = 0;
-                    uint32_t crc32 = 0; // 򻯴ʵӦüCRC32
-                    uint32_t compressedSize = static_cast<uint32_t>(fileSize);
-                    uint32_t uncompressedSize = static_cast<uint32_t>(fileSize);
-                    uint16_t nameLength = static_cast<uint16_t>(fileName.length());
-                    uint16_t extraLength = 0;
-
-                    zipFile.write(reinterpret_cast<const char*>(&version), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&flags), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&compression), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&modTime), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&modDate), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&crc32), 4);
-                    zipFile.write(reinterpret_cast<const char*>(&compressedSize), 4);
-                    zipFile.write(reinterpret_cast<const char*>(&uncompressedSize), 4);
-                    zipFile.write(reinterpret_cast<const char*>(&nameLength), 2);
-                    zipFile.write(reinterpret_cast<const char*>(&extraLength), 2);
-                    zipFile.write(fileName.c_str(), nameLength);
-                    zipFile.write(fileData.data(), fileSize);
-
-                    fileOffsets.push_back(fileOffset);
-                    fileSizes.push_back(static_cast<uint32_t>(fileSize));
+                    std::ifstream input(archive_entry_sourcepath(entry), std::ios::binary);
+                    if (!input)
+                    {
+                        SetLastError("Failed to open file: " + diskPath);
+                        archive_entry_free(entry);
+                        return false;
+                    }
+
+                    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
+                    {
+                        if (archive_write_data(writer, buffer, static_cast<size_t>(input.gcount())) < 0)
+                        {
+                            SetLastError("Failed to write file data: " + entryName + " - " + ArchiveErrorString(writer));
+                            archive_entry_free(entry);
+                            return false;
+                        }
+                    }
                 }
-            }
 
-            // Ŀ¼¼
-            uint32_t centralDirOffset = static_cast<uint32_t>(zipFile.tellp());
-            for (size_t i = 0; i < filesToAdd.size(); ++i)
-            {
-                if (!PathExists(filesToAdd[i])) continue;
-
-                const char* centralHeader = "PK\x01\x02"; // Central directory file header signature
-                zipFile.write(centralHeader, 4);
-
-                std::string fileName = IsDirectory(filesToAdd[i]) ?
-                    GetFileName(filesToAdd[i]) + "/" : GetFileName(filesToAdd[i]);
-
-                uint16_t versionMadeBy = 20;
-                uint16_t versionNeeded = 20;
-                uint16_t flags = 0;
-                uint16_t compression = 0;
-                uint16_t modTime = 0;
-                uint16_t modDate = 0;
-                uint32_t crc32 = 0;
-                uint32_t compressedSize = fileSizes[i];
-                uint32_t uncompressedSize = fileSizes[i];
-                uint16_t nameLength = static_cast<uint16_t>(fileName.length());
-                uint16_t extraLength = 0;
-                uint16_t commentLength = 0;
-                uint16_t diskNumber = 0;
-                uint16_t internalAttributes = 0;
-                uint32_t externalAttributes = 0;
-                uint32_t relativeOffset = fileOffsets[i];
-
-                zipFile.write(reinterpret_cast<const char*>(&versionMadeBy), 2);
-                zipFile.write(reinterpret_cast<const char*>(&versionNeeded), 2);
-                zipFile.write(reinterpret_cast<const char*>(&flags), 2);
-                zipFile.write(reinterpret_cast<const char*>(&compression), 2);
-                zipFile.write(reinterpret_cast<const char*>(&modTime), 2);
-                zipFile.write(reinterpret_cast<const char*>(&modDate), 2);
-                zipFile.write(reinterpret_cast<const char*>(&crc32), 4);
-                zipFile.write(reinterpret_cast<const char*>(&compressedSize), 4);
-                zipFile.write(reinterpret_cast<const char*>(&uncompressedSize), 4);
-                zipFile.write(reinterpret_cast<const char*>(&nameLength), 2);
-                zipFile.write(reinterpret_cast<const char*>(&extraLength), 2);
-                zipFile.write(reinterpret_cast<const char*>(&commentLength), 2);
-                zipFile.write(reinterpret_cast<const char*>(&diskNumber), 2);
-                zipFile.write(reinterpret_cast<const char*>(&internalAttributes), 2);
-                zipFile.write(reinterpret_cast<const char*>(&externalAttributes), 4);
-                zipFile.write(reinterpret_cast<const char*>(&relativeOffset), 4);
-                zipFile.write(fileName.c_str(), nameLength);
+                archive_entry_free(entry);
             }
-
-            uint32_t centralDirSize = static_cast<uint32_t>(zipFile.tellp()) - centralDirOffset;
-
-            // Ŀ¼β
-            const char* centralEnd = "PK\x05\x06"; // Central directory end signature
-            zipFile.write(centralEnd, 4);
-
-            uint16_t diskNumber = 0;
-            uint16_t centralStartDisk = 0;
-            uint16_t centralEntries = static_cast<uint16_t>(filesToAdd.size());
-            uint16_t totalEntries = static_cast<uint16_t>(filesToAdd.size());
-            uint32_t centralSize = centralDirSize;
-            uint32_t centralOffset = centralDirOffset;
-            uint16_t commentLength = 0;
-
-            zipFile.write(reinterpret_cast<const char*>(&diskNumber), 2);
-            zipFile.write(reinterpret_cast<const char*>(&centralStartDisk), 2);
-            zipFile.write(reinterpret_cast<const char*>(&centralEntries), 2);
-            zipFile.write(reinterpret_cast<const char*>(&totalEntries), 2);
-            zipFile.write(reinterpret_cast<const char*>(&centralSize), 4);
-            zipFile.write(reinterpret_cast<const char*>(&centralOffset), 4);
-            zipFile.write(reinterpret_cast<const char*>(&commentLength), 2);
-
-            zipFile.close();
-            return true;
         }
 
-        // ʹWindows tartar.gz
-        bool CreateTarGzWithCommand(const std::string& sourcePath, const std::vector<std::string>& files,
-            const std::string& outputPath)
+        // ʹlibarchiveڽڴZIPTAR.GZⲿ̣޸ĵǰĿ¼
+        bool CreateArchiveWithLibarchive(ArchiveFormat format, const std::string& sourcePath,
+            const std::vector<std::string>& files, const std::string& outputPath,
+            const CompressionConfig& config)
         {
-            // 浱ǰĿ¼
-            char currentDir[MAX_PATH];
-            GetCurrentDirectoryA(MAX_PATH, currentDir);
+            struct archive* writer = archive_write_new();
+            std::string options;
 
-            // лԴĿ¼
-            if (!SetCurrentDirectoryA(sourcePath.c_str()))
+            if (format == ArchiveFormat::ZIP)
             {
-                SetLastError("Failed to change directory to: " + sourcePath);
-                return false;
+                archive_write_set_format_zip(writer);
+                options = "zip:compression-level=" + std::to_string(config.compressionLevel);
             }
-
-            // tar
-            std::stringstream cmd;
-            cmd << "tar -czf \"" << outputPath << "\"";
-
-            // ļ
-            for (const auto& file : files)
+            else
             {
-                cmd << " \"" << file << "\"";
+                archive_write_set_format_pax_restricted(writer);
+                archive_write_add_filter_gzip(writer);
+                options = "gzip:compression-level=" + std::to_string(config.compressionLevel);
             }
 
-            std::string command = cmd.str();
-
-            // ִtar
-            STARTUPINFOA si = { sizeof(si) };
-            PROCESS_INFORMATION pi;
-
-            si.dwFlags = STARTF_USESHOWWINDOW;
-            si.wShowWindow = SW_HIDE;
-
-            BOOL success = CreateProcessA(
-                nullptr,
-                const_cast<LPSTR>(command.c_str()),
-                nullptr,
-                nullptr,
-                FALSE,
-                CREATE_NO_WINDOW,
-                nullptr,
-                nullptr,
-                &si,
-                &pi
-            );
-
-            if (!success)
+            // ѹΪѡɰ汾libarchive֧ʱ
+            archive_write_set_options(writer, options.c_str());
+
+            if (archive_write_open_filename(writer, outputPath.c_str()) != ARCHIVE_OK)
             {
-                SetCurrentDirectoryA(currentDir);
-                SetLastError("Failed to execute tar command: " + command);
+                SetLastError("Failed to create archive: " + outputPath + " - " + ArchiveErrorString(writer));
+                archive_write_free(writer);
                 return false;
             }
 
-            // ȴ
-            WaitForSingleObject(pi.hProcess, 30000);
-
-            DWORD exitCode;
-            GetExitCodeProcess(pi.hProcess, &exitCode);
+            struct archive* disk = archive_read_disk_new();
+            archive_read_disk_set_standard_lookup(disk);
 
-            CloseHandle(pi.hProcess);
-            CloseHandle(pi.hThread);
-            SetCurrentDirectoryA(currentDir);
-
-            return exitCode == 0;
-        }
-
-        // ʹPowerShellZIPWindows 8+
-        bool CreateZipWithPowerShell(const std::string& sourcePath, const std::vector<std::string>& files,
-            const std::string& outputPath)
-        {
-            // PowerShell
-            std::stringstream cmd;
-            cmd << "powershell -Command \"Compress-Archive -Path '";
-
-            for (size_t i = 0; i < files.size(); ++i)
+            bool success = true;
+            for (const auto& file : files)
             {
-                if (i > 0) cmd << "', '";
-                cmd << Internal::JoinPath(sourcePath, files[i]);
-            }
+                std::string diskRoot = JoinPath(sourcePath, file);
+                std::string archiveRoot = ToArchivePath(config.preservePath ? file : GetFileName(file));
 
-            cmd << "' -DestinationPath '" << outputPath << "' -Force\"";
-
-            std::string command = cmd.str();
-
-            // ִPowerShell
-            STARTUPINFOA si = { sizeof(si) };
-            PROCESS_INFORMATION pi;
+                if (archive_read_disk_open(disk, diskRoot.c_str()) != ARCHIVE_OK)
+                {
+                    SetLastError("Failed to open path: " + diskRoot + " - " + ArchiveErrorString(disk));
+                    success = false;
+                    break;
+                }
 
-            si.dwFlags = STARTF_USESHOWWINDOW;
-            si.wShowWindow = SW_HIDE;
+                success = AddDiskTree(disk, writer, diskRoot, archiveRoot);
+                archive_read_close(disk);
+                if (!success)
+                    break;
+            }
 
-            BOOL success = CreateProcessA(
-                nullptr,
-                const_cast<LPSTR>(command.c_str()),
-                nullptr,
-                nullptr,
-                FALSE,
-                CREATE_NO_WINDOW,
-                nullptr,
-                nullptr,
-                &si,
-                &pi
-            );
+            archive_read_free(disk);
 
-            if (!success)
+            if (archive_write_close(writer) != ARCHIVE_OK && success)
             {
-                SetLastError("Failed to execute PowerShell command");
-                return false;
+                SetLastError("Failed to finalize archive: " + outputPath + " - " + ArchiveErrorString(writer));
+                success = false;
             }
+            archive_write_free(writer);
 
-            WaitForSingleObject(pi.hProcess, 30000);
-
-            DWORD exitCode;
-            GetExitCodeProcess(pi.hProcess, &exitCode);
-
-            CloseHandle(pi.hProcess);
-            CloseHandle(pi.hThread);
-
-            return exitCode == 0;
+            return success;
         }
     }
 
@@ -434,8 +277,8 @@ namespace CompressionLib
                 return false;
             }
 
-            // ļ·б
-            std::vector<std::string> fullPaths;
+            // ļб
+            std::vector<std::string> files;
             for (int i = 0; i < fileCount; ++i)
             {
                 std::string fullPath = Internal::JoinPath(srcPath, fileList[i]);
@@ -444,23 +287,12 @@ namespace CompressionLib
                     Internal::SetLastError("File not found: " + fullPath);
                     return false;
                 }
-                fullPaths.push_back(fullPath);
-            }
-
-            // ȳPowerShellWindows 8+
-            std::vector<std::string> relativeFiles;
-            for (int i = 0; i < fileCount; ++i)
-            {
-                relativeFiles.push_back(fileList[i]);
-            }
-
-            if (Internal::CreateZipWithPowerShell(srcPath, relativeFiles, fullArchivePath))
-            {
-                return true;
+                files.push_back(fileList[i]); // ʹ·
             }
 
-            // ˵ZIPʵ
-            return Internal::CreateSimpleZip(fullArchivePath, fullPaths);
+            CompressionConfig defaultConfig;
+            return Internal::CreateArchiveWithLibarchive(ArchiveFormat::ZIP, srcPath, files, fullArchivePath,
+                config ? *config : defaultConfig);
         }
         catch (const std::exception& e)
         {
@@ -509,7 +341,9 @@ namespace CompressionLib
                 files.push_back(fileList[i]); // ʹ·
             }
 
-            return Internal::CreateTarGzWithCommand(srcPath, files, fullArchivePath);
+            CompressionConfig defaultConfig;
+            return Internal::CreateArchiveWithLibarchive(ArchiveFormat::TAR_GZ, srcPath, files, fullArchivePath,
+                config ? *config : defaultConfig);
         }
         catch (const std::exception& e)
         {
@@ -546,6 +380,6 @@ namespace CompressionLib
 
     extern "C" COMPRESSION_API const char* GetCompressionVersion()
     {
-        return "CompressionLib 1.0.0 (Windows Native - No External Dependencies)";
+        return "CompressionLib 1.1.0 (libarchive)";
     }
 }
\ No newline at end of file
@@ -30,7 +30,7 @@ namespace CompressionLib
     // Դ
     extern "C" COMPRESSION_API void Cleanup();
 
-    // ZIPѹļʹWindowsѹ
+    // ZIPѹļlibarchiveʵ֣
     extern "C" COMPRESSION_API bool CreateZipArchive(
         const char* sourcePath,
         const char* const* fileList,
@@ -40,7 +40,7 @@ namespace CompressionLib
         CompressionConfig * config = nullptr
     );
 
-    // TAR.GZѹļʹWindowstar
+    // TAR.GZѹļlibarchiveʵ֣
     extern "C" COMPRESSION_API bool CreateTarGzArchive(
         const char* sourcePath,
         const char* const* fileList,
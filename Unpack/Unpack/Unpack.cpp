@@ -1,15 +1,14 @@
 #include "pch.h"
 #include "Unpack.h"
 #include <windows.h>
-#include <shellapi.h>
-#include <shlwapi.h>
 #include <fstream>
 #include <string>
 #include <algorithm>
 
-#pragma comment(lib, "shell32.lib")
-#pragma comment(lib, "shlwapi.lib")
-#pragma comment(lib, "ole32.lib")
+#include <archive.h>
+#include <archive_entry.h>
+
+#pragma comment(lib, "archive.lib")
 
 // ʵļ¶MINIMAL_APIΪ
 #ifdef MINIMALARCHIVE_EXPORTS
@@ -79,111 +78,106 @@ private:
     std::string base_path;
     std::string last_error;
 
-    // ʹPowerShellѹZIP
-    bool extractWithPowerShell(const std::string& archivePath, const std::string& destPath) {
-        std::string command = "powershell -command \"& {Add-Type -AssemblyName System.IO.Compression.FileSystem; ";
-        command += "[System.IO.Compression.ZipFile]::ExtractToDirectory('";
-        command += archivePath + "', '" + destPath + "');}\"";
-
-        return executeCommand(command);
-    }
-
-    // ʹWindowsõtar
-    bool extractWithTar(const std::string& archivePath, const std::string& destPath) {
-        std::string command = "tar -xf \"" + archivePath + "\" -C \"" + destPath + "\"";
-        return executeCommand(command);
+    // ȡlibarchiveϢ
+    static std::string archiveError(struct archive* a) {
+        const char* msg = archive_error_string(a);
+        return msg ? msg : "unknown error";
     }
 
-    // ʹExpand-Archive PowerShell
-    bool extractWithExpandArchive(const std::string& archivePath, const std::string& destPath) {
-        std::string command = "powershell -command \"Expand-Archive -Path '" +
-            archivePath + "' -DestinationPath '" + destPath + "' -Force\"";
-        return executeCommand(command);
+    // Ŀ·Ƿȫܾ·".."ARCHIVE_EXTRACT_SECURE_NODOTDOTأ
+    static bool isSafeEntryPath(const char* path) {
+        if (!path || !*path) return false;
+        if (path[0] == '/' || path[0] == '\\') return false;
+        if (path[1] == ':') return false;
+        return true;
     }
 
-    // ʹ7-Zipװ
-    bool extractWith7Zip(const std::string& archivePath, const std::string& destPath) {
-        // 7-ZipǷװ
-        const char* sevenZipPaths[] = {
-            "C:\\Program Files\\7-Zip\\7z.exe",
-            "C:\\Program Files (x86)\\7-Zip\\7z.exe"
-        };
-
-        std::string sevenZipPath;
-        for (const char* path : sevenZipPaths) {
-            if (FileExists(path)) {
-                sevenZipPath = path;
-                break;
+    // Ŀݵ
+    bool copyEntryData(struct archive* reader, struct archive* writer) {
+        const void* buff;
+        size_t size;
+        la_int64_t offset;
+
+        for (;;) {
+            int r = archive_read_data_block(reader, &buff, &size, &offset);
+            if (r == ARCHIVE_EOF) return true;
+            if (r < ARCHIVE_WARN) {
+                last_error = "Cannot read entry data: " + archiveError(reader);
+                return false;
+            }
+            if (archive_write_data_block(writer, buff, size, offset) < ARCHIVE_WARN) {
+                last_error = "Cannot write entry data: " + archiveError(writer);
+                return false;
             }
         }
-
-        if (sevenZipPath.empty()) {
-            return false; // 7-Zipδװ
-        }
-
-        std::string command = "\"" + sevenZipPath + "\" x \"" + archivePath + "\" -o\"" + destPath + "\" -y";
-        return executeCommand(command);
     }
 
-    // ִϵͳ
-    bool executeCommand(const std::string& command) {
-        STARTUPINFOA si = { sizeof(si) };
-        PROCESS_INFORMATION pi = { 0 };
-        si.dwFlags = STARTF_USESHOWWINDOW;
-        si.wShowWindow = SW_HIDE;
-
-        // ޸ĵַ
-        char* cmd = new char[command.length() + 1];
-        strcpy_s(cmd, command.length() + 1, command.c_str());
-
-        BOOL success = CreateProcessA(
-            NULL,           // ʹģ
-            cmd,            // 
-            NULL,           // ̾ɼ̳
-            NULL,           // ߳̾ɼ̳
-            FALSE,          // ̳о
-            CREATE_NO_WINDOW, // ־
-            NULL,           // ʹø̻
-            NULL,           // ʹøĿ¼
-            &si,            // ָSTARTUPINFOָ
-            &pi             // ָPROCESS_INFORMATIONָ
-        );
-
-        delete[] cmd;
-
-        if (!success) {
-            last_error = "Cannot create process for command execution";
-            return false;
-        }
+    // ʹlibarchiveڽڽѹzip/tar.*/7z/rarⲿ̣ǰĿ¼
+    bool extractWithLibarchive(const std::string& archivePath, const std::string& destPath) {
+        struct archive* reader = archive_read_new();
+        archive_read_support_format_all(reader);
+        archive_read_support_filter_all(reader);
 
-        // ȴɣ30볬ʱ
-        DWORD waitResult = WaitForSingleObject(pi.hProcess, 30000);
-        if (waitResult == WAIT_TIMEOUT) {
-            TerminateProcess(pi.hProcess, 1);
-            last_error = "Command execution timeout";
-            CloseHandle(pi.hProcess);
-            CloseHandle(pi.hThread);
+        if (archive_read_open_filename(reader, archivePath.c_str(), 64 * 1024) != ARCHIVE_OK) {
+            last_error = "Cannot open archive: " + archiveError(reader);
+            archive_read_free(reader);
             return false;
         }
 
-        DWORD exitCode;
-        GetExitCodeProcess(pi.hProcess, &exitCode);
+        struct archive* writer = archive_write_disk_new();
+        archive_write_disk_set_options(writer,
+            ARCHIVE_EXTRACT_TIME |
+            ARCHIVE_EXTRACT_PERM |
+            ARCHIVE_EXTRACT_SECURE_SYMLINKS |
+            ARCHIVE_EXTRACT_SECURE_NODOTDOT);
+        archive_write_disk_set_standard_lookup(writer);
+
+        bool success = true;
+        struct archive_entry* entry;
+        int r;
+        while ((r = archive_read_next_header(reader, &entry)) == ARCHIVE_OK || r == ARCHIVE_WARN) {
+            const char* name = archive_entry_pathname(entry);
+            if (!isSafeEntryPath(name)) {
+                archive_read_data_skip(reader);
+                continue;
+            }
+
+            // ĿĿ¼Ϊǰ׺д
+            std::string target = destPath + name;
+            archive_entry_set_pathname(entry, target.c_str());
 
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
+            const char* hardlink = archive_entry_hardlink(entry);
+            if (hardlink) {
+                std::string linkTarget = destPath + hardlink;
+                archive_entry_set_hardlink(entry, linkTarget.c_str());
+            }
 
-        if (exitCode != 0) {
-            last_error = "Command failed with exit code: " + std::to_string(exitCode);
-            return false;
+            if (archive_write_header(writer, entry) < ARCHIVE_WARN) {
+                last_error = "Cannot create " + target + ": " + archiveError(writer);
+                success = false;
+                break;
+            }
+
+            if (archive_entry_size(entry) > 0 && !copyEntryData(reader, writer)) {
+                success = false;
+                break;
+            }
+
+            if (archive_write_finish_entry(writer) < ARCHIVE_WARN) {
+                last_error = "Cannot finish " + target + ": " + archiveError(writer);
+                success = false;
+                break;
+            }
         }
 
-        return true;
-    }
+        if (success && r != ARCHIVE_EOF) {
+            last_error = "Cannot read archive: " + archiveError(reader);
+            success = false;
+        }
 
-    // ļǷ
-    bool FileExists(const std::string& path) {
-        DWORD attr = GetFileAttributesA(path.c_str());
-        return (attr != INVALID_FILE_ATTRIBUTES && !(attr & FILE_ATTRIBUTE_DIRECTORY));
+        archive_read_free(reader);
+        archive_write_free(writer);
+        return success;
     }
 
     // ȡļʽ
@@ -194,7 +188,6 @@ private:
         if (ext == ".rar") return "rar";
         if (ext == ".7z") return "7z";
         if (ext == ".tar") return "tar";
-        if (ext == ".gz") return "gz";
 
         // չ
         std::string stem = FileSystemCompat::GetStem(filename);
@@ -206,6 +199,8 @@ private:
             if (ext == ".xz") return "tar.xz";
         }
 
+        if (ext == ".gz") return "gz";
+
         if (ext == ".tgz") return "tar.gz";
         if (ext == ".tbz2") return "tar.bz2";
         if (ext == ".txz") return "tar.xz";
@@ -261,36 +256,13 @@ public:
             return false;
         }
 
-        bool success = false;
-
-        if (format == "zip") {
-            // 1: ʹExpand-ArchiveWindows 10+
-            success = extractWithExpandArchive(full_path, base_path);
-
-            // 2: ʹ.NET ZipFileࣨã
-            if (!success) {
-                success = extractWithPowerShell(full_path, base_path);
-            }
-        }
-        else if (format == "tar" || format == "tar.gz" || format == "tar.bz2" || format == "tgz") {
-            // ʹtarWindows 10+
-            success = extractWithTar(full_path, base_path);
-        }
-        else if (format == "rar" || format == "7z") {
-            // 1: ʹ7-Zip
-            success = extractWith7Zip(full_path, base_path);
-
-            if (!success) {
-                last_error = format + " extraction requires 7-Zip to be installed. ";
-                last_error += "Please install 7-Zip and ensure it's in the default location.";
-                return false;
-            }
-        }
-        else {
+        if (!isFormatSupported(filename)) {
             last_error = "Unsupported archive format: " + format;
             return false;
         }
 
+        bool success = extractWithLibarchive(full_path, base_path);
+
         if (!success && last_error.empty()) {
             last_error = "Extraction failed for unknown reason";
         }
@@ -305,7 +277,7 @@ public:
     bool isFormatSupported(const std::string& filename) override {
         std::string format = getFileFormat(filename);
         return (format == "zip" || format == "tar" || format == "tar.gz" ||
-            format == "tgz" || format == "rar" || format == "7z");
+            format == "tar.bz2" || format == "tar.xz" || format == "rar" || format == "7z");
     }
 };
 
@@ -0,0 +1,376 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <filesystem>
+#include <stdexcept>
+#include <chrono>
+#include <iomanip>
+#include <ctime>
+#include <cstdint>
+#include <sys/stat.h>
+
+// 第三方库头文件
+#include <openssl/evp.h>
+
+namespace fs = std::filesystem;
+
+class IncrementalBackup {
+public:
+    // 清单条目：路径、大小、修改时间、inode、内容哈希以及数据实际所在的快照
+    struct ManifestEntry {
+        std::string path;
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t inode = 0;
+        std::string hash;
+        std::string snapshot;
+    };
+
+    using Manifest = std::map<std::string, ManifestEntry>;
+
+    // 单次备份统计
+    struct BackupStats {
+        size_t total_files = 0;
+        size_t changed_files = 0;
+        size_t unchanged_files = 0;
+        size_t removed_files = 0;
+        size_t skipped_files = 0;
+        uint64_t bytes_copied = 0;
+    };
+
+private:
+    // 缓冲区大小（1MB）
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+    static constexpr const char* MANIFEST_NAME = "manifest.txt";
+    static constexpr const char* DATA_DIR = "data";
+
+    // 获取当前时间字符串（格式：YYYYmmddHHMMSS，与backup.py一致）
+    static std::string getSnapshotName() {
+        auto now = std::chrono::system_clock::now();
+        auto time_t_now = std::chrono::system_clock::to_time_t(now);
+        std::tm tm = *std::localtime(&time_t_now);
+
+        std::stringstream ss;
+        ss << std::put_time(&tm, "%Y%m%d%H%M%S");
+        return ss.str();
+    }
+
+    // 转义清单字段中的制表符、换行符和百分号
+    static std::string escapeField(const std::string& value) {
+        std::string result;
+        for (char c : value) {
+            if (c == '%') result += "%25";
+            else if (c == '\t') result += "%09";
+            else if (c == '\n') result += "%0A";
+            else result += c;
+        }
+        return result;
+    }
+
+    static std::string unescapeField(const std::string& value) {
+        std::string result;
+        for (size_t i = 0; i < value.size(); i++) {
+            if (value[i] == '%' && i + 2 < value.size()) {
+                result += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else {
+                result += value[i];
+            }
+        }
+        return result;
+    }
+
+    static std::string toHex(const unsigned char* data, size_t size) {
+        std::stringstream ss;
+        ss << std::hex << std::setfill('0');
+        for (size_t i = 0; i < size; i++) {
+            ss << std::setw(2) << static_cast<int>(data[i]);
+        }
+        return ss.str();
+    }
+
+    // 计算文件SHA-256；若copy_to非空则在同一次读取中写出副本
+    static std::string hashFile(const fs::path& filepath, const fs::path& copy_to, uint64_t* bytes_copied) {
+        std::ifstream input(filepath, std::ios::binary);
+        if (!input.is_open()) {
+            throw std::runtime_error("无法打开文件: " + filepath.string());
+        }
+
+        std::ofstream output;
+        if (!copy_to.empty()) {
+            fs::create_directories(copy_to.parent_path());
+            output.open(copy_to, std::ios::binary);
+            if (!output.is_open()) {
+                throw std::runtime_error("无法创建文件: " + copy_to.string());
+            }
+        }
+
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        if (!ctx || EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) != 1) {
+            EVP_MD_CTX_free(ctx);
+            throw std::runtime_error("无法初始化SHA-256");
+        }
+
+        std::vector<char> buffer(BUFFER_SIZE);
+        while (input.read(buffer.data(), buffer.size()) || input.gcount() > 0) {
+            std::streamsize n = input.gcount();
+            EVP_DigestUpdate(ctx, buffer.data(), static_cast<size_t>(n));
+            if (output.is_open()) {
+                output.write(buffer.data(), n);
+                if (bytes_copied) *bytes_copied += static_cast<uint64_t>(n);
+            }
+        }
+
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digest_len = 0;
+        EVP_DigestFinal_ex(ctx, digest, &digest_len);
+        EVP_MD_CTX_free(ctx);
+
+        if (output.is_open() && !output) {
+            throw std::runtime_error("写入文件失败: " + copy_to.string());
+        }
+
+        return toHex(digest, digest_len);
+    }
+
+    // 查找最近一次快照（目录名按时间排序，需包含清单）
+    static std::string findLatestSnapshot(const fs::path& backup_root) {
+        std::string latest;
+        if (!fs::exists(backup_root)) {
+            return latest;
+        }
+        for (const auto& entry : fs::directory_iterator(backup_root)) {
+            if (entry.is_directory() && fs::exists(entry.path() / MANIFEST_NAME)) {
+                std::string name = entry.path().filename().string();
+                if (name > latest) latest = name;
+            }
+        }
+        return latest;
+    }
+
+public:
+    // 读取清单
+    static Manifest readManifest(const fs::path& manifest_path) {
+        Manifest manifest;
+        std::ifstream file(manifest_path);
+        if (!file.is_open()) {
+            throw std::runtime_error("无法打开清单: " + manifest_path.string());
+        }
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            std::vector<std::string> fields;
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, '\t')) {
+                fields.push_back(field);
+            }
+            if (fields.size() != 6) {
+                throw std::runtime_error("清单格式错误: " + manifest_path.string());
+            }
+
+            ManifestEntry entry;
+            entry.path = unescapeField(fields[0]);
+            entry.size = std::stoull(fields[1]);
+            entry.mtime_ns = std::stoll(fields[2]);
+            entry.inode = std::stoull(fields[3]);
+            entry.hash = fields[4];
+            entry.snapshot = fields[5];
+            manifest[entry.path] = entry;
+        }
+        return manifest;
+    }
+
+    // 写入清单（先写临时文件再重命名，避免中断时留下半个清单）
+    static void writeManifest(const fs::path& manifest_path, const Manifest& manifest) {
+        fs::path tmp_path = manifest_path.string() + ".tmp";
+        {
+            std::ofstream file(tmp_path);
+            if (!file.is_open()) {
+                throw std::runtime_error("无法创建清单: " + tmp_path.string());
+            }
+            file << "# path\tsize\tmtime_ns\tinode\tsha256\tsnapshot\n";
+            for (const auto& [path, entry] : manifest) {
+                file << escapeField(entry.path) << '\t' << entry.size << '\t' << entry.mtime_ns << '\t'
+                     << entry.inode << '\t' << entry.hash << '\t' << entry.snapshot << '\n';
+            }
+            if (!file) {
+                throw std::runtime_error("写入清单失败: " + tmp_path.string());
+            }
+        }
+        fs::rename(tmp_path, manifest_path);
+    }
+
+    // 增量备份：只读取大小/修改时间/inode发生变化的文件，未变化的条目引用上一次快照
+    static BackupStats backupIncremental(const std::string& source_path, const std::string& backup_path) {
+        fs::path source_root = fs::path(source_path);
+        fs::path backup_root = fs::path(backup_path);
+        BackupStats stats;
+        fs::path snapshot_dir;
+
+        try {
+            if (!fs::is_directory(source_root)) {
+                throw std::runtime_error("源目录不存在: " + source_root.string());
+            }
+
+            Manifest previous;
+            std::string previous_name = findLatestSnapshot(backup_root);
+            if (!previous_name.empty()) {
+                previous = readManifest(backup_root / previous_name / MANIFEST_NAME);
+            }
+
+            std::string snapshot_name = getSnapshotName();
+            if (snapshot_name <= previous_name) {
+                throw std::runtime_error("快照名称冲突: " + snapshot_name);
+            }
+            snapshot_dir = backup_root / snapshot_name;
+            fs::create_directories(snapshot_dir);
+
+            std::cout << "正在增量备份: " << source_root.string() << " -> " << snapshot_dir.string() << std::endl;
+            if (!previous_name.empty()) {
+                std::cout << "基准快照: " << previous_name << " (" << previous.size() << " 个文件)" << std::endl;
+            }
+
+            Manifest current;
+            fs::path backup_canonical = fs::canonical(backup_root);
+            auto options = fs::directory_options::skip_permission_denied;
+            for (auto iter = fs::recursive_directory_iterator(source_root, options); iter != fs::recursive_directory_iterator(); ++iter) {
+                const auto& dir_entry = *iter;
+
+                // 备份目录位于源目录内时跳过，避免备份自身
+                if (dir_entry.is_directory() && fs::equivalent(dir_entry.path(), backup_canonical)) {
+                    iter.disable_recursion_pending();
+                    continue;
+                }
+                if (!dir_entry.is_regular_file() || dir_entry.is_symlink()) {
+                    continue;
+                }
+
+                struct stat st;
+                if (stat(dir_entry.path().c_str(), &st) != 0) {
+                    std::cerr << "警告: 无法获取文件状态: " << dir_entry.path().string() << std::endl;
+                    continue;
+                }
+
+                ManifestEntry entry;
+                entry.path = fs::relative(dir_entry.path(), source_root).generic_string();
+                entry.size = static_cast<uint64_t>(st.st_size);
+                entry.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+                entry.inode = static_cast<uint64_t>(st.st_ino);
+                stats.total_files++;
+
+                // 元数据未变化：直接引用旧条目，不读取文件内容
+                auto it = previous.find(entry.path);
+                if (it != previous.end() && it->second.size == entry.size &&
+                    it->second.mtime_ns == entry.mtime_ns && it->second.inode == entry.inode) {
+                    current[entry.path] = it->second;
+                    stats.unchanged_files++;
+                    continue;
+                }
+
+                // 元数据变化：边哈希边复制到新快照；单个文件读取失败时跳过，不中断整个备份
+                fs::path data_path = snapshot_dir / DATA_DIR / entry.path;
+                uint64_t copied = 0;
+                try {
+                    entry.hash = hashFile(dir_entry.path(), data_path, &copied);
+                } catch (const std::exception& e) {
+                    std::cerr << "警告: " << e.what() << "，跳过" << std::endl;
+                    std::error_code ec;
+                    fs::remove(data_path, ec);
+                    stats.skipped_files++;
+                    continue;
+                }
+                entry.snapshot = snapshot_name;
+
+                // 仅时间戳变化而内容相同，继续引用旧数据
+                if (it != previous.end() && it->second.hash == entry.hash) {
+                    fs::remove(data_path);
+                    entry.snapshot = it->second.snapshot;
+                    stats.unchanged_files++;
+                } else {
+                    std::cout << "  -> 备份: " << entry.path << " (" << entry.size << " 字节)" << std::endl;
+                    stats.changed_files++;
+                    stats.bytes_copied += copied;
+                }
+
+                current[entry.path] = entry;
+            }
+
+            for (const auto& [path, entry] : previous) {
+                if (current.find(path) == current.end()) {
+                    stats.removed_files++;
+                }
+            }
+
+            writeManifest(snapshot_dir / MANIFEST_NAME, current);
+
+            std::cout << "增量备份完成: " << snapshot_name
+                      << " (共 " << stats.total_files << " 个文件, 变化 " << stats.changed_files
+                      << ", 未变化 " << stats.unchanged_files << ", 删除 " << stats.removed_files
+                      << ", 跳过 " << stats.skipped_files << ", 复制 " << stats.bytes_copied << " 字节)" << std::endl;
+
+        } catch (const std::exception& e) {
+            std::cerr << "增量备份错误: " << e.what() << std::endl;
+            // 未写出清单的快照目录不完整，删除以免残留
+            if (!snapshot_dir.empty()) {
+                std::error_code ec;
+                fs::remove_all(snapshot_dir, ec);
+            }
+            throw;
+        }
+
+        return stats;
+    }
+
+    // 从快照还原（按清单从各条目引用的快照中读取数据）
+    static void restoreSnapshot(const std::string& backup_path, const std::string& snapshot_name,
+                                const std::string& dst_path) {
+        fs::path backup_root = fs::path(backup_path);
+        fs::path dst_root = fs::path(dst_path);
+
+        try {
+            std::string name = snapshot_name.empty() ? findLatestSnapshot(backup_root) : snapshot_name;
+            if (name.empty()) {
+                throw std::runtime_error("没有可用的快照: " + backup_root.string());
+            }
+
+            Manifest manifest = readManifest(backup_root / name / MANIFEST_NAME);
+            std::cout << "正在还原快照: " << name << " -> " << dst_root.string() << std::endl;
+
+            for (const auto& [path, entry] : manifest) {
+                fs::path source = backup_root / entry.snapshot / DATA_DIR / entry.path;
+                fs::path target = dst_root / entry.path;
+                fs::create_directories(target.parent_path());
+                fs::copy_file(source, target, fs::copy_options::overwrite_existing);
+            }
+
+            std::cout << "还原完成: " << manifest.size() << " 个文件" << std::endl;
+
+        } catch (const std::exception& e) {
+            std::cerr << "还原错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+};
+
+// 使用示例
+int main() {
+    std::string source_path = "./";
+    std::string backup_path = "../backup";
+
+    try {
+        std::cout << "=== 增量备份测试 ===\n";
+        IncrementalBackup::backupIncremental(source_path, backup_path);
+
+    } catch (const std::exception& e) {
+        std::cerr << "程序出错: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
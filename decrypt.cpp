@@ -9,6 +9,15 @@
 #include <openssl/evp.h>
 #include <iomanip>
 #include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <cstdint>
+#include <thread>
+
+// 按文件描述符流式读写
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -34,35 +43,197 @@ private:
         }
     }
 
-    // 读取文件内容到vector
-    static std::vector<unsigned char> readFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::binary | std::ios::ate);
-        if (!file) {
-            throw std::runtime_error("无法打开文件: " + filename);
+    // 流式解密的读写缓冲区大小，两块缓冲区在整个文件上复用
+    static constexpr size_t STREAM_BUFFER_SIZE = 1024 * 1024;
+
+    static void writeFully(int fd, const unsigned char* data, size_t length) {
+        while (length > 0) {
+            ssize_t n = write(fd, data, length);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                throw std::runtime_error("写入文件失败: " + std::string(strerror(errno)));
+            }
+            data += n;
+            length -= static_cast<size_t>(n);
         }
-        
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        
-        std::vector<unsigned char> buffer(size);
-        if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
-            throw std::runtime_error("读取文件失败: " + filename);
+    }
+
+    // 流式解密：按固定大小的缓冲区循环读取、EVP_DecryptUpdate、写出，内存占用与文件大小无关。
+    // 加密端在数据末尾先补一层PKCS7再由EVP补一层：外层由EVP_DecryptFinal_ex校验去除，
+    // 内层在最后一个分组中，因此始终扣留最近解出的一个分组，到结尾再去掉
+    static void decryptStream(const EVP_CIPHER* cipher, const std::string& key, const std::string& iv,
+                              const std::string& input_path, const std::string& output_path,
+                              const char* algorithm) {
+        int in_fd = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in_fd < 0) {
+            throw std::runtime_error("无法打开文件: " + input_path);
+        }
+        posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        int out_fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out_fd < 0) {
+            close(in_fd);
+            throw std::runtime_error("无法创建文件: " + output_path);
+        }
+
+        std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+        try {
+            if (!ctx) {
+                throw std::runtime_error("无法创建EVP上下文");
+            }
+            if (EVP_DecryptInit_ex(ctx.get(), cipher, NULL,
+                                 reinterpret_cast<const unsigned char*>(key.c_str()),
+                                 reinterpret_cast<const unsigned char*>(iv.c_str())) != 1) {
+                throw std::runtime_error(std::string(algorithm) + "解密初始化失败");
+            }
+
+            size_t block_size = static_cast<size_t>(EVP_CIPHER_block_size(cipher));
+            std::vector<unsigned char> input(STREAM_BUFFER_SIZE);
+            // 开头是上一轮扣留的分组
+            std::vector<unsigned char> output(block_size + STREAM_BUFFER_SIZE + 2 * EVP_MAX_BLOCK_LENGTH);
+            size_t held = 0;
+            int out_len = 0;
+
+            auto emit = [&](size_t produced) {
+                size_t available = held + produced;
+                size_t keep = std::min(available, block_size);
+                writeFully(out_fd, output.data(), available - keep);
+                memmove(output.data(), output.data() + available - keep, keep);
+                held = keep;
+            };
+
+            while (true) {
+                ssize_t n = read(in_fd, input.data(), input.size());
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) {
+                    throw std::runtime_error("读取文件失败: " + input_path);
+                }
+                if (n == 0) break;
+                if (EVP_DecryptUpdate(ctx.get(), output.data() + held, &out_len,
+                                    input.data(), static_cast<int>(n)) != 1) {
+                    throw std::runtime_error(std::string(algorithm) + "解密更新失败");
+                }
+                emit(static_cast<size_t>(out_len));
+            }
+
+            if (EVP_DecryptFinal_ex(ctx.get(), output.data() + held, &out_len) != 1) {
+                throw std::runtime_error(std::string(algorithm) + "解密结束失败");
+            }
+            size_t tail = held + static_cast<size_t>(out_len);
+
+            // 去除内层PKCS7填充（填充无效时原样保留）
+            if (tail > 0) {
+                size_t pad = output[tail - 1];
+                bool valid = pad > 0 && pad <= block_size && pad <= tail;
+                for (size_t i = tail - (valid ? pad : 0); valid && i < tail; i++) {
+                    valid = output[i] == pad;
+                }
+                if (valid) {
+                    tail -= pad;
+                }
+            }
+            writeFully(out_fd, output.data(), tail);
+
+            close(in_fd);
+            in_fd = -1;
+            if (close(out_fd) != 0) {
+                out_fd = -1;
+                throw std::runtime_error("写入文件失败: " + output_path);
+            }
+        } catch (...) {
+            if (in_fd >= 0) close(in_fd);
+            if (out_fd >= 0) close(out_fd);
+            unlink(output_path.c_str());
+            throw;
+        }
+    }
+
+    // 自描述的加密容器格式，见encrypt.cpp：
+    //   头部  "ENCF" | u8 版本 | u8 算法 | u8 密钥派生算法 | u8 保留 | u32 迭代次数 | u32 分块大小
+    //         | 16字节盐 | 12字节文件随机数 | 4字节保留（共48字节）
+    //   分块  密文 | 16字节认证标签（短于整块的记录是最后一块）
+    static constexpr char CONTAINER_MAGIC[5] = "ENCF";
+    static constexpr unsigned char CONTAINER_VERSION = 1;
+    static constexpr unsigned char ALGORITHM_AES_256_GCM = 1;
+    static constexpr unsigned char KDF_PBKDF2_SHA256 = 1;
+    static constexpr uint32_t MAX_KDF_ITERATIONS = 10000000;
+    static constexpr size_t CONTAINER_HEADER_SIZE = 48;
+    static constexpr size_t SALT_OFFSET = 16;
+    static constexpr size_t SALT_SIZE = 16;
+    static constexpr size_t NONCE_OFFSET = 32;
+    static constexpr size_t GCM_NONCE_SIZE = 12;
+    static constexpr size_t GCM_TAG_SIZE = 16;
+    static constexpr size_t GCM_MIN_CHUNK = 4 * 1024;
+    static constexpr size_t GCM_MAX_CHUNK = 64 * 1024 * 1024;
+    // 一轮并行解密的缓冲总量上限：分块大小来自尚未认证的头部，不能按它乘线程数分配
+    static constexpr size_t GCM_BATCH_BUDGET = 64 * 1024 * 1024;
+
+    struct GcmChunk {
+        std::vector<unsigned char> data;
+        size_t length = 0;
+        uint64_t index = 0;
+        bool final = false;
+        bool ok = false;
+    };
+
+    static uint32_t getLE32(const unsigned char* p) {
+        return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+               static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+    // 由口令和盐派生256位密钥（与加密端相同）
+    static std::vector<unsigned char> deriveContainerKey(const std::string& key, const unsigned char* salt,
+                                                         uint32_t iterations) {
+        std::vector<unsigned char> derived(32);
+        if (PKCS5_PBKDF2_HMAC(key.data(), static_cast<int>(key.size()), salt, static_cast<int>(SALT_SIZE),
+                              static_cast<int>(iterations), EVP_sha256(),
+                              static_cast<int>(derived.size()), derived.data()) != 1) {
+            throw std::runtime_error("密钥派生失败");
+        }
+        return derived;
+    }
+
+    static void chunkNonce(const unsigned char* file_nonce, uint64_t index, unsigned char* nonce) {
+        memcpy(nonce, file_nonce, GCM_NONCE_SIZE);
+        for (int i = 0; i < 8; i++) {
+            nonce[GCM_NONCE_SIZE - 1 - i] ^= static_cast<unsigned char>(index >> (8 * i));
         }
-        
-        return buffer;
     }
 
-    // 写入数据到文件
-    static void writeFile(const std::string& filename, const std::vector<unsigned char>& data) {
-        std::ofstream file(filename, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("无法创建文件: " + filename);
+    // 原地解密一个分块（data末尾是标签）；标签不符时返回false
+    static bool openChunk(EVP_CIPHER_CTX* ctx, const std::vector<unsigned char>& key,
+                          const unsigned char* header, GcmChunk& chunk) {
+        unsigned char nonce[GCM_NONCE_SIZE];
+        chunkNonce(header + NONCE_OFFSET, chunk.index, nonce);
+        unsigned char final_flag = chunk.final ? 1 : 0;
+        unsigned char* tag = chunk.data.data() + chunk.length;
+        int len = 0;
+        return EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, key.data(), nonce) == 1 &&
+               EVP_DecryptUpdate(ctx, NULL, &len, header, static_cast<int>(CONTAINER_HEADER_SIZE)) == 1 &&
+               EVP_DecryptUpdate(ctx, NULL, &len, &final_flag, 1) == 1 &&
+               (chunk.length == 0 ||
+                EVP_DecryptUpdate(ctx, chunk.data.data(), &len, chunk.data.data(), static_cast<int>(chunk.length)) == 1) &&
+               EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_SIZE, tag) == 1 &&
+               EVP_DecryptFinal_ex(ctx, chunk.data.data() + chunk.length, &len) > 0;
+    }
+
+    // 读满缓冲区，只有到达文件末尾时才少于length
+    static size_t readFully(int fd, unsigned char* data, size_t length) {
+        size_t total = 0;
+        while (total < length) {
+            ssize_t n = read(fd, data + total, length - total);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                throw std::runtime_error("读取文件失败: " + std::string(strerror(errno)));
+            }
+            if (n == 0) break;
+            total += static_cast<size_t>(n);
         }
-        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        return total;
     }
 
 public:
-    // 3DES解密
+    // 3DES解密（旧格式：密钥取自文件名，IV取自文件时间，文件被复制或解包后无法解密；
+    // 新格式请使用decryptGCM）
     static void decrypt3DES(const std::string& file_path, const std::string& file_name, const std::string& dst_path) {
         try {
             // 从文件名提取密钥
@@ -75,38 +246,12 @@ public:
             std::string full_path = file_path + file_name;
             std::string iv = getFileTimeString(full_path);
             
-            // 读取加密文件
-            auto encrypted_data = readFile(full_path);
-            
-            // 3DES解密
-            DES_cblock key1, key2, key3, iv_block;
-            DES_key_schedule ks1, ks2, ks3;
-            
-            // 将密钥分成三部分
-            memcpy(key1, key.c_str(), 8);
-            memcpy(key2, key.c_str() + 4, 8);
-            memcpy(key3, key.c_str() + 8, 8);
-            memcpy(iv_block, iv.c_str(), 8);
-            
-            DES_set_key_unchecked(&key1, &ks1);
-            DES_set_key_unchecked(&key2, &ks2);
-            DES_set_key_unchecked(&key3, &ks3);
-            
-            std::vector<unsigned char> decrypted_data(encrypted_data.size());
-            int final_length = 0;
+            // 3DES三个子密钥分别取密钥的第1-8、5-12、9-16字节
+            std::string triple_key = key.substr(0, 8) + key.substr(4, 8) + key.substr(8, 8);
             
-            DES_ede3_cbc_encrypt(encrypted_data.data(), decrypted_data.data(), 
-                               encrypted_data.size(), &ks1, &ks2, &ks3, &iv_block, DES_DECRYPT);
-            
-            // 处理PKCS5/7填充
-            size_t pad_length = decrypted_data.back();
-            if (pad_length > 0 && pad_length <= 8) {
-                decrypted_data.resize(decrypted_data.size() - pad_length);
-            }
-            
-            // 写入解密文件
+            // 流式解密写入
             std::string output_filename = file_name.length() >= 22 ? file_name.substr(22) : file_name;
-            writeFile(dst_path + output_filename, decrypted_data);
+            decryptStream(EVP_des_ede3_cbc(), triple_key, iv.substr(0, 8), full_path, dst_path + output_filename, "3DES");
             
             std::cout << "3DES解密完成: " << output_filename << std::endl;
             
@@ -116,7 +261,7 @@ public:
         }
     }
 
-    // AES解密
+    // AES解密（旧格式，同上）
     static void decryptAES(const std::string& file_path, const std::string& file_name, const std::string& dst_path) {
         try {
             // 从文件名提取密钥
@@ -130,48 +275,158 @@ public:
             std::string time_str = getFileTimeString(full_path);
             std::string iv = key.substr(4, 8) + time_str;
             
-            // 读取加密文件
-            auto encrypted_data = readFile(full_path);
+            // 流式解密写入
+            std::string output_filename = file_name.length() >= 21 ? file_name.substr(21) : file_name;
+            decryptStream(EVP_aes_128_cbc(), key, iv, full_path, dst_path + output_filename, "AES");
             
-            // AES解密
-            EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-            if (!ctx) {
+            std::cout << "AES解密完成: " << output_filename << std::endl;
+            
+        } catch (const std::exception& e) {
+            std::cerr << "AES解密错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+    // 从in_fd读入容器格式，把明文写到out_fd，两端都可以是管道，出错时抛出异常。
+    // 所需参数全部取自头部；每轮读入thread_count*4个分块并行解密，整轮都通过认证后才写出。
+    // 直接写管道时，已写出的都是通过认证的明文，截断只能在读到末尾时发现。返回分块数
+    static uint64_t decryptContainer(int in_fd, int out_fd, const std::string& key, unsigned thread_count = 0) {
+        if (thread_count == 0) {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        unsigned char header[CONTAINER_HEADER_SIZE];
+        if (readFully(in_fd, header, CONTAINER_HEADER_SIZE) != CONTAINER_HEADER_SIZE ||
+            memcmp(header, CONTAINER_MAGIC, 4) != 0) {
+            throw std::runtime_error("不是加密容器文件");
+        }
+        if (header[4] != CONTAINER_VERSION) {
+            throw std::runtime_error("不支持的容器版本: " + std::to_string(header[4]));
+        }
+        if (header[5] != ALGORITHM_AES_256_GCM || header[6] != KDF_PBKDF2_SHA256) {
+            throw std::runtime_error("不支持的加密算法");
+        }
+        uint32_t iterations = getLE32(header + 8);
+        size_t chunk_size = getLE32(header + 12);
+        if (iterations == 0 || iterations > MAX_KDF_ITERATIONS) {
+            throw std::runtime_error("密钥派生迭代次数无效");
+        }
+        if (chunk_size < GCM_MIN_CHUNK || chunk_size > GCM_MAX_CHUNK) {
+            throw std::runtime_error("分块大小无效");
+        }
+        std::vector<unsigned char> gcm_key = deriveContainerKey(key, header + SALT_OFFSET, iterations);
+
+        std::vector<std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)>> contexts;
+        for (unsigned t = 0; t < thread_count; t++) {
+            contexts.emplace_back(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+            if (!contexts.back()) {
                 throw std::runtime_error("无法创建EVP上下文");
             }
-            
-            if (EVP_DecryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, 
-                                 reinterpret_cast<const unsigned char*>(key.c_str()),
-                                 reinterpret_cast<const unsigned char*>(iv.c_str())) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("AES解密初始化失败");
+        }
+        // 每轮的分块数受缓冲总量限制，缓冲在第一次用到时才分配（短文件只分配一块）
+        const size_t record_size = chunk_size + GCM_TAG_SIZE;
+        size_t batch_count = std::min<size_t>(thread_count * 4, std::max<size_t>(1, GCM_BATCH_BUDGET / record_size));
+        std::vector<GcmChunk> batch(batch_count);
+
+        uint64_t next_index = 0;
+        bool finished = false;
+        while (!finished) {
+            size_t count = 0;
+            while (count < batch.size() && !finished) {
+                GcmChunk& chunk = batch[count++];
+                if (chunk.data.empty()) {
+                    chunk.data.resize(record_size + EVP_MAX_BLOCK_LENGTH);
+                }
+                size_t n = readFully(in_fd, chunk.data.data(), record_size);
+                if (n < GCM_TAG_SIZE) {
+                    throw std::runtime_error("加密文件已截断");
+                }
+                chunk.length = n - GCM_TAG_SIZE;
+                chunk.index = next_index++;
+                chunk.final = n < record_size;
+                finished = chunk.final;
             }
-            
-            std::vector<unsigned char> decrypted_data(encrypted_data.size() + AES_BLOCK_SIZE);
-            int out_len1 = 0, out_len2 = 0;
-            
-            if (EVP_DecryptUpdate(ctx, decrypted_data.data(), &out_len1,
-                                encrypted_data.data(), encrypted_data.size()) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("AES解密更新失败");
+            if (finished) {
+                unsigned char extra;
+                if (readFully(in_fd, &extra, 1) != 0) {
+                    throw std::runtime_error("最后一块之后有多余数据");
+                }
             }
-            
-            if (EVP_DecryptFinal_ex(ctx, decrypted_data.data() + out_len1, &out_len2) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("AES解密结束失败");
+
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < thread_count && t < count; t++) {
+                workers.emplace_back([&, t]() {
+                    for (size_t i = t; i < count; i += thread_count) {
+                        batch[i].ok = openChunk(contexts[t].get(), gcm_key, header, batch[i]);
+                    }
+                });
             }
-            
-            EVP_CIPHER_CTX_free(ctx);
-            
-            decrypted_data.resize(out_len1 + out_len2);
-            
-            // 写入解密文件
-            std::string output_filename = file_name.length() >= 21 ? file_name.substr(21) : file_name;
-            writeFile(dst_path + output_filename, decrypted_data);
-            
-            std::cout << "AES解密完成: " << output_filename << std::endl;
-            
+            for (auto& worker : workers) {
+                worker.join();
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                if (!batch[i].ok) {
+                    throw std::runtime_error("第 " + std::to_string(batch[i].index) + " 块认证失败，数据已损坏或密钥错误");
+                }
+            }
+            for (size_t i = 0; i < count; i++) {
+                writeFully(out_fd, batch[i].data.data(), batch[i].length);
+            }
+        }
+        return next_index;
+    }
+
+    // 分块AES-256-GCM解密文件，不依赖文件名和文件时间，任何副本都能解密。
+    // 明文先写入临时文件，全部分块通过认证（且最后一块完整）后才改名为最终文件，
+    // 任何一块被篡改或文件被截断时不留下任何明文
+    static void decryptGCM(const std::string& file_path, const std::string& file_name,
+                           const std::string& key, const std::string& dst_path, unsigned thread_count = 0) {
+        std::string full_path = file_path + file_name;
+        std::string output_filename = file_name;
+        if (output_filename.size() > 4 && output_filename.compare(output_filename.size() - 4, 4, ".gcm") == 0) {
+            output_filename.resize(output_filename.size() - 4);
+        }
+        std::string output_path = dst_path + output_filename;
+        std::string temp_path = output_path + ".part";
+        int in_fd = -1, out_fd = -1;
+
+        try {
+            if (thread_count == 0) {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            in_fd = open(full_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in_fd < 0) {
+                throw std::runtime_error("无法打开文件: " + full_path);
+            }
+            posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            out_fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (out_fd < 0) {
+                throw std::runtime_error("无法创建文件: " + temp_path);
+            }
+
+            uint64_t chunks = decryptContainer(in_fd, out_fd, key, thread_count);
+
+            close(in_fd);
+            in_fd = -1;
+            int fd = out_fd;
+            out_fd = -1;
+            if (close(fd) != 0 || rename(temp_path.c_str(), output_path.c_str()) != 0) {
+                unlink(temp_path.c_str());
+                throw std::runtime_error("写入文件失败: " + output_path);
+            }
+
+            std::cout << "GCM解密完成: " << output_filename << " (" << chunks << " 个分块, "
+                      << thread_count << " 线程)" << std::endl;
+
         } catch (const std::exception& e) {
-            std::cerr << "AES解密错误: " << e.what() << std::endl;
+            if (in_fd >= 0) close(in_fd);
+            if (out_fd >= 0) {
+                close(out_fd);
+                unlink(temp_path.c_str());
+            }
+            std::cerr << "GCM解密错误: " << e.what() << std::endl;
             throw;
         }
     }
@@ -190,6 +445,9 @@ int main() {
         // 假设有加密文件
         // FileDecryptor::decrypt3DES(file_path, "des_key123456789012_filename.txt", dst_path);
         // FileDecryptor::decryptAES(file_path, "aes_key1234567890123_filename.txt", dst_path);
+        // FileDecryptor::decryptGCM(file_path, "filename.txt.gcm", "MySecretKey12345", dst_path);
+        // 也可以在管道中使用，例如 ./decrypt < dir.tar.gcm | tar x
+        // FileDecryptor::decryptContainer(STDIN_FILENO, STDOUT_FILENO, "MySecretKey12345");
         
         std::cout << "解密功能就绪" << std::endl;
         
@@ -0,0 +1,521 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+#include <stdexcept>
+#include <chrono>
+#include <iomanip>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// 第三方库头文件
+#include <lzma.h>
+#include <openssl/evp.h>
+
+namespace fs = std::filesystem;
+
+// 基于FastCDC的内容定义分块器
+class FastCDCChunker {
+public:
+    static constexpr size_t MIN_SIZE = 16 * 1024;
+    static constexpr size_t AVG_SIZE = 64 * 1024;
+    static constexpr size_t MAX_SIZE = 256 * 1024;
+
+    // 在data[0, size)中查找下一个切分点，返回块长度
+    static size_t findCut(const uint8_t* data, size_t size) {
+        if (size <= MIN_SIZE) {
+            return size;
+        }
+        size_t limit = std::min(size, MAX_SIZE);
+        size_t normal = std::min(limit, AVG_SIZE);
+
+        const uint64_t* gear = gearTable();
+        uint64_t fp = 0;
+        size_t i = MIN_SIZE;
+
+        // 归一化分块：平均长度之前使用更严格的掩码，之后使用更宽松的掩码
+        for (; i < normal; i++) {
+            fp = (fp << 1) + gear[data[i]];
+            if ((fp & MASK_S) == 0) return i + 1;
+        }
+        for (; i < limit; i++) {
+            fp = (fp << 1) + gear[data[i]];
+            if ((fp & MASK_L) == 0) return i + 1;
+        }
+        return limit;
+    }
+
+private:
+    // 掩码位数：AVG_SIZE = 2^16，前段多2位，后段少2位
+    static constexpr uint64_t MASK_S = 0x924a494929250000ULL;  // 18位
+    static constexpr uint64_t MASK_L = 0x8891122444890000ULL;  // 14位
+
+    // Gear表（固定种子生成，保证不同运行间切分点稳定）
+    static const uint64_t* gearTable() {
+        static uint64_t table[256] = {};
+        static bool initialized = false;
+        if (!initialized) {
+            uint64_t state = 0x9E3779B97F4A7C15ULL;
+            for (auto& value : table) {
+                state += 0x9E3779B97F4A7C15ULL;
+                uint64_t z = state;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                value = z ^ (z >> 31);
+            }
+            initialized = true;
+        }
+        return table;
+    }
+};
+
+class DedupRepository {
+public:
+    // 块在包文件中的位置
+    struct ChunkLocation {
+        uint32_t pack = 0;
+        uint64_t offset = 0;
+        uint32_t stored_size = 0;
+        uint32_t raw_size = 0;
+        uint8_t codec = 0;
+    };
+
+    // 快照中的文件：路径、大小和按顺序排列的块引用
+    struct FileRecord {
+        std::string path;
+        uint64_t size = 0;
+        std::vector<std::string> chunks;
+    };
+
+    struct BackupStats {
+        size_t files = 0;
+        size_t chunks = 0;
+        size_t new_chunks = 0;
+        size_t skipped_files = 0;
+        uint64_t bytes_read = 0;
+        uint64_t bytes_written = 0;
+    };
+
+    // 块编码方式
+    static constexpr uint8_t CODEC_STORE = 0;
+    static constexpr uint8_t CODEC_XZ = 1;
+
+private:
+    // 包文件目标大小（64MB）
+    static constexpr uint64_t PACK_TARGET_SIZE = 64ULL * 1024 * 1024;
+    // 读取缓冲区大小（4MB）
+    static constexpr size_t BUFFER_SIZE = 4 * 1024 * 1024;
+
+    fs::path repo_root;
+    std::unordered_map<std::string, ChunkLocation> index;
+    std::vector<std::pair<std::string, ChunkLocation>> pending_index;
+    std::ofstream pack_file;
+    uint32_t pack_id = 0;
+    uint64_t pack_size = 0;
+
+    // 快照中路径以制表符和换行分隔，这两个字符以及%按百分号编码（与backup.cpp的清单相同）
+    static std::string escapeField(const std::string& value) {
+        std::string result;
+        for (char c : value) {
+            if (c == '%') result += "%25";
+            else if (c == '\t') result += "%09";
+            else if (c == '\n') result += "%0A";
+            else result += c;
+        }
+        return result;
+    }
+
+    static std::string unescapeField(const std::string& value) {
+        std::string result;
+        for (size_t i = 0; i < value.size(); i++) {
+            if (value[i] == '%' && i + 2 < value.size()) {
+                result += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else {
+                result += value[i];
+            }
+        }
+        return result;
+    }
+
+    static std::string sha256Hex(const uint8_t* data, size_t size) {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digest_len = 0;
+        if (EVP_Digest(data, size, digest, &digest_len, EVP_sha256(), nullptr) != 1) {
+            throw std::runtime_error("SHA-256计算失败");
+        }
+
+        std::stringstream ss;
+        ss << std::hex << std::setfill('0');
+        for (unsigned int i = 0; i < digest_len; i++) {
+            ss << std::setw(2) << static_cast<int>(digest[i]);
+        }
+        return ss.str();
+    }
+
+    fs::path packPath(uint32_t id) const {
+        std::stringstream ss;
+        ss << std::setw(8) << std::setfill('0') << id << ".pack";
+        return repo_root / "packs" / ss.str();
+    }
+
+    void loadIndex() {
+        std::ifstream file(repo_root / "index.txt");
+        std::string line;
+        while (std::getline(file, line)) {
+            std::stringstream ss(line);
+            std::string hash;
+            ChunkLocation loc;
+            unsigned int codec = 0;
+            if (ss >> hash >> loc.pack >> loc.offset >> loc.stored_size >> loc.raw_size >> codec) {
+                loc.codec = static_cast<uint8_t>(codec);
+                index[hash] = loc;
+                pack_id = std::max(pack_id, loc.pack + 1);
+            }
+        }
+    }
+
+    // 打开新的包文件
+    void openPack() {
+        fs::path path = packPath(pack_id);
+        pack_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!pack_file.is_open()) {
+            throw std::runtime_error("无法创建包文件: " + path.string());
+        }
+        pack_size = 0;
+    }
+
+    // 关闭当前包文件并把其中的块追加到索引（包数据先落盘，索引后写）
+    void closePack() {
+        if (!pack_file.is_open()) {
+            return;
+        }
+        pack_file.close();
+        if (!pack_file) {
+            throw std::runtime_error("写入包文件失败: " + packPath(pack_id).string());
+        }
+
+        std::ofstream index_file(repo_root / "index.txt", std::ios::app);
+        for (const auto& [hash, loc] : pending_index) {
+            index_file << hash << ' ' << loc.pack << ' ' << loc.offset << ' ' << loc.stored_size
+                       << ' ' << loc.raw_size << ' ' << static_cast<unsigned int>(loc.codec) << '\n';
+        }
+        if (!index_file) {
+            throw std::runtime_error("写入索引失败");
+        }
+        pending_index.clear();
+        pack_id++;
+    }
+
+    // 压缩并写入一个新块；压缩无收益时按原样存储
+    ChunkLocation storeChunk(const uint8_t* data, size_t size) {
+        if (!pack_file.is_open()) {
+            openPack();
+        }
+
+        std::vector<uint8_t> compressed(lzma_stream_buffer_bound(size));
+        size_t out_pos = 0;
+        lzma_ret ret = lzma_easy_buffer_encode(LZMA_PRESET_DEFAULT, LZMA_CHECK_CRC32, nullptr,
+                                               data, size, compressed.data(), &out_pos, compressed.size());
+
+        ChunkLocation loc;
+        loc.pack = pack_id;
+        loc.offset = pack_size;
+        loc.raw_size = static_cast<uint32_t>(size);
+
+        if (ret == LZMA_OK && out_pos < size) {
+            loc.codec = CODEC_XZ;
+            loc.stored_size = static_cast<uint32_t>(out_pos);
+            pack_file.write(reinterpret_cast<const char*>(compressed.data()), out_pos);
+        } else {
+            loc.codec = CODEC_STORE;
+            loc.stored_size = static_cast<uint32_t>(size);
+            pack_file.write(reinterpret_cast<const char*>(data), size);
+        }
+
+        pack_size += loc.stored_size;
+        if (pack_size >= PACK_TARGET_SIZE) {
+            closePack();
+        }
+        return loc;
+    }
+
+    // 读取并解码一个块
+    std::vector<uint8_t> loadChunk(const ChunkLocation& loc, std::map<uint32_t, std::ifstream>& packs) const {
+        auto it = packs.find(loc.pack);
+        if (it == packs.end()) {
+            it = packs.emplace(loc.pack, std::ifstream(packPath(loc.pack), std::ios::binary)).first;
+            if (!it->second.is_open()) {
+                throw std::runtime_error("无法打开包文件: " + packPath(loc.pack).string());
+            }
+        }
+
+        std::vector<uint8_t> stored(loc.stored_size);
+        it->second.seekg(static_cast<std::streamoff>(loc.offset));
+        if (!it->second.read(reinterpret_cast<char*>(stored.data()), stored.size())) {
+            throw std::runtime_error("读取包文件失败: " + packPath(loc.pack).string());
+        }
+        if (loc.codec == CODEC_STORE) {
+            return stored;
+        }
+
+        std::vector<uint8_t> raw(loc.raw_size);
+        uint64_t memlimit = UINT64_MAX;
+        size_t in_pos = 0, out_pos = 0;
+        lzma_ret ret = lzma_stream_buffer_decode(&memlimit, 0, nullptr, stored.data(), &in_pos, stored.size(),
+                                                 raw.data(), &out_pos, raw.size());
+        if (ret != LZMA_OK || out_pos != raw.size()) {
+            throw std::runtime_error("块解压失败，错误代码: " + std::to_string(ret));
+        }
+        return raw;
+    }
+
+    // 对单个文件分块并写入新块；文件无法读取时警告并返回false（包写入失败仍抛出异常）
+    bool backupFile(const fs::path& filepath, const std::string& relative_path, FileRecord& record,
+                    BackupStats& stats) {
+        std::ifstream input(filepath, std::ios::binary);
+        if (!input.is_open()) {
+            std::cerr << "警告: 无法打开文件，跳过: " << filepath.string() << std::endl;
+            return false;
+        }
+
+        record.path = relative_path;
+
+        std::vector<uint8_t> buffer(BUFFER_SIZE);
+        size_t begin = 0, end = 0;
+        bool eof = false;
+
+        while (true) {
+            // 保证缓冲区中至少有一个最大块的数据（文件末尾除外）
+            if (!eof && end - begin < FastCDCChunker::MAX_SIZE) {
+                std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+                input.read(reinterpret_cast<char*>(buffer.data() + end), buffer.size() - end);
+                if (input.bad()) {
+                    std::cerr << "警告: 读取文件失败，跳过: " << filepath.string() << std::endl;
+                    return false;
+                }
+                end += static_cast<size_t>(input.gcount());
+                eof = input.eof();
+            }
+            if (begin == end) {
+                break;
+            }
+
+            size_t cut = FastCDCChunker::findCut(buffer.data() + begin, end - begin);
+            std::string hash = sha256Hex(buffer.data() + begin, cut);
+
+            if (index.find(hash) == index.end()) {
+                ChunkLocation loc = storeChunk(buffer.data() + begin, cut);
+                index[hash] = loc;
+                pending_index.emplace_back(hash, loc);
+                stats.new_chunks++;
+                stats.bytes_written += loc.stored_size;
+            }
+
+            record.chunks.push_back(hash);
+            record.size += cut;
+            stats.chunks++;
+            stats.bytes_read += cut;
+            begin += cut;
+        }
+
+        stats.files++;
+        return true;
+    }
+
+    static std::string getSnapshotName() {
+        auto now = std::chrono::system_clock::now();
+        auto time_t_now = std::chrono::system_clock::to_time_t(now);
+        std::tm tm = *std::localtime(&time_t_now);
+
+        std::stringstream ss;
+        ss << std::put_time(&tm, "%Y%m%d%H%M%S");
+        return ss.str();
+    }
+
+public:
+    explicit DedupRepository(const std::string& path) : repo_root(path) {
+        fs::create_directories(repo_root / "packs");
+        fs::create_directories(repo_root / "snapshots");
+        loadIndex();
+    }
+
+    ~DedupRepository() {
+        try {
+            closePack();
+        } catch (...) {
+        }
+    }
+
+    // 备份目录：只写入索引中不存在的块，快照为块引用列表
+    BackupStats backup(const std::string& source_path) {
+        fs::path source_root = fs::path(source_path);
+        BackupStats stats;
+
+        try {
+            if (!fs::is_directory(source_root)) {
+                throw std::runtime_error("源目录不存在: " + source_root.string());
+            }
+
+            std::string snapshot_name = getSnapshotName();
+            std::cout << "正在去重备份: " << source_root.string() << " -> " << repo_root.string()
+                      << " (快照 " << snapshot_name << ")" << std::endl;
+
+            // 单个文件无法读取时跳过，不中断整个备份（已写入的块留在包中，不影响一致性）；
+            // 无权限读取的目录同样跳过
+            std::vector<FileRecord> records;
+            auto options = fs::directory_options::skip_permission_denied;
+            for (const auto& entry : fs::recursive_directory_iterator(source_root, options)) {
+                if (!entry.is_regular_file() || entry.is_symlink()) {
+                    continue;
+                }
+                std::string relative_path = fs::relative(entry.path(), source_root).generic_string();
+                FileRecord record;
+                if (backupFile(entry.path(), relative_path, record, stats)) {
+                    records.push_back(std::move(record));
+                } else {
+                    stats.skipped_files++;
+                }
+            }
+
+            // 包数据和索引落盘后再写快照，快照引用的块一定可读
+            closePack();
+
+            // 先写临时文件再改名，写入不完整时不会留下看似有效的快照
+            fs::path snapshot_path = repo_root / "snapshots" / (snapshot_name + ".txt");
+            fs::path tmp_path = snapshot_path.string() + ".tmp";
+            {
+                std::ofstream snapshot(tmp_path);
+                if (!snapshot.is_open()) {
+                    throw std::runtime_error("无法创建快照: " + tmp_path.string());
+                }
+                for (const auto& record : records) {
+                    snapshot << escapeField(record.path) << '\t' << record.size << '\t';
+                    for (size_t i = 0; i < record.chunks.size(); i++) {
+                        if (i > 0) snapshot << ',';
+                        snapshot << record.chunks[i];
+                    }
+                    snapshot << '\n';
+                }
+                snapshot.close();
+                if (!snapshot) {
+                    fs::remove(tmp_path);
+                    throw std::runtime_error("写入快照失败: " + tmp_path.string());
+                }
+            }
+            fs::rename(tmp_path, snapshot_path);
+
+            std::cout << "去重备份完成: " << stats.files << " 个文件, " << stats.chunks << " 个块 (新增 "
+                      << stats.new_chunks << "), 读取 " << stats.bytes_read << " 字节, 写入 "
+                      << stats.bytes_written << " 字节";
+            if (stats.skipped_files > 0) {
+                std::cout << ", 跳过 " << stats.skipped_files << " 个文件";
+            }
+            std::cout << std::endl;
+
+        } catch (const std::exception& e) {
+            std::cerr << "去重备份错误: " << e.what() << std::endl;
+            throw;
+        }
+
+        return stats;
+    }
+
+    // 读取快照
+    std::vector<FileRecord> readSnapshot(const std::string& snapshot_name) const {
+        fs::path snapshot_path = repo_root / "snapshots" / (snapshot_name + ".txt");
+        std::ifstream file(snapshot_path);
+        if (!file.is_open()) {
+            throw std::runtime_error("无法打开快照: " + snapshot_path.string());
+        }
+
+        std::vector<FileRecord> records;
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t tab1 = line.find('\t');
+            size_t tab2 = line.find('\t', tab1 + 1);
+            if (tab1 == std::string::npos || tab2 == std::string::npos) {
+                throw std::runtime_error("快照格式错误: " + snapshot_path.string());
+            }
+
+            FileRecord record;
+            record.path = unescapeField(line.substr(0, tab1));
+            record.size = std::stoull(line.substr(tab1 + 1, tab2 - tab1 - 1));
+            std::stringstream chunks(line.substr(tab2 + 1));
+            std::string hash;
+            while (std::getline(chunks, hash, ',')) {
+                record.chunks.push_back(hash);
+            }
+            records.push_back(record);
+        }
+        return records;
+    }
+
+    // 从快照还原
+    void restore(const std::string& snapshot_name, const std::string& dst_path) const {
+        try {
+            std::cout << "正在还原快照: " << snapshot_name << " -> " << dst_path << std::endl;
+
+            std::map<uint32_t, std::ifstream> packs;
+            auto records = readSnapshot(snapshot_name);
+            for (const auto& record : records) {
+                fs::path target = fs::path(dst_path) / record.path;
+                fs::create_directories(target.parent_path());
+
+                std::ofstream output(target, std::ios::binary);
+                if (!output.is_open()) {
+                    throw std::runtime_error("无法创建文件: " + target.string());
+                }
+
+                for (const auto& hash : record.chunks) {
+                    auto it = index.find(hash);
+                    if (it == index.end()) {
+                        throw std::runtime_error("索引中缺少块: " + hash);
+                    }
+                    // 块以内容的SHA-256命名，还原时重新计算，包文件中的位翻转不会被当作正常数据写出
+                    auto data = loadChunk(it->second, packs);
+                    if (sha256Hex(data.data(), data.size()) != hash) {
+                        throw std::runtime_error("块校验失败（包文件可能已损坏）: " + hash + " (" + record.path + ")");
+                    }
+                    output.write(reinterpret_cast<const char*>(data.data()), data.size());
+                }
+                output.close();
+                if (!output) {
+                    throw std::runtime_error("写入文件失败: " + target.string());
+                }
+            }
+
+            std::cout << "还原完成: " << records.size() << " 个文件" << std::endl;
+
+        } catch (const std::exception& e) {
+            std::cerr << "还原错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+};
+
+// 使用示例
+int main() {
+    std::string source_path = "./";
+    std::string repo_path = "../dedup_repo";
+
+    try {
+        std::cout << "=== 去重备份测试 ===\n";
+        DedupRepository repo(repo_path);
+        repo.backup(source_path);
+
+    } catch (const std::exception& e) {
+        std::cerr << "程序出错: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -10,6 +10,14 @@
 #include <openssl/rand.h>
 #include <openssl/evp.h>
 #include <cstring>
+#include <cerrno>
+#include <memory>
+#include <cstdint>
+#include <thread>
+
+// 按文件描述符流式读写
+#include <fcntl.h>
+#include <unistd.h>
 
 class FileEncryptor {
 private:
@@ -28,47 +36,184 @@ private:
         return ss.str();
     }
     
-    // 读取文件内容到vector
-    static std::vector<unsigned char> readFile(const std::string& filepath) {
-        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
-        if (!file.is_open()) {
-            throw std::runtime_error("无法打开文件: " + filepath);
+    // 流式加密的读写缓冲区大小，两块缓冲区在整个文件上复用
+    static constexpr size_t STREAM_BUFFER_SIZE = 1024 * 1024;
+    
+    static void writeFully(int fd, const unsigned char* data, size_t length) {
+        while (length > 0) {
+            ssize_t n = write(fd, data, length);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                throw std::runtime_error("写入文件失败: " + std::string(strerror(errno)));
+            }
+            data += n;
+            length -= static_cast<size_t>(n);
         }
-        
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        
-        std::vector<unsigned char> buffer(size);
-        if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
-            throw std::runtime_error("读取文件失败: " + filepath);
+    }
+    
+    // 流式加密：按固定大小的缓冲区循环读取、EVP_EncryptUpdate、写出，内存占用与文件大小无关。
+    // 密文与原先整文件加密的结果逐字节相同：数据末尾先补一层PKCS7，再由EVP_EncryptFinal_ex补一层
+    static void encryptStream(const EVP_CIPHER* cipher, const std::string& key, const std::string& iv,
+                              const std::string& input_path, const std::string& output_path,
+                              const char* algorithm) {
+        int in_fd = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in_fd < 0) {
+            throw std::runtime_error("无法打开文件: " + input_path);
+        }
+        posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        int out_fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out_fd < 0) {
+            close(in_fd);
+            throw std::runtime_error("无法创建文件: " + output_path);
         }
         
-        return buffer;
+        std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+        try {
+            if (!ctx) {
+                throw std::runtime_error("无法创建EVP上下文");
+            }
+            if (EVP_EncryptInit_ex(ctx.get(), cipher, NULL,
+                                  reinterpret_cast<const unsigned char*>(key.c_str()),
+                                  reinterpret_cast<const unsigned char*>(iv.c_str())) != 1) {
+                throw std::runtime_error(std::string(algorithm) + "加密初始化失败");
+            }
+            
+            size_t block_size = static_cast<size_t>(EVP_CIPHER_block_size(cipher));
+            std::vector<unsigned char> input(STREAM_BUFFER_SIZE);
+            std::vector<unsigned char> output(STREAM_BUFFER_SIZE + 2 * EVP_MAX_BLOCK_LENGTH);
+            uint64_t total = 0;
+            int out_len = 0;
+            
+            while (true) {
+                ssize_t n = read(in_fd, input.data(), input.size());
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) {
+                    throw std::runtime_error("读取文件失败: " + input_path);
+                }
+                if (n == 0) break;
+                if (EVP_EncryptUpdate(ctx.get(), output.data(), &out_len, input.data(), static_cast<int>(n)) != 1) {
+                    throw std::runtime_error(std::string(algorithm) + "加密失败");
+                }
+                writeFully(out_fd, output.data(), static_cast<size_t>(out_len));
+                total += static_cast<uint64_t>(n);
+            }
+            
+            // PKCS7填充（只依赖总长度，不需要把数据留在内存里）
+            size_t padding = block_size - static_cast<size_t>(total % block_size);
+            std::vector<unsigned char> pad(padding, static_cast<unsigned char>(padding));
+            int tmp_len = 0;
+            if (EVP_EncryptUpdate(ctx.get(), output.data(), &out_len, pad.data(), static_cast<int>(pad.size())) != 1 ||
+                EVP_EncryptFinal_ex(ctx.get(), output.data() + out_len, &tmp_len) != 1) {
+                throw std::runtime_error(std::string(algorithm) + "加密完成失败");
+            }
+            writeFully(out_fd, output.data(), static_cast<size_t>(out_len + tmp_len));
+            
+            close(in_fd);
+            in_fd = -1;
+            if (close(out_fd) != 0) {
+                out_fd = -1;
+                throw std::runtime_error("写入文件失败: " + output_path);
+            }
+        } catch (...) {
+            if (in_fd >= 0) close(in_fd);
+            if (out_fd >= 0) close(out_fd);
+            unlink(output_path.c_str());
+            throw;
+        }
     }
     
-    // 写入文件
-    static void writeFile(const std::string& filepath, const std::vector<unsigned char>& data) {
-        std::ofstream file(filepath, std::ios::binary);
-        if (!file.is_open()) {
-            throw std::runtime_error("无法创建文件: " + filepath);
+    // 自描述的加密容器格式（整数均为小端），解密所需的参数都在头部里，与文件名和文件时间无关：
+    //   头部  "ENCF" | u8 版本 | u8 算法 | u8 密钥派生算法 | u8 保留 | u32 迭代次数 | u32 分块大小
+    //         | 16字节盐 | 12字节文件随机数 | 4字节保留（共48字节）
+    //   分块  密文（除最后一块外均为分块大小）| 16字节认证标签
+    // 算法1为AES-256-GCM，密钥由口令和盐经PBKDF2-HMAC-SHA256派生。第i块的nonce为文件随机数的后8字节与i（大端）异或；
+    // 整个头部和“是否最后一块”标志作为附加认证数据，因此头部被改动、分块被调换、截断或拼接都会导致认证失败。
+    // 明文长度恰为分块大小整数倍时末尾补一个空的最后一块
+    static constexpr char CONTAINER_MAGIC[5] = "ENCF";
+    static constexpr unsigned char CONTAINER_VERSION = 1;
+    static constexpr unsigned char ALGORITHM_AES_256_GCM = 1;
+    static constexpr unsigned char KDF_PBKDF2_SHA256 = 1;
+    static constexpr uint32_t KDF_ITERATIONS = 100000;
+    static constexpr size_t CONTAINER_HEADER_SIZE = 48;
+    static constexpr size_t SALT_OFFSET = 16;
+    static constexpr size_t SALT_SIZE = 16;
+    static constexpr size_t NONCE_OFFSET = 32;
+    static constexpr size_t GCM_CHUNK_SIZE = 1024 * 1024;
+    static constexpr size_t GCM_NONCE_SIZE = 12;
+    static constexpr size_t GCM_TAG_SIZE = 16;
+    
+    struct GcmChunk {
+        std::vector<unsigned char> data;
+        size_t length = 0;
+        uint64_t index = 0;
+        bool final = false;
+        unsigned char tag[GCM_TAG_SIZE];
+        bool ok = false;
+    };
+    
+    static void putLE32(unsigned char* p, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
         }
-        file.write(reinterpret_cast<const char*>(data.data()), data.size());
     }
     
-    // PKCS7填充
-    static void addPKCS7Padding(std::vector<unsigned char>& data, size_t block_size) {
-        size_t padding = block_size - (data.size() % block_size);
-        data.insert(data.end(), padding, static_cast<unsigned char>(padding));
+    // 由口令和盐派生256位密钥
+    static std::vector<unsigned char> deriveContainerKey(const std::string& key, const unsigned char* salt,
+                                                         uint32_t iterations) {
+        std::vector<unsigned char> derived(32);
+        if (PKCS5_PBKDF2_HMAC(key.data(), static_cast<int>(key.size()), salt, static_cast<int>(SALT_SIZE),
+                              static_cast<int>(iterations), EVP_sha256(),
+                              static_cast<int>(derived.size()), derived.data()) != 1) {
+            throw std::runtime_error("密钥派生失败");
+        }
+        return derived;
+    }
+    
+    static void chunkNonce(const unsigned char* file_nonce, uint64_t index, unsigned char* nonce) {
+        memcpy(nonce, file_nonce, GCM_NONCE_SIZE);
+        for (int i = 0; i < 8; i++) {
+            nonce[GCM_NONCE_SIZE - 1 - i] ^= static_cast<unsigned char>(index >> (8 * i));
+        }
+    }
+    
+    // 原地加密一个分块并生成标签
+    static bool sealChunk(EVP_CIPHER_CTX* ctx, const std::vector<unsigned char>& key,
+                          const unsigned char* header, GcmChunk& chunk) {
+        unsigned char nonce[GCM_NONCE_SIZE];
+        chunkNonce(header + NONCE_OFFSET, chunk.index, nonce);
+        unsigned char final_flag = chunk.final ? 1 : 0;
+        int len = 0;
+        return EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, key.data(), nonce) == 1 &&
+               EVP_EncryptUpdate(ctx, NULL, &len, header, static_cast<int>(CONTAINER_HEADER_SIZE)) == 1 &&
+               EVP_EncryptUpdate(ctx, NULL, &len, &final_flag, 1) == 1 &&
+               (chunk.length == 0 ||
+                EVP_EncryptUpdate(ctx, chunk.data.data(), &len, chunk.data.data(), static_cast<int>(chunk.length)) == 1) &&
+               EVP_EncryptFinal_ex(ctx, chunk.data.data() + chunk.length, &len) == 1 &&
+               EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_SIZE, chunk.tag) == 1;
+    }
+    
+    // 读满缓冲区，只有到达文件末尾时才少于length
+    static size_t readFully(int fd, unsigned char* data, size_t length) {
+        size_t total = 0;
+        while (total < length) {
+            ssize_t n = read(fd, data + total, length - total);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                throw std::runtime_error("读取文件失败: " + std::string(strerror(errno)));
+            }
+            if (n == 0) break;
+            total += static_cast<size_t>(n);
+        }
+        return total;
     }
 
 public:
-    // 3DES加密
+    // 3DES加密（旧格式：密钥写在输出文件名里，IV取自加密时间，解密端依赖文件时间，
+    // 新文件请使用encryptGCM）
     static void encrypt3DES(const std::string& file_path, const std::string& file_name, 
                            const std::string& key) {
         try {
-            // 读取文件内容
             std::string full_path = file_path + file_name;
-            auto plaintext = readFile(full_path);
             
             // 生成IV（使用当前时间）
             std::string iv_str = getCurrentTime();
@@ -88,47 +233,9 @@ public:
                 full_key = full_key.substr(0, 24);
             }
             
-            // 设置加密上下文
-            EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-            if (!ctx) {
-                throw std::runtime_error("无法创建EVP上下文");
-            }
-            
-            // 初始化3DES加密
-            if (EVP_EncryptInit_ex(ctx, EVP_des_ede3_cbc(), NULL, 
-                                  reinterpret_cast<const unsigned char*>(full_key.c_str()),
-                                  reinterpret_cast<const unsigned char*>(iv_str.c_str())) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("3DES加密初始化失败");
-            }
-            
-            // PKCS5/PKCS7填充（在OpenSSL中相同）
-            addPKCS7Padding(plaintext, 8); // 3DES块大小为8字节
-            
-            // 执行加密
-            std::vector<unsigned char> ciphertext(plaintext.size() + EVP_MAX_BLOCK_LENGTH);
-            int out_len = 0, tmp_len = 0;
-            
-            if (EVP_EncryptUpdate(ctx, ciphertext.data(), &out_len, 
-                                 plaintext.data(), plaintext.size()) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("3DES加密失败");
-            }
-            
-            if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + out_len, &tmp_len) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("3DES加密完成失败");
-            }
-            
-            out_len += tmp_len;
-            ciphertext.resize(out_len);
-            
-            // 清理上下文
-            EVP_CIPHER_CTX_free(ctx);
-            
-            // 写入加密文件
+            // 流式加密写入
             std::string output_filename = file_path + "3DES_" + key + "_" + file_name;
-            writeFile(output_filename, ciphertext);
+            encryptStream(EVP_des_ede3_cbc(), full_key, iv_str, full_path, output_filename, "3DES");
             
             std::cout << "3DES加密完成: " << output_filename << std::endl;
             
@@ -138,13 +245,11 @@ public:
         }
     }
     
-    // AES加密
+    // AES加密（旧格式，同上）
     static void encryptAES(const std::string& file_path, const std::string& file_name,
                           const std::string& key) {
         try {
-            // 读取文件内容
             std::string full_path = file_path + file_name;
-            auto plaintext = readFile(full_path);
             
             // 生成IV：密钥中间8位 + 当前时间
             std::string key_middle;
@@ -177,52 +282,131 @@ public:
                 full_key = full_key.substr(0, 16);
             }
             
-            // 设置加密上下文
-            EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-            if (!ctx) {
+            // 流式加密写入
+            std::string output_filename = file_path + "AES_" + key + "_" + file_name;
+            encryptStream(EVP_aes_128_cbc(), full_key, iv_str, full_path, output_filename, "AES");
+            
+            std::cout << "AES加密完成: " << output_filename << std::endl;
+            
+        } catch (const std::exception& e) {
+            std::cerr << "AES加密错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+    
+    // 把in_fd中的明文加密为容器格式写到out_fd，两端都可以是管道，出错时抛出异常。
+    // 每块有独立的nonce和认证标签，各块互不依赖：每轮读入thread_count*4个分块后由多个线程并行加密，
+    // 再按顺序写出。返回分块数
+    static uint64_t encryptContainer(int in_fd, int out_fd, const std::string& key, unsigned thread_count = 0) {
+        if (thread_count == 0) {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        
+        unsigned char header[CONTAINER_HEADER_SIZE] = {};
+        memcpy(header, CONTAINER_MAGIC, 4);
+        header[4] = CONTAINER_VERSION;
+        header[5] = ALGORITHM_AES_256_GCM;
+        header[6] = KDF_PBKDF2_SHA256;
+        putLE32(header + 8, KDF_ITERATIONS);
+        putLE32(header + 12, static_cast<uint32_t>(GCM_CHUNK_SIZE));
+        if (RAND_bytes(header + SALT_OFFSET, SALT_SIZE) != 1 ||
+            RAND_bytes(header + NONCE_OFFSET, GCM_NONCE_SIZE) != 1) {
+            throw std::runtime_error("无法生成随机数");
+        }
+        std::vector<unsigned char> gcm_key = deriveContainerKey(key, header + SALT_OFFSET, KDF_ITERATIONS);
+        writeFully(out_fd, header, CONTAINER_HEADER_SIZE);
+        
+        // 每个线程一个EVP上下文，分块缓冲区在各轮之间复用
+        std::vector<std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)>> contexts;
+        for (unsigned t = 0; t < thread_count; t++) {
+            contexts.emplace_back(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+            if (!contexts.back()) {
                 throw std::runtime_error("无法创建EVP上下文");
             }
-            
-            // 初始化AES加密
-            if (EVP_EncryptInit_ex(ctx, EVP_aes_128_cbc(), NULL,
-                                  reinterpret_cast<const unsigned char*>(full_key.c_str()),
-                                  reinterpret_cast<const unsigned char*>(iv_str.c_str())) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("AES加密初始化失败");
+        }
+        std::vector<GcmChunk> batch(thread_count * 4);
+        for (auto& chunk : batch) {
+            chunk.data.resize(GCM_CHUNK_SIZE + EVP_MAX_BLOCK_LENGTH);
+        }
+        
+        uint64_t next_index = 0;
+        bool finished = false;
+        while (!finished) {
+            size_t count = 0;
+            while (count < batch.size() && !finished) {
+                GcmChunk& chunk = batch[count++];
+                chunk.length = readFully(in_fd, chunk.data.data(), GCM_CHUNK_SIZE);
+                chunk.index = next_index++;
+                chunk.final = chunk.length < GCM_CHUNK_SIZE;
+                finished = chunk.final;
             }
             
-            // PKCS7填充
-            addPKCS7Padding(plaintext, AES_BLOCK_SIZE);
-            
-            // 执行加密
-            std::vector<unsigned char> ciphertext(plaintext.size() + AES_BLOCK_SIZE);
-            int out_len = 0, tmp_len = 0;
-            
-            if (EVP_EncryptUpdate(ctx, ciphertext.data(), &out_len,
-                                 plaintext.data(), plaintext.size()) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("AES加密失败");
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < thread_count && t < count; t++) {
+                workers.emplace_back([&, t]() {
+                    for (size_t i = t; i < count; i += thread_count) {
+                        batch[i].ok = sealChunk(contexts[t].get(), gcm_key, header, batch[i]);
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
             }
             
-            if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + out_len, &tmp_len) != 1) {
-                EVP_CIPHER_CTX_free(ctx);
-                throw std::runtime_error("AES加密完成失败");
+            for (size_t i = 0; i < count; i++) {
+                if (!batch[i].ok) {
+                    throw std::runtime_error("GCM加密失败");
+                }
+                writeFully(out_fd, batch[i].data.data(), batch[i].length);
+                writeFully(out_fd, batch[i].tag, GCM_TAG_SIZE);
+            }
+        }
+        return next_index;
+    }
+    
+    // 分块AES-256-GCM加密文件，输出为 文件名.gcm，文件可以任意复制、改名后再解密
+    static void encryptGCM(const std::string& file_path, const std::string& file_name,
+                           const std::string& key, unsigned thread_count = 0) {
+        std::string full_path = file_path + file_name;
+        std::string output_filename = full_path + ".gcm";
+        int in_fd = -1, out_fd = -1;
+        
+        try {
+            if (thread_count == 0) {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
             }
             
-            out_len += tmp_len;
-            ciphertext.resize(out_len);
+            in_fd = open(full_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in_fd < 0) {
+                throw std::runtime_error("无法打开文件: " + full_path);
+            }
+            posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            out_fd = open(output_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (out_fd < 0) {
+                throw std::runtime_error("无法创建文件: " + output_filename);
+            }
             
-            // 清理上下文
-            EVP_CIPHER_CTX_free(ctx);
+            uint64_t chunks = encryptContainer(in_fd, out_fd, key, thread_count);
             
-            // 写入加密文件
-            std::string output_filename = file_path + "AES_" + key + "_" + file_name;
-            writeFile(output_filename, ciphertext);
+            close(in_fd);
+            in_fd = -1;
+            int fd = out_fd;
+            out_fd = -1;
+            if (close(fd) != 0) {
+                unlink(output_filename.c_str());
+                throw std::runtime_error("写入文件失败: " + output_filename);
+            }
             
-            std::cout << "AES加密完成: " << output_filename << std::endl;
+            std::cout << "GCM加密完成: " << output_filename << " (" << chunks << " 个分块, "
+                      << thread_count << " 线程)" << std::endl;
             
         } catch (const std::exception& e) {
-            std::cerr << "AES加密错误: " << e.what() << std::endl;
+            if (in_fd >= 0) close(in_fd);
+            if (out_fd >= 0) {
+                close(out_fd);
+                unlink(output_filename.c_str());
+            }
+            std::cerr << "GCM加密错误: " << e.what() << std::endl;
             throw;
         }
     }
@@ -244,6 +428,12 @@ int main() {
         // AES加密
         FileEncryptor::encryptAES(file_path, file_name, key);
         
+        // 分块AES-256-GCM加密（并行，带认证，参数保存在文件头部）
+        FileEncryptor::encryptGCM(file_path, file_name, key);
+        
+        // 也可以在管道中使用，例如 tar c dir | ./encrypt > dir.tar.gcm
+        // FileEncryptor::encryptContainer(STDIN_FILENO, STDOUT_FILENO, key);
+        
     } catch (const std::exception& e) {
         std::cerr << "程序出错: " << e.what() << std::endl;
         return 1;
@@ -6,29 +6,1470 @@
 #include <memory>
 #include <stdexcept>
 #include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <ctime>
 
 // 第三方库头文件
 #include <zip.h>
 #include <archive.h>
 #include <archive_entry.h>
+#include <lzma.h>
+#include <zlib.h>
+#include <openssl/evp.h>
 #include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+
+// POSIX目录与文件状态接口
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
 
 namespace fs = std::filesystem;
 
+// 遍历得到的文件记录（路径 + lstat结果）
+struct WalkRecord {
+    std::string path;           // 磁盘完整路径
+    std::string relative_path;  // 相对于打包根目录的路径
+    struct stat st;
+    std::string duplicate_of;   // 内容与之前某个文件相同时为该文件的relative_path
+};
+
+// 并行目录遍历器：每个工作线程维护自己的目录队列，空闲时从其他线程窃取任务，
+// 使用openat/getdents64/fstatat读取元数据，并通过有界队列把记录流式交给打包线程
+class ParallelWalker {
+private:
+    // linux_dirent64（glibc未导出该结构）
+    struct LinuxDirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    // 目录任务：已打开的目录fd（超过fd上限时为-1，按路径重新打开）
+    struct DirTask {
+        int fd = -1;
+        std::string path;
+        std::string relative_path;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<DirTask> tasks;
+    };
+
+    static constexpr size_t OUTPUT_CAPACITY = 4096;
+    static constexpr int MAX_OPEN_DIRS = 256;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    // 待处理目录数（入队时加一，扫描完成后减一），为0表示遍历结束
+    std::atomic<size_t> pending_dirs{0};
+    std::atomic<int> open_dirs{0};
+    std::atomic<bool> stopping{false};
+
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+
+    std::mutex output_mutex;
+    std::condition_variable output_not_empty;
+    std::condition_variable output_not_full;
+    std::deque<WalkRecord> output;
+    size_t active_workers = 0;
+
+    void pushTask(size_t worker, DirTask task) {
+        pending_dirs++;
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            queues[worker]->tasks.push_back(std::move(task));
+        }
+        idle_cv.notify_one();
+    }
+
+    // 本线程从队尾取任务（深度优先，局部性好），窃取时从其他线程队首取
+    bool takeTask(size_t worker, DirTask& task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+            if (!queues[worker]->tasks.empty()) {
+                task = std::move(queues[worker]->tasks.back());
+                queues[worker]->tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            WorkerQueue& victim = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void emit(WalkRecord record) {
+        std::unique_lock<std::mutex> lock(output_mutex);
+        output_not_full.wait(lock, [this] { return output.size() < OUTPUT_CAPACITY || stopping; });
+        if (stopping) return;
+        output.push_back(std::move(record));
+        output_not_empty.notify_one();
+    }
+
+    void scanDirectory(size_t worker, DirTask& task) {
+        int dir_fd = task.fd;
+        if (dir_fd < 0) {
+            dir_fd = open(task.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (dir_fd < 0) {
+                std::cerr << "警告: 无法打开目录: " << task.path << std::endl;
+                return;
+            }
+        } else {
+            open_dirs--;
+        }
+
+        alignas(LinuxDirent64) char buffer[64 * 1024];
+        while (!stopping) {
+            long nread = syscall(SYS_getdents64, dir_fd, buffer, sizeof(buffer));
+            if (nread <= 0) {
+                if (nread < 0) {
+                    std::cerr << "警告: 读取目录失败: " << task.path << std::endl;
+                }
+                break;
+            }
+
+            for (long pos = 0; pos < nread;) {
+                auto* entry = reinterpret_cast<LinuxDirent64*>(buffer + pos);
+                pos += entry->d_reclen;
+
+                const char* name = entry->d_name;
+                if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+                    continue;
+                }
+
+                WalkRecord record;
+                record.path = task.path + "/" + name;
+                record.relative_path = task.relative_path + "/" + name;
+                if (fstatat(dir_fd, name, &record.st, AT_SYMLINK_NOFOLLOW) != 0) {
+                    std::cerr << "警告: 无法获取文件状态: " << record.path << std::endl;
+                    continue;
+                }
+
+                if (!S_ISDIR(record.st.st_mode)) {
+                    emit(std::move(record));
+                    continue;
+                }
+
+                DirTask child;
+                child.path = record.path;
+                child.relative_path = record.relative_path;
+                // 趁父目录fd仍打开时用openat打开子目录，fd过多时退回按路径打开
+                if (open_dirs < MAX_OPEN_DIRS) {
+                    child.fd = openat(dir_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+                    if (child.fd >= 0) open_dirs++;
+                }
+                // 先输出目录自身的记录再投递任务，保证目录总在其内容之前出现
+                emit(std::move(record));
+                pushTask(worker, std::move(child));
+            }
+        }
+
+        close(dir_fd);
+    }
+
+    void workerLoop(size_t worker) {
+        while (!stopping) {
+            DirTask task;
+            if (takeTask(worker, task)) {
+                scanDirectory(worker, task);
+                if (--pending_dirs == 0) {
+                    idle_cv.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            if (pending_dirs == 0) break;
+            idle_cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+
+        // 丢弃停止时残留的任务
+        DirTask task;
+        while (takeTask(worker, task)) {
+            if (task.fd >= 0) close(task.fd);
+        }
+
+        std::lock_guard<std::mutex> lock(output_mutex);
+        if (--active_workers == 0) {
+            output_not_empty.notify_all();
+        }
+    }
+
+public:
+    // root为要遍历的目录，relative_root为其在归档中的路径
+    ParallelWalker(const fs::path& root, const std::string& relative_root, size_t thread_count = 0) {
+        if (thread_count == 0) {
+            thread_count = std::max(2u, std::thread::hardware_concurrency());
+        }
+
+        for (size_t i = 0; i < thread_count; i++) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+
+        DirTask root_task;
+        root_task.path = root.string();
+        root_task.relative_path = relative_root;
+        pushTask(0, std::move(root_task));
+
+        active_workers = thread_count;
+        for (size_t i = 0; i < thread_count; i++) {
+            workers.emplace_back(&ParallelWalker::workerLoop, this, i);
+        }
+    }
+
+    ~ParallelWalker() {
+        stopping = true;
+        idle_cv.notify_all();
+        output_not_full.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ParallelWalker(const ParallelWalker&) = delete;
+    ParallelWalker& operator=(const ParallelWalker&) = delete;
+
+    // 取下一条记录；遍历结束返回false（记录顺序不保证与目录顺序一致，但目录总在其内容之前）
+    bool next(WalkRecord& record) {
+        std::unique_lock<std::mutex> lock(output_mutex);
+        output_not_empty.wait(lock, [this] { return !output.empty() || active_workers == 0; });
+        if (output.empty()) {
+            return false;
+        }
+        record = std::move(output.front());
+        output.pop_front();
+        output_not_full.notify_one();
+        return true;
+    }
+};
+
+// 预读得到的数据块：每个文件的第一块带有文件记录，之后按顺序给出数据，last标记文件结束
+struct ReadBlock {
+    WalkRecord record;
+    std::vector<char> data;
+    uint64_t offset = 0;    // data在文件中的偏移（稀疏文件的块之间可能有空洞）
+    bool first = false;
+    bool last = false;
+    bool error = false;     // 文件无法打开或读取
+    bool sparse = false;    // 仅首块：文件含空洞，sparse_map为实际数据区
+    std::vector<std::pair<uint64_t, uint64_t>> sparse_map;  // {偏移, 长度}
+};
+
+// 用SEEK_DATA/SEEK_HOLE找出已分配的数据区；文件没有空洞或文件系统不支持时返回false
+static bool findDataRegions(int fd, uint64_t size, std::vector<std::pair<uint64_t, uint64_t>>& regions) {
+    regions.clear();
+    off_t pos = 0;
+    while (static_cast<uint64_t>(pos) < size) {
+        off_t data = lseek(fd, pos, SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO) break;      // 其后全部是空洞
+            return false;
+        }
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0) {
+            return false;
+        }
+        hole = std::min<off_t>(hole, static_cast<off_t>(size));
+        if (hole > data) {
+            regions.emplace_back(data, hole - data);
+        }
+        pos = hole;
+    }
+    return !(regions.size() == 1 && regions[0].first == 0 && regions[0].second == size);
+}
+
+// 可能含空洞的文件（已分配块少于文件大小）
+static bool maybeSparse(const struct stat& st) {
+    return S_ISREG(st.st_mode) && static_cast<uint64_t>(st.st_blocks) * 512 < static_cast<uint64_t>(st.st_size);
+}
+
+// 异步预读管线：读线程从生产者（遍历器）取得记录，对窗口内即将读取的文件提前
+// open并posix_fadvise(WILLNEED)，由内核在后台预读；文件内容按块读出后经有界队列
+// 交给压缩线程，磁盘I/O与压缩重叠进行
+class ReadAheadPipeline {
+public:
+    using Producer = std::function<bool(WalkRecord&)>;
+
+private:
+    struct Pending {
+        WalkRecord record;
+        int fd = -1;
+    };
+
+    static constexpr size_t WINDOW_SIZE = 32;                  // 提前打开的文件数
+    static constexpr size_t READ_BLOCK_SIZE = 1024 * 1024;     // 单次读取大小
+    static constexpr size_t QUEUE_CAPACITY = 64;               // 队列中最多的数据块
+    static constexpr off_t ADVISE_LIMIT = 8 * 1024 * 1024;     // 每个文件提示预读的长度
+
+    Producer producer;
+    bool detect_sparse;
+    std::deque<Pending> window;
+    bool producer_done = false;
+    std::set<std::string> failed;   // 未能完整读出的文件，其重复文件改为读取自身数据
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<ReadBlock> queue;
+    bool finished = false;
+    bool stopping = false;
+    std::thread reader;
+
+    // 补满预读窗口：打开文件并提示内核异步预读
+    void fillWindow() {
+        while (!producer_done && window.size() < WINDOW_SIZE) {
+            Pending pending;
+            if (!producer(pending.record)) {
+                producer_done = true;
+                break;
+            }
+            if (S_ISREG(pending.record.st.st_mode) && pending.record.duplicate_of.empty()) {
+                pending.fd = open(pending.record.path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (pending.fd >= 0 && pending.record.st.st_size > 0) {
+                    posix_fadvise(pending.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    posix_fadvise(pending.fd, 0, std::min<off_t>(pending.record.st.st_size, ADVISE_LIMIT),
+                                  POSIX_FADV_WILLNEED);
+                }
+            }
+            window.push_back(std::move(pending));
+        }
+    }
+
+    bool push(ReadBlock block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return queue.size() < QUEUE_CAPACITY || stopping; });
+        if (stopping) return false;
+        queue.push_back(std::move(block));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // 按stat得到的大小读取，与归档头部记录的大小一致；
+    // 开启稀疏检测时只读取已分配的数据区，空洞不产生I/O
+    bool readFile(Pending& pending) {
+        const WalkRecord& record = pending.record;
+        if (pending.fd < 0) {
+            std::cerr << "警告: 无法打开文件: " << record.path << std::endl;
+            failed.insert(record.relative_path);
+            ReadBlock block;
+            block.record = record;
+            block.first = block.last = block.error = true;
+            return push(std::move(block));
+        }
+
+        uint64_t size = static_cast<uint64_t>(record.st.st_size);
+        std::vector<std::pair<uint64_t, uint64_t>> regions;
+        bool sparse = detect_sparse && maybeSparse(record.st) && findDataRegions(pending.fd, size, regions);
+        if (!sparse) {
+            regions.assign(1, {0, size});
+        }
+
+        bool first = true;
+        for (size_t r = 0; r < regions.size(); r++) {
+            uint64_t offset = regions[r].first;
+            uint64_t remaining = regions[r].second;
+            bool truncated = false;
+            do {
+                ReadBlock block;
+                if (first) {
+                    block.record = record;
+                    block.sparse = sparse;
+                    if (sparse) block.sparse_map = regions;
+                }
+                block.first = first;
+                block.offset = offset;
+                first = false;
+
+                block.data.resize(static_cast<size_t>(std::min<uint64_t>(remaining, READ_BLOCK_SIZE)));
+                size_t filled = 0;
+                while (filled < block.data.size()) {
+                    ssize_t n = pread(pending.fd, block.data.data() + filled, block.data.size() - filled,
+                                      static_cast<off_t>(offset + filled));
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) {
+                        if (n < 0) std::cerr << "警告: 读取文件失败: " << record.path << std::endl;
+                        truncated = true;   // 文件被截断或出错，就此结束
+                        break;
+                    }
+                    filled += static_cast<size_t>(n);
+                }
+                block.data.resize(filled);
+                offset += filled;
+                remaining -= truncated ? remaining : filled;
+                block.last = truncated || (remaining == 0 && r + 1 == regions.size());
+                if (!push(std::move(block))) return false;
+            } while (remaining > 0);
+            if (truncated) {
+                failed.insert(record.relative_path);
+                break;
+            }
+        }
+
+        // 整个文件都是空洞
+        if (first) {
+            ReadBlock block;
+            block.record = record;
+            block.first = block.last = true;
+            block.sparse = sparse;
+            return push(std::move(block));
+        }
+        return true;
+    }
+
+    void readerLoop() {
+        fillWindow();
+        while (!window.empty()) {
+            Pending pending = std::move(window.front());
+            window.pop_front();
+            fillWindow();
+
+            // 原件未能完整读出时，重复文件没有可引用的数据，改为读取它自身
+            if (!pending.record.duplicate_of.empty() && failed.count(pending.record.duplicate_of)) {
+                std::cerr << "警告: 原件读取失败，改为保存完整内容: " << pending.record.path << std::endl;
+                pending.record.duplicate_of.clear();
+                pending.fd = open(pending.record.path.c_str(), O_RDONLY | O_CLOEXEC);
+            }
+
+            bool ok;
+            if (S_ISREG(pending.record.st.st_mode) && pending.record.duplicate_of.empty()) {
+                ok = readFile(pending);
+                if (pending.fd >= 0) close(pending.fd);
+            } else {
+                ReadBlock block;
+                block.record = std::move(pending.record);
+                block.first = block.last = true;
+                ok = push(std::move(block));
+            }
+            if (!ok) break;
+        }
+
+        for (auto& pending : window) {
+            if (pending.fd >= 0) close(pending.fd);
+        }
+        window.clear();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        not_empty.notify_all();
+    }
+
+public:
+    // skip_holes为true时按SEEK_DATA/SEEK_HOLE跳过空洞，数据块带有文件内偏移
+    explicit ReadAheadPipeline(Producer source, bool skip_holes = false)
+        : producer(std::move(source)), detect_sparse(skip_holes) {
+        reader = std::thread(&ReadAheadPipeline::readerLoop, this);
+    }
+
+    ~ReadAheadPipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        not_full.notify_all();
+        reader.join();
+    }
+
+    ReadAheadPipeline(const ReadAheadPipeline&) = delete;
+    ReadAheadPipeline& operator=(const ReadAheadPipeline&) = delete;
+
+    // 取下一个数据块；全部读完返回false
+    bool next(ReadBlock& block) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !queue.empty() || finished; });
+        if (queue.empty()) {
+            return false;
+        }
+        block = std::move(queue.front());
+        queue.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+};
+
+// 重复文件识别：按大小分桶，只有大小相同时才计算首尾块的快速预哈希，
+// 预哈希也相同时才计算完整SHA-256。哈希均为惰性计算，按输出顺序调用check，
+// 先出现的文件作为原件保存，之后内容相同的文件标记为它的重复
+class DuplicateFinder {
+private:
+    static constexpr size_t PREHASH_BLOCK = 4096;
+
+    struct Candidate {
+        std::string path;
+        std::string relative_path;
+        dev_t dev;
+        ino_t ino;
+        bool has_prehash = false;
+        uint64_t prehash = 0;
+        std::string full_hash;      // 为空表示尚未计算
+    };
+
+    std::map<uint64_t, std::vector<Candidate>> buckets;
+    size_t duplicate_files = 0;
+    uint64_t duplicate_bytes = 0;
+
+    // 首块和末块各自的CRC32拼成64位预哈希
+    static bool computePrehash(const std::string& path, uint64_t size, uint64_t& prehash) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        char buffer[PREHASH_BLOCK];
+        size_t head = static_cast<size_t>(std::min<uint64_t>(size, PREHASH_BLOCK));
+        if (!file.read(buffer, head)) {
+            return false;
+        }
+        uLong head_crc = crc32(0L, reinterpret_cast<const Bytef*>(buffer), static_cast<uInt>(head));
+
+        uLong tail_crc = 0;
+        if (size > PREHASH_BLOCK) {
+            size_t tail = static_cast<size_t>(std::min<uint64_t>(size - PREHASH_BLOCK, PREHASH_BLOCK));
+            file.seekg(static_cast<std::streamoff>(size - tail));
+            if (!file.read(buffer, tail)) {
+                return false;
+            }
+            tail_crc = crc32(0L, reinterpret_cast<const Bytef*>(buffer), static_cast<uInt>(tail));
+        }
+        prehash = (static_cast<uint64_t>(head_crc) << 32) | tail_crc;
+        return true;
+    }
+
+    static std::string computeFullHash(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return "";
+        }
+
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+        std::vector<char> buffer(1024 * 1024);
+        while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+            EVP_DigestUpdate(ctx, buffer.data(), static_cast<size_t>(file.gcount()));
+        }
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        EVP_DigestFinal_ex(ctx, digest, &length);
+        EVP_MD_CTX_free(ctx);
+        return std::string(reinterpret_cast<char*>(digest), length);
+    }
+
+    static bool ensurePrehash(Candidate& candidate, uint64_t size) {
+        if (!candidate.has_prehash) {
+            candidate.has_prehash = computePrehash(candidate.path, size, candidate.prehash);
+        }
+        return candidate.has_prehash;
+    }
+
+    static bool ensureFullHash(Candidate& candidate) {
+        if (candidate.full_hash.empty()) {
+            candidate.full_hash = computeFullHash(candidate.path);
+        }
+        return !candidate.full_hash.empty();
+    }
+
+public:
+    // 检查一个记录是否与之前的文件重复；重复时设置record.duplicate_of并返回true
+    bool check(WalkRecord& record) {
+        if (!S_ISREG(record.st.st_mode) || record.st.st_size <= 0) {
+            return false;
+        }
+
+        uint64_t size = static_cast<uint64_t>(record.st.st_size);
+        Candidate current;
+        current.path = record.path;
+        current.relative_path = record.relative_path;
+        current.dev = record.st.st_dev;
+        current.ino = record.st.st_ino;
+
+        std::vector<Candidate>& bucket = buckets[size];
+        const Candidate* original = nullptr;
+
+        // 已经是硬链接的文件无需比较内容
+        for (const auto& candidate : bucket) {
+            if (candidate.dev == current.dev && candidate.ino == current.ino) {
+                original = &candidate;
+                break;
+            }
+        }
+
+        if (!original && !bucket.empty() && ensurePrehash(current, size)) {
+            for (auto& candidate : bucket) {
+                if (!ensurePrehash(candidate, size) || candidate.prehash != current.prehash) {
+                    continue;
+                }
+                if (ensureFullHash(current) && ensureFullHash(candidate) &&
+                    candidate.full_hash == current.full_hash) {
+                    original = &candidate;
+                    break;
+                }
+            }
+        }
+
+        if (original) {
+            record.duplicate_of = original->relative_path;
+            duplicate_files++;
+            duplicate_bytes += size;
+            return true;
+        }
+
+        bucket.push_back(std::move(current));
+        return false;
+    }
+
+    // 撤销check设置的重复标记：调用者仍要保存该文件的完整数据
+    void keep(WalkRecord& record) {
+        if (record.duplicate_of.empty()) {
+            return;
+        }
+        record.duplicate_of.clear();
+        duplicate_files--;
+        duplicate_bytes -= static_cast<uint64_t>(record.st.st_size);
+    }
+
+    size_t duplicateFiles() const {
+        return duplicate_files;
+    }
+
+    uint64_t duplicateBytes() const {
+        return duplicate_bytes;
+    }
+};
+
+// 有界阻塞队列：连接格式转换管线的各个阶段，队列满时上游等待，内存占用因此有上限。
+// close表示生产者已结束（剩余元素仍可取出），abort表示下游放弃，双方都立即返回
+template <typename T>
+class BoundedQueue {
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+    bool aborted = false;
+
+public:
+    explicit BoundedQueue(size_t max_items) : capacity(max_items) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // 队列已被放弃时返回false
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return items.size() < capacity || aborted; });
+        if (aborted) return false;
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // 取出下一个元素；生产者已结束且队列为空，或队列被放弃时返回false
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !items.empty() || closed || aborted; });
+        if (aborted || items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+    void abort() {
+        std::lock_guard<std::mutex> lock(mutex);
+        aborted = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+};
+
+// 打包统计：压缩与直接存储（已是压缩格式）的条目数
+struct PackStats {
+    size_t compressed_files = 0;
+    size_t stored_files = 0;
+    uint64_t stored_bytes = 0;
+    size_t duplicate_files = 0;     // 内容重复、只保存了引用的文件
+    uint64_t duplicate_bytes = 0;
+    size_t sparse_files = 0;        // 以稀疏条目保存的文件
+    uint64_t hole_bytes = 0;        // 跳过的空洞字节数
+};
+
+// ZIP追加更新：在已有归档的中央目录位置写入新的或有变化的条目，再写出新的中央目录。
+// 被替换的旧条目数据仍留在文件中（死条目），只是不再被中央目录引用，可由compact回收。
+// 这样一次小更新的开销只取决于变更本身，而不是整个归档的大小
+class ZipUpdater {
+private:
+    static constexpr uint32_t LOCAL_HEADER_SIG = 0x04034b50;
+    static constexpr uint32_t CENTRAL_HEADER_SIG = 0x02014b50;
+    static constexpr uint32_t DATA_DESCRIPTOR_SIG = 0x08074b50;
+    static constexpr uint32_t EOCD_SIG = 0x06054b50;
+    static constexpr uint32_t ZIP64_EOCD_SIG = 0x06064b50;
+    static constexpr uint32_t ZIP64_LOCATOR_SIG = 0x07064b50;
+    static constexpr uint16_t ZIP64_EXTRA_ID = 0x0001;
+    static constexpr uint16_t TIMESTAMP_EXTRA_ID = 0x5455;
+    static constexpr uint64_t ZIP64_THRESHOLD = 0xFFFF0000ULL;  // 留出余量，压缩后略有膨胀也不溢出
+
+public:
+    // 中央目录中的一个条目
+    struct Entry {
+        std::string name;
+        uint16_t version_made = 0;
+        uint16_t version_needed = 20;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint16_t dos_time = 0;
+        uint16_t dos_date = 0;
+        uint32_t crc = 0;
+        uint64_t compressed_size = 0;
+        uint64_t size = 0;
+        uint64_t offset = 0;
+        uint16_t internal_attr = 0;
+        uint32_t external_attr = 0;
+        std::string extra;      // 不含ZIP64扩展字段，写出时按需重新生成
+        std::string comment;
+        int64_t mtime = -1;     // 来自0x5455扩展时间戳，没有时为-1
+    };
+
+private:
+    fs::path archive_path;
+    std::fstream file;
+    std::vector<Entry> entries;
+    std::map<std::string, size_t> index;
+    std::vector<bool> live;
+    std::string archive_comment;
+    uint64_t original_size = 0;     // 打开时的文件大小，失败时截断回这里
+    uint64_t append_offset = 0;     // 新数据写在原EOCD之后，commit()之前原中央目录始终有效
+    uint64_t dead_bytes = 0;        // 本次替换掉的旧条目（以及被取代的旧中央目录）占用的字节数
+    uint64_t old_directory_bytes = 0;   // 原中央目录和EOCD的长度，提交后成为死数据
+    bool committed = false;
+
+    static void put16(std::string& out, uint16_t v) {
+        out.push_back(static_cast<char>(v & 0xFF));
+        out.push_back(static_cast<char>(v >> 8));
+    }
+    static void put32(std::string& out, uint32_t v) {
+        put16(out, static_cast<uint16_t>(v & 0xFFFF));
+        put16(out, static_cast<uint16_t>(v >> 16));
+    }
+    static void put64(std::string& out, uint64_t v) {
+        put32(out, static_cast<uint32_t>(v & 0xFFFFFFFF));
+        put32(out, static_cast<uint32_t>(v >> 32));
+    }
+    static uint16_t get16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    static uint32_t get32(const unsigned char* p) { return get16(p) | (static_cast<uint32_t>(get16(p + 2)) << 16); }
+    static uint64_t get64(const unsigned char* p) { return get32(p) | (static_cast<uint64_t>(get32(p + 4)) << 32); }
+
+    static std::string readAt(std::fstream& f, uint64_t offset, size_t length) {
+        std::string data(length, '\0');
+        f.clear();
+        f.seekg(static_cast<std::streamoff>(offset));
+        if (!f.read(&data[0], length)) {
+            throw std::runtime_error("ZIP文件读取失败（偏移 " + std::to_string(offset) + "）");
+        }
+        return data;
+    }
+
+    static void toDosTime(time_t t, uint16_t& dos_time, uint16_t& dos_date) {
+        struct tm tm_value;
+        localtime_r(&t, &tm_value);
+        if (tm_value.tm_year < 80) {
+            dos_time = 0;
+            dos_date = (1 << 5) | 1;
+            return;
+        }
+        dos_time = static_cast<uint16_t>((tm_value.tm_hour << 11) | (tm_value.tm_min << 5) | (tm_value.tm_sec / 2));
+        dos_date = static_cast<uint16_t>(((tm_value.tm_year - 80) << 9) | ((tm_value.tm_mon + 1) << 5) | tm_value.tm_mday);
+    }
+
+    // 解析扩展字段：取出ZIP64的真实大小/偏移和扩展时间戳，其余字段原样保留
+    static void parseExtra(Entry& entry, const std::string& extra,
+                           bool size_overflow, bool csize_overflow, bool offset_overflow) {
+        const auto* p = reinterpret_cast<const unsigned char*>(extra.data());
+        size_t pos = 0;
+        while (pos + 4 <= extra.size()) {
+            uint16_t id = get16(p + pos);
+            uint16_t len = get16(p + pos + 2);
+            if (pos + 4 + len > extra.size()) break;
+            const unsigned char* data = p + pos + 4;
+
+            if (id == ZIP64_EXTRA_ID) {
+                size_t field = 0;
+                if (size_overflow && field + 8 <= len) { entry.size = get64(data + field); field += 8; }
+                if (csize_overflow && field + 8 <= len) { entry.compressed_size = get64(data + field); field += 8; }
+                if (offset_overflow && field + 8 <= len) { entry.offset = get64(data + field); field += 8; }
+            } else {
+                if (id == TIMESTAMP_EXTRA_ID && len >= 5 && (data[0] & 1)) {
+                    entry.mtime = static_cast<int32_t>(get32(data + 1));
+                }
+                entry.extra.append(extra, pos, 4 + len);
+            }
+            pos += 4 + len;
+        }
+    }
+
+    // 定位EOCD（含ZIP64），读取中央目录
+    void readCentralDirectory() {
+        file.clear();
+        file.seekg(0, std::ios::end);
+        uint64_t file_size = static_cast<uint64_t>(file.tellg());
+        if (file_size < 22) {
+            throw std::runtime_error("不是有效的ZIP文件: " + archive_path.string());
+        }
+
+        // EOCD位于文件末尾，其后最多跟65535字节的注释
+        size_t tail_size = static_cast<size_t>(std::min<uint64_t>(file_size, 22 + 65535));
+        uint64_t tail_offset = file_size - tail_size;
+        std::string tail = readAt(file, tail_offset, tail_size);
+        const auto* t = reinterpret_cast<const unsigned char*>(tail.data());
+
+        size_t eocd = std::string::npos;
+        for (size_t i = tail_size - 22 + 1; i-- > 0;) {
+            if (get32(t + i) == EOCD_SIG && i + 22 + get16(t + i + 20) == tail_size) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd == std::string::npos) {
+            throw std::runtime_error("找不到ZIP中央目录结束记录: " + archive_path.string());
+        }
+
+        uint64_t entry_count = get16(t + eocd + 10);
+        uint64_t cd_size = get32(t + eocd + 12);
+        uint64_t cd_offset = get32(t + eocd + 16);
+        archive_comment = tail.substr(eocd + 22, get16(t + eocd + 20));
+
+        // ZIP64：定位记录紧挨在EOCD之前
+        uint64_t eocd_offset = tail_offset + eocd;
+        if (eocd_offset >= 20) {
+            std::string locator = readAt(file, eocd_offset - 20, 20);
+            const auto* l = reinterpret_cast<const unsigned char*>(locator.data());
+            if (get32(l) == ZIP64_LOCATOR_SIG) {
+                std::string record = readAt(file, get64(l + 8), 56);
+                const auto* r = reinterpret_cast<const unsigned char*>(record.data());
+                if (get32(r) != ZIP64_EOCD_SIG) {
+                    throw std::runtime_error("ZIP64中央目录结束记录损坏");
+                }
+                entry_count = get64(r + 32);
+                cd_size = get64(r + 40);
+                cd_offset = get64(r + 48);
+            }
+        }
+
+        std::string cd = readAt(file, cd_offset, static_cast<size_t>(cd_size));
+        const auto* c = reinterpret_cast<const unsigned char*>(cd.data());
+        size_t pos = 0;
+        for (uint64_t i = 0; i < entry_count; i++) {
+            if (pos + 46 > cd.size() || get32(c + pos) != CENTRAL_HEADER_SIG) {
+                throw std::runtime_error("ZIP中央目录损坏");
+            }
+            Entry entry;
+            entry.version_made = get16(c + pos + 4);
+            entry.version_needed = get16(c + pos + 6);
+            entry.flags = get16(c + pos + 8);
+            entry.method = get16(c + pos + 10);
+            entry.dos_time = get16(c + pos + 12);
+            entry.dos_date = get16(c + pos + 14);
+            entry.crc = get32(c + pos + 16);
+            entry.compressed_size = get32(c + pos + 20);
+            entry.size = get32(c + pos + 24);
+            uint16_t name_len = get16(c + pos + 28);
+            uint16_t extra_len = get16(c + pos + 30);
+            uint16_t comment_len = get16(c + pos + 32);
+            entry.internal_attr = get16(c + pos + 36);
+            entry.external_attr = get32(c + pos + 38);
+            entry.offset = get32(c + pos + 42);
+            if (pos + 46 + name_len + extra_len + comment_len > cd.size()) {
+                throw std::runtime_error("ZIP中央目录损坏");
+            }
+            entry.name = cd.substr(pos + 46, name_len);
+            parseExtra(entry, cd.substr(pos + 46 + name_len, extra_len),
+                       entry.size == 0xFFFFFFFF, entry.compressed_size == 0xFFFFFFFF, entry.offset == 0xFFFFFFFF);
+            entry.comment = cd.substr(pos + 46 + name_len + extra_len, comment_len);
+            pos += 46 + name_len + extra_len + comment_len;
+
+            index[entry.name] = entries.size();
+            entries.push_back(std::move(entry));
+            live.push_back(true);
+        }
+
+        original_size = file_size;
+        append_offset = file_size;
+        old_directory_bytes = file_size - cd_offset;
+    }
+
+    // 未提交时丢弃追加的数据，恢复为打开时的归档
+    void rollback() noexcept {
+        if (committed || append_offset == original_size) {
+            return;
+        }
+        committed = true;
+        if (file.is_open()) {
+            file.close();
+        }
+        std::error_code ec;
+        fs::resize_file(archive_path, original_size, ec);
+    }
+
+    // 条目在文件中占用的总长度（本地头部 + 数据 + 可选的数据描述符）
+    static uint64_t storedLength(std::fstream& f, const Entry& entry) {
+        std::string header = readAt(f, entry.offset, 30);
+        const auto* h = reinterpret_cast<const unsigned char*>(header.data());
+        if (get32(h) != LOCAL_HEADER_SIG) {
+            throw std::runtime_error("ZIP本地文件头损坏: " + entry.name);
+        }
+        uint64_t length = 30 + get16(h + 26) + get16(h + 28) + entry.compressed_size;
+        if (entry.flags & 0x0008) {
+            bool zip64 = entry.size >= 0xFFFFFFFF || entry.compressed_size >= 0xFFFFFFFF;
+            std::string sig = readAt(f, entry.offset + length, 4);
+            bool has_sig = get32(reinterpret_cast<const unsigned char*>(sig.data())) == DATA_DESCRIPTOR_SIG;
+            length += (has_sig ? 4 : 0) + 4 + (zip64 ? 16 : 8);
+        }
+        return length;
+    }
+
+    static std::string buildCentralHeader(const Entry& entry, uint64_t offset) {
+        bool size64 = entry.size >= 0xFFFFFFFF;
+        bool csize64 = entry.compressed_size >= 0xFFFFFFFF;
+        bool offset64 = offset >= 0xFFFFFFFF;
+
+        std::string extra;
+        if (size64 || csize64 || offset64) {
+            std::string fields;
+            if (size64) put64(fields, entry.size);
+            if (csize64) put64(fields, entry.compressed_size);
+            if (offset64) put64(fields, offset);
+            put16(extra, ZIP64_EXTRA_ID);
+            put16(extra, static_cast<uint16_t>(fields.size()));
+            extra += fields;
+        }
+        extra += entry.extra;
+
+        std::string out;
+        put32(out, CENTRAL_HEADER_SIG);
+        put16(out, entry.version_made);
+        put16(out, extra.size() > entry.extra.size() ? std::max<uint16_t>(entry.version_needed, 45) : entry.version_needed);
+        put16(out, entry.flags);
+        put16(out, entry.method);
+        put16(out, entry.dos_time);
+        put16(out, entry.dos_date);
+        put32(out, entry.crc);
+        put32(out, csize64 ? 0xFFFFFFFF : static_cast<uint32_t>(entry.compressed_size));
+        put32(out, size64 ? 0xFFFFFFFF : static_cast<uint32_t>(entry.size));
+        put16(out, static_cast<uint16_t>(entry.name.size()));
+        put16(out, static_cast<uint16_t>(extra.size()));
+        put16(out, static_cast<uint16_t>(entry.comment.size()));
+        put16(out, 0);
+        put16(out, entry.internal_attr);
+        put32(out, entry.external_attr);
+        put32(out, offset64 ? 0xFFFFFFFF : static_cast<uint32_t>(offset));
+        out += entry.name;
+        out += extra;
+        out += entry.comment;
+        return out;
+    }
+
+    // 写出中央目录和结束记录（需要时带ZIP64结构）
+    static void writeCentralDirectory(std::fstream& f, uint64_t cd_offset,
+                                      const std::vector<const Entry*>& list,
+                                      const std::string& comment) {
+        std::string cd;
+        for (const Entry* entry : list) {
+            cd += buildCentralHeader(*entry, entry->offset);
+        }
+        f.clear();
+        f.seekp(static_cast<std::streamoff>(cd_offset));
+        f.write(cd.data(), cd.size());
+
+        uint64_t cd_end = cd_offset + cd.size();
+        bool zip64 = list.size() >= 0xFFFF || cd.size() >= 0xFFFFFFFF || cd_offset >= 0xFFFFFFFF;
+        std::string tail;
+        if (zip64) {
+            put32(tail, ZIP64_EOCD_SIG);
+            put64(tail, 44);
+            put16(tail, (3 << 8) | 45);
+            put16(tail, 45);
+            put32(tail, 0);
+            put32(tail, 0);
+            put64(tail, list.size());
+            put64(tail, list.size());
+            put64(tail, cd.size());
+            put64(tail, cd_offset);
+
+            put32(tail, ZIP64_LOCATOR_SIG);
+            put32(tail, 0);
+            put64(tail, cd_end);
+            put32(tail, 1);
+        }
+        put32(tail, EOCD_SIG);
+        put16(tail, 0);
+        put16(tail, 0);
+        put16(tail, zip64 ? 0xFFFF : static_cast<uint16_t>(list.size()));
+        put16(tail, zip64 ? 0xFFFF : static_cast<uint16_t>(list.size()));
+        put32(tail, zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(cd.size()));
+        put32(tail, zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(cd_offset));
+        put16(tail, static_cast<uint16_t>(comment.size()));
+        tail += comment;
+        f.write(tail.data(), tail.size());
+    }
+
+    // 替换同名旧条目：旧数据变为死条目
+    void retire(const std::string& name) {
+        auto it = index.find(name);
+        if (it != index.end() && live[it->second]) {
+            live[it->second] = false;
+            dead_bytes += storedLength(file, entries[it->second]);
+        }
+    }
+
+    void appendEntry(Entry entry) {
+        retire(entry.name);
+        index[entry.name] = entries.size();
+        entries.push_back(std::move(entry));
+        live.push_back(true);
+    }
+
+public:
+    // 打开已有ZIP归档并读取其中央目录
+    explicit ZipUpdater(const fs::path& path) : archive_path(path) {
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("无法打开ZIP文件: " + path.string());
+        }
+        readCentralDirectory();
+    }
+
+    ~ZipUpdater() {
+        rollback();
+    }
+
+    ZipUpdater(const ZipUpdater&) = delete;
+    ZipUpdater& operator=(const ZipUpdater&) = delete;
+
+    // 归档中的条目是否与磁盘上的文件一致（大小和修改时间相同）
+    bool isUnchanged(const std::string& name, const struct stat& st) const {
+        auto it = index.find(name);
+        if (it == index.end() || !live[it->second]) {
+            return false;
+        }
+        const Entry& entry = entries[it->second];
+        if (entry.size != static_cast<uint64_t>(st.st_size)) {
+            return false;
+        }
+        if (entry.mtime >= 0) {
+            return entry.mtime == static_cast<int64_t>(st.st_mtime);
+        }
+        uint16_t dos_time, dos_date;
+        toDosTime(st.st_mtime, dos_time, dos_date);
+        return entry.dos_time == dos_time && entry.dos_date == dos_date;
+    }
+
+    bool contains(const std::string& name) const {
+        auto it = index.find(name);
+        return it != index.end() && live[it->second];
+    }
+
+    // 在追加位置写入一个条目（目录或普通文件），store为true时不压缩
+    void addEntry(const fs::path& source, const std::string& name, const struct stat& st, bool store) {
+        bool is_dir = S_ISDIR(st.st_mode);
+        Entry entry;
+        entry.name = name;
+        entry.version_made = (3 << 8) | 45;     // Unix
+        entry.flags = 0x0800;                   // 文件名为UTF-8
+        entry.method = (is_dir || store) ? 0 : 8;
+        entry.external_attr = static_cast<uint32_t>(st.st_mode) << 16;
+        if (is_dir) entry.external_attr |= 0x10;
+        entry.mtime = st.st_mtime;
+        toDosTime(st.st_mtime, entry.dos_time, entry.dos_date);
+        put16(entry.extra, TIMESTAMP_EXTRA_ID);
+        put16(entry.extra, 5);
+        entry.extra.push_back(1);
+        put32(entry.extra, static_cast<uint32_t>(st.st_mtime));
+
+        uint64_t raw_size = is_dir ? 0 : static_cast<uint64_t>(st.st_size);
+        bool zip64 = raw_size >= ZIP64_THRESHOLD;
+        entry.version_needed = zip64 ? 45 : 20;
+        entry.offset = append_offset;
+
+        // 先打开源文件，失败时归档中什么都还没写
+        std::ifstream in;
+        if (!is_dir) {
+            in.open(source, std::ios::binary);
+            if (!in.is_open()) {
+                throw std::runtime_error("无法打开文件: " + source.string());
+            }
+        }
+
+        // 本地头部中的CRC和大小先占位，数据写完后回填
+        std::string header;
+        put32(header, LOCAL_HEADER_SIG);
+        put16(header, entry.version_needed);
+        put16(header, entry.flags);
+        put16(header, entry.method);
+        put16(header, entry.dos_time);
+        put16(header, entry.dos_date);
+        put32(header, 0);
+        put32(header, zip64 ? 0xFFFFFFFF : 0);
+        put32(header, zip64 ? 0xFFFFFFFF : 0);
+        put16(header, static_cast<uint16_t>(name.size()));
+        put16(header, static_cast<uint16_t>((zip64 ? 20 : 0) + entry.extra.size()));
+        header += name;
+        if (zip64) {
+            put16(header, ZIP64_EXTRA_ID);
+            put16(header, 16);
+            put64(header, 0);
+            put64(header, 0);
+        }
+        header += entry.extra;
+
+        file.clear();
+        file.seekp(static_cast<std::streamoff>(append_offset));
+        file.write(header.data(), header.size());
+
+        uint32_t crc = crc32(0L, Z_NULL, 0);
+        uint64_t written = 0, consumed = 0;
+        if (!is_dir) {
+            std::vector<char> input(1024 * 1024);
+            std::vector<char> output(1024 * 1024);
+            z_stream zs{};
+            if (entry.method == 8 && deflateInit2(&zs, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("DEFLATE初始化失败");
+            }
+
+            // 只读取stat得到的大小，与本地头部记录保持一致
+            bool done = false;
+            while (!done) {
+                size_t want = static_cast<size_t>(std::min<uint64_t>(input.size(), raw_size - consumed));
+                in.read(input.data(), want);
+                if (in.bad()) {
+                    throw std::runtime_error("读取文件失败: " + source.string());
+                }
+                size_t got = static_cast<size_t>(in.gcount());
+                consumed += got;
+                done = got < want || consumed == raw_size;
+                crc = crc32(crc, reinterpret_cast<const Bytef*>(input.data()), static_cast<uInt>(got));
+
+                if (entry.method == 0) {
+                    file.write(input.data(), got);
+                    written += got;
+                    continue;
+                }
+                zs.next_in = reinterpret_cast<Bytef*>(input.data());
+                zs.avail_in = static_cast<uInt>(got);
+                do {
+                    zs.next_out = reinterpret_cast<Bytef*>(output.data());
+                    zs.avail_out = static_cast<uInt>(output.size());
+                    deflate(&zs, done ? Z_FINISH : Z_NO_FLUSH);
+                    size_t n = output.size() - zs.avail_out;
+                    file.write(output.data(), n);
+                    written += n;
+                } while (zs.avail_out == 0);
+            }
+            if (entry.method == 8) {
+                deflateEnd(&zs);
+            }
+        }
+
+        entry.crc = crc;
+        entry.size = consumed;
+        entry.compressed_size = written;
+        if (!zip64 && written >= 0xFFFFFFFF) {
+            throw std::runtime_error("压缩后数据超过4GB: " + name);
+        }
+
+        // 回填CRC和大小
+        std::string sizes;
+        put32(sizes, crc);
+        put32(sizes, zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(written));
+        put32(sizes, zip64 ? 0xFFFFFFFF : static_cast<uint32_t>(consumed));
+        file.seekp(static_cast<std::streamoff>(append_offset + 14));
+        file.write(sizes.data(), sizes.size());
+        if (zip64) {
+            std::string fields;
+            put64(fields, consumed);
+            put64(fields, written);
+            file.seekp(static_cast<std::streamoff>(append_offset + 30 + name.size() + 4));
+            file.write(fields.data(), fields.size());
+        }
+        if (!file) {
+            throw std::runtime_error("写入ZIP条目失败: " + name);
+        }
+
+        append_offset += header.size() + written;
+        appendEntry(std::move(entry));
+    }
+
+    // 在追加的数据之后写出新的中央目录；没有任何追加时归档保持不变。
+    // 提交前出错（或对象被销毁）时截断回原大小，原归档不受影响
+    void commit() {
+        if (append_offset == original_size) {
+            committed = true;
+            file.close();
+            return;
+        }
+        dead_bytes += old_directory_bytes;
+        std::vector<const Entry*> list;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (live[i]) list.push_back(&entries[i]);
+        }
+        writeCentralDirectory(file, append_offset, list, archive_comment);
+        file.flush();
+        uint64_t end = static_cast<uint64_t>(file.tellp());
+        if (!file) {
+            throw std::runtime_error("写入ZIP中央目录失败: " + archive_path.string());
+        }
+        file.close();
+        fs::resize_file(archive_path, end);
+        committed = true;
+    }
+
+    uint64_t deadBytes() const {
+        return dead_bytes;
+    }
+
+    // 压缩整理：只复制中央目录引用的条目到新文件，回收死条目占用的空间，返回回收的字节数
+    static uint64_t compact(const fs::path& path) {
+        ZipUpdater source(path);
+        fs::path temp_path = path.string() + ".compact";
+        uint64_t old_size = fs::file_size(path);
+
+        std::fstream out(temp_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("无法创建临时文件: " + temp_path.string());
+        }
+
+        // 按原偏移顺序复制，保持顺序读
+        std::vector<Entry*> list;
+        for (size_t i = 0; i < source.entries.size(); i++) {
+            if (source.live[i]) list.push_back(&source.entries[i]);
+        }
+        std::vector<Entry*> by_offset = list;
+        std::sort(by_offset.begin(), by_offset.end(),
+                  [](const Entry* a, const Entry* b) { return a->offset < b->offset; });
+
+        uint64_t out_offset = 0;
+        std::vector<char> buffer(1024 * 1024);
+        for (Entry* entry : by_offset) {
+            uint64_t length = storedLength(source.file, *entry);
+            source.file.clear();
+            source.file.seekg(static_cast<std::streamoff>(entry->offset));
+            uint64_t remaining = length;
+            while (remaining > 0) {
+                size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, buffer.size()));
+                if (!source.file.read(buffer.data(), n)) {
+                    throw std::runtime_error("读取ZIP条目失败: " + entry->name);
+                }
+                out.write(buffer.data(), n);
+                remaining -= n;
+            }
+            entry->offset = out_offset;
+            out_offset += length;
+        }
+
+        std::vector<const Entry*> central(list.begin(), list.end());
+        writeCentralDirectory(out, out_offset, central, source.archive_comment);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("写入压缩整理后的ZIP失败: " + temp_path.string());
+        }
+        uint64_t new_size = static_cast<uint64_t>(out.tellp());
+        out.close();
+        source.file.close();
+
+        fs::rename(temp_path, path);
+        return old_size > new_size ? old_size - new_size : 0;
+    }
+};
+
 class ArchivePacker {
+public:
+    // 打包时读取文件的顺序
+    enum class ReadOrder {
+        DIRECTORY,  // 遍历顺序（默认，边遍历边打包）
+        INODE,      // 按inode号排序，多数文件系统上与分配位置大致一致
+        PHYSICAL    // 按FIEMAP得到的第一个物理区段排序，适合机械硬盘/RAID
+    };
+
 private:
+    // 取样大小：用于魔数识别和试压缩
+    static constexpr size_t SAMPLE_SIZE = 64 * 1024;
+    // 试压缩后体积仍高于此比例即视为不可压缩
+    static constexpr double INCOMPRESSIBLE_RATIO = 0.95;
+    
+    // 判断文件内容是否已经是压缩格式：先按魔数识别常见压缩/媒体格式，
+    // 无法识别时对开头的样本做一次快速DEFLATE试压缩
+    static bool isIncompressible(const fs::path& file_path, uint64_t size) {
+        if (size < 4096) {
+            return false;
+        }
+        
+        std::ifstream file(file_path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::vector<char> sample(static_cast<size_t>(std::min<uint64_t>(size, SAMPLE_SIZE)));
+        file.read(sample.data(), sample.size());
+        return isIncompressibleSample(sample.data(), static_cast<size_t>(file.gcount()), size);
+    }
+    
+    // 同上，使用已读入内存的文件开头部分作为样本
+    static bool isIncompressibleSample(const char* data, size_t length, uint64_t size) {
+        if (size < 4096 || length == 0) {
+            return false;
+        }
+        length = std::min(length, SAMPLE_SIZE);
+        
+        auto starts = [&](size_t offset, const char* magic, size_t len) {
+            return length >= offset + len && std::memcmp(data + offset, magic, len) == 0;
+        };
+        
+        if (starts(0, "\xFF\xD8\xFF", 3) ||              // JPEG
+            starts(0, "\x89PNG", 4) ||                    // PNG
+            starts(0, "GIF8", 4) ||                        // GIF
+            starts(0, "PK\x03\x04", 4) ||                  // ZIP/JAR/DOCX/APK
+            starts(0, "\x1F\x8B", 2) ||                    // GZIP
+            starts(0, "\xFD" "7zXZ\x00", 6) ||             // XZ
+            starts(0, "BZh", 3) ||                         // BZIP2
+            starts(0, "7z\xBC\xAF\x27\x1C", 6) ||          // 7Z
+            starts(0, "Rar!", 4) ||                        // RAR
+            starts(0, "\x28\xB5\x2F\xFD", 4) ||            // ZSTD
+            starts(4, "ftyp", 4) ||                        // MP4/MOV/HEIC
+            starts(0, "\x1A\x45\xDF\xA3", 4) ||            // MKV/WEBM
+            (starts(0, "RIFF", 4) && starts(8, "WEBP", 4)) ||
+            starts(0, "OggS", 4) ||                        // OGG
+            starts(0, "fLaC", 4) ||                        // FLAC
+            starts(0, "ID3", 3)) {                         // MP3
+            return true;
+        }
+        
+        uLongf compressed_size = compressBound(length);
+        std::vector<Bytef> compressed(compressed_size);
+        if (compress2(compressed.data(), &compressed_size,
+                      reinterpret_cast<const Bytef*>(data), length, 1) != Z_OK) {
+            return false;
+        }
+        return compressed_size >= length * INCOMPRESSIBLE_RATIO;
+    }
+    
+    // TAR.GZ输出：自行维护gzip流，已压缩的条目切换到存储级别（level 0），
+    // 其余条目使用默认级别，整个输出仍是一个标准gzip流
+    struct TarWriter {
+        struct archive* a = nullptr;
+        std::ofstream out;
+        z_stream zs{};
+        int level = Z_DEFAULT_COMPRESSION;
+        int default_level = 6;
+        std::vector<Bytef> buffer = std::vector<Bytef>(256 * 1024);
+        PackStats stats;
+        ReadOrder order = ReadOrder::DIRECTORY;
+        bool deduplicate = false;
+        DuplicateFinder duplicates;
+        std::map<std::string, size_t> entry_names;     // 去重时登记已写入的条目名及其次数
+    };
+    
+    static bool drainDeflate(TarWriter& tar, int flush) {
+        int ret;
+        do {
+            tar.zs.next_out = tar.buffer.data();
+            tar.zs.avail_out = static_cast<uInt>(tar.buffer.size());
+            ret = deflate(&tar.zs, flush);
+            if (ret == Z_STREAM_ERROR) {
+                return false;
+            }
+            tar.out.write(reinterpret_cast<const char*>(tar.buffer.data()),
+                          tar.buffer.size() - tar.zs.avail_out);
+        } while (tar.zs.avail_out == 0);
+        return ret != Z_STREAM_ERROR && static_cast<bool>(tar.out);
+    }
+    
+    static la_ssize_t tarWriteCallback(struct archive*, void* client_data, const void* buffer, size_t length) {
+        TarWriter& tar = *static_cast<TarWriter*>(client_data);
+        tar.zs.next_in = static_cast<Bytef*>(const_cast<void*>(buffer));
+        tar.zs.avail_in = static_cast<uInt>(length);
+        if (!drainDeflate(tar, Z_NO_FLUSH)) {
+            return -1;
+        }
+        return static_cast<la_ssize_t>(length);
+    }
+    
+    static int tarCloseCallback(struct archive*, void* client_data) {
+        TarWriter& tar = *static_cast<TarWriter*>(client_data);
+        tar.zs.avail_in = 0;
+        bool ok = drainDeflate(tar, Z_FINISH);
+        deflateEnd(&tar.zs);
+        tar.out.close();
+        return ok && tar.out ? ARCHIVE_OK : ARCHIVE_FATAL;
+    }
+    
+    // 切换压缩级别前先把已缓冲的数据刷出，保证级别只作用于之后写入的条目
+    static void setTarLevel(TarWriter& tar, int level) {
+        if (tar.level == level) {
+            return;
+        }
+        tar.zs.avail_in = 0;
+        drainDeflate(tar, Z_BLOCK);
+        tar.zs.next_out = tar.buffer.data();
+        tar.zs.avail_out = static_cast<uInt>(tar.buffer.size());
+        deflateParams(&tar.zs, level, Z_DEFAULT_STRATEGY);
+        tar.out.write(reinterpret_cast<const char*>(tar.buffer.data()),
+                      tar.buffer.size() - tar.zs.avail_out);
+        tar.level = level;
+    }
+    
+    static void printPackStats(const PackStats& stats) {
+        std::cout << "压缩 " << stats.compressed_files << " 个文件, 跳过重复压缩 "
+                  << stats.stored_files << " 个文件 (" << stats.stored_bytes << " 字节直接存储)" << std::endl;
+        if (stats.duplicate_files > 0) {
+            std::cout << "重复文件 " << stats.duplicate_files << " 个, 节省 "
+                      << stats.duplicate_bytes << " 字节" << std::endl;
+        }
+        if (stats.sparse_files > 0) {
+            std::cout << "稀疏文件 " << stats.sparse_files << " 个, 跳过空洞 "
+                      << stats.hole_bytes << " 字节" << std::endl;
+        }
+    }
+    
+    static void collectDuplicateStats(PackStats& stats, const DuplicateFinder& duplicates) {
+        stats.duplicate_files = duplicates.duplicateFiles();
+        stats.duplicate_bytes = duplicates.duplicateBytes();
+    }
+    
     // 检查路径是否在指定根目录下
     static bool isPathSafe(const fs::path& filepath, const fs::path& root) {
-        fs::path canonical_file = fs::canonical(filepath);
-        fs::path canonical_root = fs::canonical(root);
+        std::string canonical_file = fs::canonical(filepath).string();
+        std::string canonical_root = fs::canonical(root).string();
         
         // 检查文件路径是否以根路径开头
-        auto it = std::search(
-            canonical_file.string().begin(), canonical_file.string().end(),
-            canonical_root.string().begin(), canonical_root.string().end()
-        );
-        
-        return it == canonical_file.string().begin();
+        return canonical_file.compare(0, canonical_root.size(), canonical_root) == 0;
     }
 
 public:
@@ -36,24 +1477,120 @@ public:
     static void packZipFile(const std::string& file_path, 
                            const std::vector<std::string>& file_list,
                            const std::string& dst_path,
-                           const std::string& zip_name) {
+                           const std::string& zip_name,
+                           bool deduplicate = false) {
+        
+        fs::path output_path = fs::path(dst_path) / zip_name;
+        
+        try {
+            std::cout << "正在创建ZIP文件: " << output_path.string() << std::endl;
+            
+            // 创建ZIP文件
+            int error = 0;
+            zip_t* zip = zip_open(output_path.string().c_str(), ZIP_CREATE | ZIP_TRUNCATE, &error);
+            if (!zip) {
+                throw std::runtime_error("无法创建ZIP文件，错误代码: " + std::to_string(error));
+            }
+            
+            // 设置ZIP文件注释（可选）
+            zip_set_archive_comment(zip, "Created by ArchivePacker", 22);
+            
+            PackStats stats;
+            DuplicateFinder duplicates;
+            DuplicateFinder* finder = deduplicate ? &duplicates : nullptr;
+            
+            // 处理每个要打包的文件/目录
+            for (const auto& file : file_list) {
+                fs::path source_path = fs::path(file_path) / file;
+                
+                if (!fs::exists(source_path)) {
+                    std::cerr << "警告: 文件不存在: " << source_path.string() << std::endl;
+                    continue;
+                }
+                
+                // 安全检查
+                if (!isPathSafe(source_path, file_path)) {
+                    std::cerr << "警告: 不安全路径，跳过: " << source_path.string() << std::endl;
+                    continue;
+                }
+                
+                std::cout << "添加: " << source_path.string() << std::endl;
+                
+                if (fs::is_directory(source_path)) {
+                    // 递归添加目录
+                    addDirectoryToZip(zip, source_path, file_path, file, stats, finder);
+                } else {
+                    // 添加单个文件（内容重复时只添加指向原件的链接）
+                    WalkRecord record;
+                    record.path = source_path.string();
+                    record.relative_path = file;
+                    bool linked = finder && stat(record.path.c_str(), &record.st) == 0 &&
+                                  finder->check(record) && addDuplicateToZip(zip, record, *finder);
+                    if (!linked) {
+                        addFileToZip(zip, source_path, file_path, file, stats);
+                    }
+                }
+            }
+            
+            // 关闭ZIP文件
+            if (zip_close(zip) != 0) {
+                zip_discard(zip);
+                throw std::runtime_error("保存ZIP文件失败");
+            }
+            
+            std::cout << "ZIP打包完成: " << output_path.string() << std::endl;
+            collectDuplicateStats(stats, duplicates);
+            printPackStats(stats);
+            
+        } catch (const std::exception& e) {
+            std::cerr << "ZIP打包错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+    
+    // ZIP更新：已有归档中大小和修改时间未变的文件跳过，新增或变化的文件追加到归档末尾，
+    // 只重写中央目录；归档不存在时等同于packZipFile
+    static void updateZipFile(const std::string& file_path,
+                             const std::vector<std::string>& file_list,
+                             const std::string& dst_path,
+                             const std::string& zip_name) {
         
         fs::path output_path = fs::path(dst_path) / zip_name;
+        if (!fs::exists(output_path)) {
+            packZipFile(file_path, file_list, dst_path, zip_name);
+            return;
+        }
         
         try {
-            std::cout << "正在创建ZIP文件: " << output_path.string() << std::endl;
+            std::cout << "正在更新ZIP文件: " << output_path.string() << std::endl;
             
-            // 创建ZIP文件
-            int error = 0;
-            zip_t* zip = zip_open(output_path.string().c_str(), ZIP_CREATE | ZIP_TRUNCATE, &error);
-            if (!zip) {
-                throw std::runtime_error("无法创建ZIP文件，错误代码: " + std::to_string(error));
-            }
+            ZipUpdater updater(output_path);
+            PackStats stats;
+            size_t unchanged = 0;
             
-            // 设置ZIP文件注释（可选）
-            zip_set_archive_comment(zip, "Created by ArchivePacker", 22);
+            auto update = [&](const std::string& path, const std::string& name, const struct stat& st) {
+                if (S_ISDIR(st.st_mode)) {
+                    if (!updater.contains(name + "/")) {
+                        updater.addEntry(path, name + "/", st, true);
+                    }
+                    return;
+                }
+                if (updater.isUnchanged(name, st)) {
+                    unchanged++;
+                    return;
+                }
+                bool store = isIncompressible(path, st.st_size);
+                updater.addEntry(path, name, st, store);
+                if (store) {
+                    stats.stored_files++;
+                    stats.stored_bytes += st.st_size;
+                } else {
+                    stats.compressed_files++;
+                }
+                std::cout << "  -> ZIP追加: " << name 
+                          << " (" << st.st_size << " 字节" << (store ? ", 存储" : "") << ")" << std::endl;
+            };
             
-            // 处理每个要打包的文件/目录
             for (const auto& file : file_list) {
                 fs::path source_path = fs::path(file_path) / file;
                 
@@ -68,27 +1605,49 @@ public:
                     continue;
                 }
                 
-                std::cout << "添加: " << source_path.string() << std::endl;
+                struct stat st;
+                if (stat(source_path.c_str(), &st) != 0) {
+                    continue;
+                }
+                update(source_path.string(), file, st);
                 
-                if (fs::is_directory(source_path)) {
-                    // 递归添加目录
-                    addDirectoryToZip(zip, source_path, file_path, file);
-                } else {
-                    // 添加单个文件
-                    addFileToZip(zip, source_path, file_path, file);
+                if (S_ISDIR(st.st_mode)) {
+                    ParallelWalker walker(source_path, file);
+                    WalkRecord record;
+                    while (walker.next(record)) {
+                        // 符号链接按其指向的目标处理
+                        if (S_ISLNK(record.st.st_mode) && stat(record.path.c_str(), &record.st) != 0) {
+                            continue;
+                        }
+                        if (S_ISDIR(record.st.st_mode) || S_ISREG(record.st.st_mode)) {
+                            update(record.path, record.relative_path, record.st);
+                        }
+                    }
                 }
             }
             
-            // 关闭ZIP文件
-            if (zip_close(zip) != 0) {
-                zip_discard(zip);
-                throw std::runtime_error("保存ZIP文件失败");
-            }
+            updater.commit();
             
-            std::cout << "ZIP打包完成: " << output_path.string() << std::endl;
+            std::cout << "ZIP更新完成: " << output_path.string() << " (未变化 " << unchanged
+                      << " 个文件, 新增死条目 " << updater.deadBytes() << " 字节)" << std::endl;
+            printPackStats(stats);
             
         } catch (const std::exception& e) {
-            std::cerr << "ZIP打包错误: " << e.what() << std::endl;
+            std::cerr << "ZIP更新错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+    
+    // ZIP压缩整理：去掉更新后遗留的死条目
+    static void compactZipFile(const std::string& dst_path, const std::string& zip_name) {
+        fs::path output_path = fs::path(dst_path) / zip_name;
+        
+        try {
+            uint64_t reclaimed = ZipUpdater::compact(output_path);
+            std::cout << "ZIP整理完成: " << output_path.string()
+                      << " (回收 " << reclaimed << " 字节)" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "ZIP整理错误: " << e.what() << std::endl;
             throw;
         }
     }
@@ -96,7 +1655,8 @@ public:
 private:
     // 递归添加目录到ZIP
     static void addDirectoryToZip(zip_t* zip, const fs::path& dir_path,
-                                 const fs::path& base_path, const std::string& relative_path) {
+                                 const fs::path& base_path, const std::string& relative_path,
+                                 PackStats& stats, DuplicateFinder* duplicates) {
         
         // 在ZIP中创建目录条目
         std::string zip_dir_path = relative_path + "/";
@@ -114,12 +1674,18 @@ private:
         // 设置目录属性
         zip_set_file_compression(zip, index, ZIP_CM_DEFAULT, 0);
         
-        // 递归处理目录内容
-        for (const auto& entry : fs::recursive_directory_iterator(dir_path)) {
-            if (fs::is_directory(entry)) {
+        // 并行遍历目录内容，遍历与添加条目同时进行
+        ParallelWalker walker(dir_path, relative_path);
+        WalkRecord record;
+        while (walker.next(record)) {
+            // 符号链接按其指向的目标处理
+            if (S_ISLNK(record.st.st_mode) && stat(record.path.c_str(), &record.st) != 0) {
+                continue;
+            }
+
+            if (S_ISDIR(record.st.st_mode)) {
                 // 创建子目录
-                fs::path rel_path = fs::relative(entry.path(), base_path);
-                std::string zip_entry_path = rel_path.string() + "/";
+                std::string zip_entry_path = record.relative_path + "/";
                 
                 zip_source_t* dir_source = zip_source_buffer(zip, nullptr, 0, 0);
                 if (dir_source) {
@@ -130,34 +1696,70 @@ private:
                         zip_source_free(dir_source);
                     }
                 }
-            } else if (fs::is_regular_file(entry)) {
-                // 添加文件
-                fs::path rel_path = fs::relative(entry.path(), base_path);
-                addFileToZip(zip, entry.path(), base_path, rel_path.string());
+            } else if (S_ISREG(record.st.st_mode)) {
+                // 添加文件；内容重复的文件只添加指向原件的链接
+                if (!duplicates || !duplicates->check(record) || !addDuplicateToZip(zip, record, *duplicates)) {
+                    addFileToZip(zip, record.path, base_path, record.relative_path, stats);
+                }
             }
         }
     }
     
-    // 添加单个文件到ZIP
-    static void addFileToZip(zip_t* zip, const fs::path& file_path,
-                            const fs::path& base_path, const std::string& relative_path) {
+    // 重复文件添加为指向原件的链接；原件不在归档中时（未能添加）撤销重复标记并返回false，
+    // 由调用者照常添加文件本身
+    static bool addDuplicateToZip(zip_t* zip, WalkRecord& record, DuplicateFinder& duplicates) {
+        if (zip_name_locate(zip, record.duplicate_of.c_str(), 0) < 0) {
+            std::cerr << "警告: 原件不在归档中，改为保存完整内容: " << record.path << std::endl;
+            duplicates.keep(record);
+            return false;
+        }
+        addLinkToZip(zip, record.relative_path, record.duplicate_of);
+        return true;
+    }
+    
+    // 添加指向已保存文件的符号链接条目（Unix扩展属性，内容为相对路径），用于重复文件
+    static void addLinkToZip(zip_t* zip, const std::string& relative_path, const std::string& target_path) {
+        std::string target = fs::path(target_path).lexically_relative(
+            fs::path(relative_path).parent_path()).generic_string();
         
-        // 读取文件内容
-        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
-        if (!file.is_open()) {
-            throw std::runtime_error("无法打开文件: " + file_path.string());
+        // 缓冲区交给libzip在zip_close后释放
+        void* data = malloc(target.size());
+        if (!data) {
+            throw std::bad_alloc();
+        }
+        memcpy(data, target.data(), target.size());
+        zip_source_t* source = zip_source_buffer(zip, data, target.size(), 1);
+        if (!source) {
+            free(data);
+            throw std::runtime_error("无法创建ZIP源: " + relative_path);
+        }
+        
+        zip_int64_t index = zip_file_add(zip, relative_path.c_str(), source, ZIP_FL_OVERWRITE);
+        if (index < 0) {
+            zip_source_free(source);
+            throw std::runtime_error("无法添加文件到ZIP: " + relative_path);
         }
         
-        std::streamsize size = file.tellg();
-        file.seekg(0, std::ios::beg);
+        zip_set_file_compression(zip, index, ZIP_CM_STORE, 0);
+        zip_file_set_external_attributes(zip, index, 0, ZIP_OPSYS_UNIX,
+                                         static_cast<zip_uint32_t>(S_IFLNK | 0777) << 16);
         
-        std::vector<char> buffer(size);
-        if (!file.read(buffer.data(), size)) {
-            throw std::runtime_error("读取文件失败: " + file_path.string());
+        std::cout << "  -> ZIP链接: " << relative_path << " => " << target << std::endl;
+    }
+    
+    // 添加单个文件到ZIP
+    static void addFileToZip(zip_t* zip, const fs::path& file_path,
+                            const fs::path& base_path, const std::string& relative_path,
+                            PackStats& stats) {
+        
+        std::error_code ec;
+        uint64_t size = fs::file_size(file_path, ec);
+        if (ec) {
+            throw std::runtime_error("无法打开文件: " + file_path.string());
         }
         
-        // 创建ZIP源
-        zip_source_t* source = zip_source_buffer(zip, buffer.data(), size, 0);
+        // 创建ZIP源（由libzip在zip_close时直接读取文件）
+        zip_source_t* source = zip_source_file(zip, file_path.string().c_str(), 0, ZIP_LENGTH_TO_END);
         if (!source) {
             throw std::runtime_error("无法创建ZIP源: " + relative_path);
         }
@@ -168,40 +1770,457 @@ private:
             zip_source_free(source);
             throw std::runtime_error("无法添加文件到ZIP: " + relative_path);
         }
-        
-        // 设置压缩方式（DEFLATE）
-        zip_set_file_compression(zip, index, ZIP_CM_DEFLATE, 6);
-        
-        std::cout << "  -> ZIP添加: " << relative_path 
-                  << " (" << size << " 字节)" << std::endl;
+        
+        // 设置压缩方式：已压缩的内容直接存储，其余使用DEFLATE
+        bool store = isIncompressible(file_path, size);
+        if (store) {
+            zip_set_file_compression(zip, index, ZIP_CM_STORE, 0);
+            stats.stored_files++;
+            stats.stored_bytes += size;
+        } else {
+            zip_set_file_compression(zip, index, ZIP_CM_DEFLATE, 6);
+            stats.compressed_files++;
+        }
+        
+        std::cout << "  -> ZIP添加: " << relative_path 
+                  << " (" << size << " 字节" << (store ? ", 存储" : "") << ")" << std::endl;
+    }
+
+public:
+    // TAR.GZ打包
+    static void packTarFile(const std::string& file_path,
+                           const std::vector<std::string>& file_list,
+                           const std::string& dst_path,
+                           const std::string& tgz_name,
+                           bool recursive = true,
+                           ReadOrder order = ReadOrder::DIRECTORY,
+                           bool deduplicate = false) {
+        
+        fs::path output_path = fs::path(dst_path) / tgz_name;
+        
+        try {
+            std::cout << "正在创建TAR.GZ文件: " << output_path.string() << std::endl;
+            
+            // 打开输出文件和gzip流（windowBits加16表示写gzip头）
+            TarWriter tar;
+            tar.out.open(output_path, std::ios::binary);
+            if (!tar.out.is_open() ||
+                deflateInit2(&tar.zs, tar.default_level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("无法创建TAR.GZ文件");
+            }
+            tar.level = tar.default_level;
+            tar.order = order;
+            tar.deduplicate = deduplicate;
+            
+            // 创建归档对象；不做块缓冲，使每个条目的数据按其级别进入gzip流
+            struct archive* a = archive_write_new();
+            tar.a = a;
+            archive_write_set_format_pax_restricted(a);  // PAX格式
+            archive_write_set_bytes_per_block(a, 0);
+            
+            if (archive_write_open(a, &tar, nullptr, tarWriteCallback, tarCloseCallback) != ARCHIVE_OK) {
+                archive_write_free(a);
+                throw std::runtime_error("无法创建TAR.GZ文件");
+            }
+            
+            // 处理每个要打包的文件/目录
+            size_t total_files = 0;
+            for (const auto& file : file_list) {
+                fs::path source_path = fs::path(file_path) / file;
+                
+                if (!fs::exists(source_path)) {
+                    std::cerr << "警告: 文件不存在: " << source_path.string() << std::endl;
+                    continue;
+                }
+                
+                // 安全检查
+                if (!isPathSafe(source_path, file_path)) {
+                    std::cerr << "警告: 不安全路径，跳过: " << source_path.string() << std::endl;
+                    continue;
+                }
+                
+                std::cout << "添加: " << source_path.string() << std::endl;
+                
+                if (recursive) {
+                    // 递归添加目录
+                    total_files += addDirectoryToTar(tar, source_path, file_path, file);
+                } else {
+                    // 仅添加第一级
+                    total_files += addFileOrDirToTar(tar, source_path, file_path, file);
+                }
+            }
+            
+            // 关闭归档
+            archive_write_close(a);
+            archive_write_free(a);
+            
+            std::cout << "TAR.GZ打包完成: " << output_path.string() 
+                      << " (共 " << total_files << " 个文件)" << std::endl;
+            collectDuplicateStats(tar.stats, tar.duplicates);
+            printPackStats(tar.stats);
+            
+        } catch (const std::exception& e) {
+            std::cerr << "TAR打包错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+private:
+    // 递归添加目录到TAR
+    static size_t addDirectoryToTar(TarWriter& tar, const fs::path& dir_path,
+                                   const fs::path& base_path, const std::string& relative_path) {
+        
+        size_t file_count = 0;
+        
+        // 添加目录条目本身
+        if (addFileOrDirToTar(tar, dir_path, base_path, relative_path)) {
+            file_count++;
+        }
+        
+        // 并行遍历目录内容，文件由预读管线读出，遍历、读取与压缩同时进行；
+        // 指定了物理顺序时先收集完整列表再排序，以减少磁盘寻道
+        ParallelWalker walker(dir_path, relative_path);
+        std::vector<WalkRecord> ordered;
+        size_t next_record = 0;
+        if (tar.order != ReadOrder::DIRECTORY) {
+            WalkRecord record;
+            while (walker.next(record)) {
+                if (!S_ISLNK(record.st.st_mode)) ordered.push_back(std::move(record));
+            }
+            sortByDiskLayout(ordered, tar.order);
+        }
+        
+        // 重复文件在读取前识别，之后只写硬链接条目，不再读取内容
+        ReadAheadPipeline pipeline([&](WalkRecord& record) {
+            bool found = false;
+            if (tar.order != ReadOrder::DIRECTORY) {
+                if (next_record < ordered.size()) {
+                    record = std::move(ordered[next_record++]);
+                    found = true;
+                }
+            } else {
+                while (walker.next(record)) {
+                    if (!S_ISLNK(record.st.st_mode)) {
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            if (found && tar.deduplicate) {
+                tar.duplicates.check(record);
+                reserveTarName(tar, record);
+            }
+            return found;
+        }, true);
+        
+        ReadBlock block;
+        bool writing = false;
+        bool sparse = false;
+        uint64_t position = 0, size = 0;
+        while (pipeline.next(block)) {
+            if (block.first) {
+                writing = false;
+                if (block.error) {
+                    continue;
+                }
+                const WalkRecord& record = block.record;
+                bool store = S_ISREG(record.st.st_mode) &&
+                             isIncompressibleSample(block.data.data(), block.data.size(), record.st.st_size);
+                writing = writeTarHeader(tar, record.path, record.relative_path, record.st, store,
+                                         record.duplicate_of, block.sparse ? &block.sparse_map : nullptr);
+                if (writing) {
+                    file_count++;
+                }
+                sparse = block.sparse;
+                position = 0;
+                size = static_cast<uint64_t>(record.st.st_size);
+            }
+            if (!writing) {
+                continue;
+            }
+            
+            // 稀疏文件：空洞部分由libarchive按稀疏表跳过，这里只需补齐逻辑偏移
+            if (sparse && block.offset > position) {
+                writeTarZeros(tar, block.offset - position);
+                position = block.offset;
+            }
+            if (!block.data.empty()) {
+                archive_write_data(tar.a, block.data.data(), block.data.size());
+                position += block.data.size();
+            }
+            if (sparse && block.last && position < size) {
+                writeTarZeros(tar, size - position);
+                position = size;
+            }
+        }
+        
+        return file_count;
+    }
+    
+    // 取文件第一个区段的物理偏移；不支持FIEMAP或没有区段（空文件、内联数据）时返回0
+    static uint64_t firstPhysicalOffset(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return 0;
+        }
+        
+        alignas(struct fiemap) char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+        auto* map = reinterpret_cast<struct fiemap*>(buffer);
+        map->fm_start = 0;
+        map->fm_length = FIEMAP_MAX_OFFSET;
+        map->fm_extent_count = 1;
+        
+        uint64_t physical = 0;
+        if (ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0) {
+            physical = map->fm_extents[0].fe_physical;
+        }
+        close(fd);
+        return physical;
+    }
+    
+    // 按磁盘布局排序；归档中的条目以路径标识，读取顺序不影响解包结果
+    static void sortByDiskLayout(std::vector<WalkRecord>& records, ReadOrder order) {
+        std::vector<std::pair<uint64_t, size_t>> keys;
+        keys.reserve(records.size());
+        for (size_t i = 0; i < records.size(); i++) {
+            const struct stat& st = records[i].st;
+            uint64_t key = st.st_ino;
+            if (order == ReadOrder::PHYSICAL) {
+                key = S_ISREG(st.st_mode) && st.st_size > 0 ? firstPhysicalOffset(records[i].path) : 0;
+            }
+            keys.emplace_back(key, i);
+        }
+        std::sort(keys.begin(), keys.end());
+        
+        std::vector<WalkRecord> sorted;
+        sorted.reserve(records.size());
+        for (const auto& key : keys) {
+            sorted.push_back(std::move(records[key.second]));
+        }
+        records.swap(sorted);
+        
+        std::cout << "  已按" << (order == ReadOrder::PHYSICAL ? "物理区段" : "inode")
+                  << "排序 " << records.size() << " 个条目" << std::endl;
+    }
+    
+    // 添加文件或目录到TAR
+    static bool addFileOrDirToTar(TarWriter& tar, const fs::path& entry_path,
+                                 const fs::path& base_path, const std::string& relative_path) {
+        
+        // 获取文件状态
+        struct stat st;
+        if (stat(entry_path.string().c_str(), &st) != 0) {
+            return false;
+        }
+        
+        return writeTarEntry(tar, entry_path, relative_path, st);
+    }
+    
+    // TAR条目名只取文件名（与原始Python代码一致）
+    static std::string tarEntryName(const std::string& relative_path) {
+        return fs::path(relative_path).filename().string();
+    }
+    
+    // 按写入顺序登记条目名。硬链接按名称指向原件，解包时链接到最后写入的同名条目，
+    // 因此原件名此前不唯一或与重复文件自身同名时放弃硬链接，改为写入完整数据
+    static void reserveTarName(TarWriter& tar, WalkRecord& record) {
+        std::string name = tarEntryName(record.relative_path);
+        if (!record.duplicate_of.empty()) {
+            std::string original = tarEntryName(record.duplicate_of);
+            if (original == name || tar.entry_names[original] != 1) {
+                tar.duplicates.keep(record);
+            }
+        }
+        tar.entry_names[name]++;
+    }
+    
+    // 使用已获取的文件状态写入TAR条目
+    static bool writeTarEntry(TarWriter& tar, const fs::path& entry_path,
+                             const std::string& relative_path, const struct stat& st) {
+        
+        if (tar.deduplicate) {
+            tar.entry_names[tarEntryName(relative_path)]++;
+        }
+        
+        if (!S_ISREG(st.st_mode)) {
+            return writeTarHeader(tar, entry_path, relative_path, st, false);
+        }
+        
+        int fd = open(entry_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            std::cerr << "警告: 无法打开文件: " << entry_path.string() << std::endl;
+            return false;
+        }
+        
+        // 只读取已分配的数据区，空洞以零补齐逻辑偏移（不产生读取）
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        std::vector<std::pair<uint64_t, uint64_t>> regions;
+        bool sparse = maybeSparse(st) && findDataRegions(fd, size, regions);
+        if (!sparse) {
+            regions.assign(1, {0, size});
+        }
+        
+        bool store = isIncompressible(entry_path, st.st_size);
+        if (!writeTarHeader(tar, entry_path, relative_path, st, store, std::string(),
+                            sparse ? &regions : nullptr)) {
+            close(fd);
+            return false;
+        }
+        
+        std::vector<char> buffer(1024 * 1024);
+        uint64_t position = 0;
+        for (const auto& region : regions) {
+            if (region.first > position) {
+                writeTarZeros(tar, region.first - position);
+            }
+            position = region.first;
+            uint64_t end = region.first + region.second;
+            while (position < end) {
+                ssize_t n = pread(fd, buffer.data(), static_cast<size_t>(std::min<uint64_t>(end - position, buffer.size())),
+                                  static_cast<off_t>(position));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) break;
+                archive_write_data(tar.a, buffer.data(), static_cast<size_t>(n));
+                position += static_cast<uint64_t>(n);
+            }
+            if (position < end) break;  // 文件被截断
+        }
+        if (sparse && position < size) {
+            writeTarZeros(tar, size - position);
+        }
+        
+        close(fd);
+        return true;
+    }
+    
+    // 写入一段零数据以推进稀疏条目的逻辑偏移；这些字节落在空洞中，不会写入归档
+    static void writeTarZeros(TarWriter& tar, uint64_t length) {
+        static const std::vector<char> zeros(1024 * 1024, 0);
+        while (length > 0) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(length, zeros.size()));
+            archive_write_data(tar.a, zeros.data(), n);
+            length -= n;
+        }
+    }
+    
+    // 写入TAR条目头部，文件内容由调用者随后写入；hardlink非空时写为指向该条目的硬链接
+    static bool writeTarHeader(TarWriter& tar, const fs::path& entry_path,
+                              const std::string& relative_path, const struct stat& st, bool store,
+                              const std::string& hardlink = std::string(),
+                              const std::vector<std::pair<uint64_t, uint64_t>>* sparse_map = nullptr) {
+        
+        struct archive* a = tar.a;
+        
+        // 已压缩的文件以存储级别写入（条目头部也一并写入，连续的媒体文件无需来回切换）
+        setTarLevel(tar, store ? 0 : tar.default_level);
+        if (S_ISREG(st.st_mode) && hardlink.empty()) {
+            if (store) {
+                tar.stats.stored_files++;
+                tar.stats.stored_bytes += st.st_size;
+            } else {
+                tar.stats.compressed_files++;
+            }
+        }
+        
+        // 创建归档条目
+        struct archive_entry* entry = archive_entry_new();
+        if (!entry) {
+            return false;
+        }
+        
+        try {
+            // 设置条目名称（使用基本文件名或完整路径）
+            // 根据原始Python代码的行为，这里使用基本文件名
+            std::string entry_name = tarEntryName(relative_path);
+            archive_entry_set_pathname(entry, entry_name.c_str());
+            
+            // 设置条目属性
+            archive_entry_copy_stat(entry, &st);
+            
+            // 处理符号链接
+            if (S_ISLNK(st.st_mode)) {
+                char link_target[1024];
+                ssize_t len = readlink(entry_path.string().c_str(), link_target, sizeof(link_target) - 1);
+                if (len > 0) {
+                    link_target[len] = '\0';
+                    archive_entry_set_symlink(entry, link_target);
+                }
+            }
+            
+            // 稀疏文件写为PAX稀疏条目，归档中只保存数据区；末尾的零长度区段标记文件结尾的空洞
+            if (sparse_map && hardlink.empty()) {
+                uint64_t allocated = 0;
+                for (const auto& region : *sparse_map) {
+                    archive_entry_sparse_add_entry(entry, region.first, region.second);
+                    allocated += region.second;
+                }
+                archive_entry_sparse_add_entry(entry, st.st_size, 0);
+                tar.stats.sparse_files++;
+                tar.stats.hole_bytes += st.st_size - allocated;
+            }
+            
+            // 重复文件：硬链接条目没有数据，目标使用与条目相同的命名方式
+            std::string link_name = tarEntryName(hardlink);
+            if (!hardlink.empty()) {
+                archive_entry_set_hardlink(entry, link_name.c_str());
+                archive_entry_set_size(entry, 0);
+            }
+            
+            // 写入条目头部
+            if (archive_write_header(a, entry) != ARCHIVE_OK) {
+                archive_entry_free(entry);
+                return false;
+            }
+            
+            if (hardlink.empty()) {
+                std::cout << "  -> TAR添加: " << entry_name 
+                          << " (" << st.st_size << " 字节)" << std::endl;
+            } else {
+                std::cout << "  -> TAR链接: " << entry_name << " => " << link_name << std::endl;
+            }
+            
+            archive_entry_free(entry);
+            return true;
+            
+        } catch (...) {
+            archive_entry_free(entry);
+            throw;
+        }
     }
 
 public:
-    // TAR.GZ打包
-    static void packTarFile(const std::string& file_path,
-                           const std::vector<std::string>& file_list,
-                           const std::string& dst_path,
-                           const std::string& tgz_name,
-                           bool recursive = true) {
+    // 固实打包：所有文件按扩展名排序后首尾相接，切分为固定大小的块分别用xz压缩，
+    // 小文件因此获得大块的压缩率；文件尾部的索引记录每个文件在数据流中的偏移，
+    // 解压单个文件时只需解码它所在的块
+    //
+    // 文件布局（整数均为小端）：
+    //   头部    "SOLIDARC" | u32 版本 | u32 块大小
+    //   数据块  每块一个独立的xz流
+    //   索引    u64 块数 | {u64 偏移, u64 压缩大小, u64 原始大小}...
+    //           u64 条目数 | {u32 路径长度, 路径, u32 mode, i64 mtime, u64 大小, u64 数据流偏移}...
+    //   尾部    u64 索引偏移 | "SOLIDEND"
+    static constexpr uint32_t SOLID_VERSION = 1;
+    static constexpr size_t SOLID_MIN_BLOCK = 4 * 1024 * 1024;
+    static constexpr size_t SOLID_MAX_BLOCK = 64 * 1024 * 1024;
+    static constexpr size_t SOLID_DEFAULT_BLOCK = 16 * 1024 * 1024;
+
+    static void packSolidFile(const std::string& file_path,
+                             const std::vector<std::string>& file_list,
+                             const std::string& dst_path,
+                             const std::string& solid_name,
+                             size_t block_size = SOLID_DEFAULT_BLOCK,
+                             uint32_t preset = 6,
+                             bool deduplicate = false) {
         
-        fs::path output_path = fs::path(dst_path) / tgz_name;
+        fs::path output_path = fs::path(dst_path) / solid_name;
+        block_size = std::clamp(block_size, SOLID_MIN_BLOCK, SOLID_MAX_BLOCK);
         
         try {
-            std::cout << "正在创建TAR.GZ文件: " << output_path.string() << std::endl;
+            std::cout << "正在创建固实归档: " << output_path.string()
+                      << " (块大小 " << block_size / (1024 * 1024) << " MiB)" << std::endl;
             
-            // 创建归档对象
-            struct archive* a = archive_write_new();
-            archive_write_set_format_pax_restricted(a);  // PAX格式
-            archive_write_add_filter_gzip(a);            // GZIP压缩
-            
-            // 打开输出文件
-            if (archive_write_open_filename(a, output_path.string().c_str()) != ARCHIVE_OK) {
-                archive_write_free(a);
-                throw std::runtime_error("无法创建TAR.GZ文件");
-            }
-            
-            // 处理每个要打包的文件/目录
-            size_t total_files = 0;
+            // 收集所有条目
+            std::vector<WalkRecord> records;
             for (const auto& file : file_list) {
                 fs::path source_path = fs::path(file_path) / file;
                 
@@ -216,118 +2235,797 @@ public:
                     continue;
                 }
                 
-                std::cout << "添加: " << source_path.string() << std::endl;
+                WalkRecord root;
+                root.path = source_path.string();
+                root.relative_path = file;
+                if (stat(root.path.c_str(), &root.st) != 0) {
+                    continue;
+                }
+                records.push_back(root);
                 
-                if (recursive) {
-                    // 递归添加目录
-                    total_files += addDirectoryToTar(a, source_path, file_path, file);
-                } else {
-                    // 仅添加第一级
-                    total_files += addFileOrDirToTar(a, source_path, file_path, file);
+                if (S_ISDIR(root.st.st_mode)) {
+                    ParallelWalker walker(source_path, file);
+                    WalkRecord record;
+                    while (walker.next(record)) {
+                        // 符号链接按其指向的目标处理
+                        if (S_ISLNK(record.st.st_mode) && stat(record.path.c_str(), &record.st) != 0) {
+                            continue;
+                        }
+                        if (S_ISDIR(record.st.st_mode) || S_ISREG(record.st.st_mode)) {
+                            records.push_back(std::move(record));
+                        }
+                    }
                 }
             }
             
-            // 关闭归档
-            archive_write_close(a);
-            archive_write_free(a);
+            // 目录在前；文件按扩展名、文件名排序，使相似内容落在同一块中
+            std::sort(records.begin(), records.end(), [](const WalkRecord& a, const WalkRecord& b) {
+                bool a_dir = S_ISDIR(a.st.st_mode), b_dir = S_ISDIR(b.st.st_mode);
+                if (a_dir != b_dir) return a_dir;
+                if (a_dir) return a.relative_path < b.relative_path;
+                std::string a_ext = fs::path(a.relative_path).extension().string();
+                std::string b_ext = fs::path(b.relative_path).extension().string();
+                if (a_ext != b_ext) return a_ext < b_ext;
+                std::string a_name = fs::path(a.relative_path).filename().string();
+                std::string b_name = fs::path(b.relative_path).filename().string();
+                if (a_name != b_name) return a_name < b_name;
+                return a.relative_path < b.relative_path;
+            });
             
-            std::cout << "TAR.GZ打包完成: " << output_path.string() 
-                      << " (共 " << total_files << " 个文件)" << std::endl;
+            std::ofstream out(output_path, std::ios::binary);
+            if (!out.is_open()) {
+                throw std::runtime_error("无法创建固实归档: " + output_path.string());
+            }
+            out.write("SOLIDARC", 8);
+            writeLE(out, SOLID_VERSION, 4);
+            writeLE(out, block_size, 4);
+            
+            std::vector<SolidBlock> blocks;
+            std::vector<SolidEntry> entries;
+            std::vector<uint8_t> block;
+            block.reserve(block_size);
+            uint64_t stream_offset = 0;
+            
+            // 按排序后的顺序预读文件内容；重复文件不读取，索引直接引用原件的数据范围
+            DuplicateFinder duplicates;
+            std::map<std::string, size_t> entry_index;
+            size_t next_record = 0;
+            ReadAheadPipeline pipeline([&](WalkRecord& record) {
+                if (next_record >= records.size()) return false;
+                record = records[next_record++];
+                if (deduplicate) {
+                    duplicates.check(record);
+                }
+                return true;
+            });
+            
+            ReadBlock read_block;
+            SolidEntry entry;
+            while (pipeline.next(read_block)) {
+                if (read_block.first) {
+                    entry.path = read_block.record.relative_path;
+                    entry.mode = read_block.record.st.st_mode;
+                    entry.mtime = read_block.record.st.st_mtime;
+                    entry.offset = stream_offset;
+                    entry.size = 0;
+                    
+                    auto original = entry_index.find(read_block.record.duplicate_of);
+                    if (!read_block.record.duplicate_of.empty() && original != entry_index.end()) {
+                        entry.offset = entries[original->second].offset;
+                        entry.size = entries[original->second].size;
+                        entries.push_back(entry);
+                        continue;
+                    }
+                }
+                if (read_block.error) {
+                    continue;
+                }
+                
+                const char* data = read_block.data.data();
+                size_t remaining = read_block.data.size();
+                while (remaining > 0) {
+                    size_t n = std::min(remaining, block_size - block.size());
+                    block.insert(block.end(), data, data + n);
+                    data += n;
+                    remaining -= n;
+                    entry.size += n;
+                    if (block.size() == block_size) {
+                        blocks.push_back(writeSolidBlock(out, block, preset));
+                        block.clear();
+                    }
+                }
+                
+                if (read_block.last) {
+                    stream_offset += entry.size;
+                    entry_index[entry.path] = entries.size();
+                    entries.push_back(entry);
+                }
+            }
+            if (!block.empty()) {
+                blocks.push_back(writeSolidBlock(out, block, preset));
+            }
+            
+            // 写入索引和尾部
+            uint64_t index_offset = static_cast<uint64_t>(out.tellp());
+            writeLE(out, blocks.size(), 8);
+            for (const auto& b : blocks) {
+                writeLE(out, b.offset, 8);
+                writeLE(out, b.compressed_size, 8);
+                writeLE(out, b.raw_size, 8);
+            }
+            writeLE(out, entries.size(), 8);
+            for (const auto& e : entries) {
+                writeLE(out, e.path.size(), 4);
+                out.write(e.path.data(), e.path.size());
+                writeLE(out, e.mode, 4);
+                writeLE(out, static_cast<uint64_t>(e.mtime), 8);
+                writeLE(out, e.size, 8);
+                writeLE(out, e.offset, 8);
+            }
+            writeLE(out, index_offset, 8);
+            out.write("SOLIDEND", 8);
+            
+            if (!out) {
+                throw std::runtime_error("写入固实归档失败: " + output_path.string());
+            }
+            
+            std::cout << "固实打包完成: " << output_path.string()
+                      << " (共 " << entries.size() << " 个条目, " << blocks.size() << " 个块, "
+                      << stream_offset << " -> " << index_offset << " 字节)" << std::endl;
+            if (duplicates.duplicateFiles() > 0) {
+                std::cout << "重复文件 " << duplicates.duplicateFiles() << " 个, 节省 "
+                          << duplicates.duplicateBytes() << " 字节" << std::endl;
+            }
             
         } catch (const std::exception& e) {
-            std::cerr << "TAR打包错误: " << e.what() << std::endl;
+            std::cerr << "固实打包错误: " << e.what() << std::endl;
             throw;
         }
     }
 
 private:
-    // 递归添加目录到TAR
-    static size_t addDirectoryToTar(struct archive* a, const fs::path& dir_path,
-                                   const fs::path& base_path, const std::string& relative_path) {
+    struct SolidBlock {
+        uint64_t offset;
+        uint64_t compressed_size;
+        uint64_t raw_size;
+    };
+    
+    struct SolidEntry {
+        std::string path;
+        uint32_t mode;
+        int64_t mtime;
+        uint64_t size;
+        uint64_t offset;   // 在未压缩数据流中的偏移
+    };
+    
+    static void writeLE(std::ofstream& out, uint64_t value, int bytes) {
+        char buf[8];
+        for (int i = 0; i < bytes; i++) {
+            buf[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+        out.write(buf, bytes);
+    }
+    
+    // 将一个块压缩为独立的xz流
+    static std::vector<uint8_t> compressSolidBlock(const std::vector<uint8_t>& block, uint32_t preset) {
+        std::vector<uint8_t> compressed(lzma_stream_buffer_bound(block.size()));
+        size_t out_pos = 0;
+        lzma_ret ret = lzma_easy_buffer_encode(preset, LZMA_CHECK_CRC32, nullptr,
+                                               block.data(), block.size(),
+                                               compressed.data(), &out_pos, compressed.size());
+        if (ret != LZMA_OK) {
+            throw std::runtime_error("块压缩失败，错误代码: " + std::to_string(ret));
+        }
+        compressed.resize(out_pos);
+        return compressed;
+    }
+    
+    // 压缩一个块并写出
+    static SolidBlock writeSolidBlock(std::ofstream& out, const std::vector<uint8_t>& block, uint32_t preset) {
+        std::vector<uint8_t> compressed = compressSolidBlock(block, preset);
         
-        size_t file_count = 0;
+        SolidBlock info;
+        info.offset = static_cast<uint64_t>(out.tellp());
+        info.compressed_size = compressed.size();
+        info.raw_size = block.size();
+        out.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
         
-        // 添加目录条目本身
-        if (addFileOrDirToTar(a, dir_path, base_path, relative_path)) {
-            file_count++;
-        }
+        std::cout << "  -> 固实块(偏移 " << info.offset << "): " << info.raw_size
+                  << " -> " << info.compressed_size << " 字节" << std::endl;
+        return info;
+    }
+
+public:
+    // 格式转换：从任意libarchive可读的归档（ZIP、TAR.*、7Z等）逐条目读出，直接写入另一种格式/编码，
+    // 不经过临时目录。读取解压、重新压缩、写盘分别在三个线程中以有界队列相连，流水线式进行。
+    // 目标格式由文件名决定：.tar / .tar.gz / .tar.xz / .tar.bz2 / .tar.zst / .zip / .solid；
+    // 条目名、权限、属主、时间、符号链接和硬链接按目标格式能表达的范围保留。
+    // level为目标编码的压缩级别，-1使用默认值；threads仅用于xz编码，0表示按CPU数
+    static void transcodeArchive(const std::string& source_archive,
+                                 const std::string& dst_path,
+                                 const std::string& target_name,
+                                 int level = -1,
+                                 unsigned threads = 0) {
         
-        // 递归处理目录内容
-        for (const auto& entry : fs::recursive_directory_iterator(dir_path)) {
-            if (fs::exists(entry) && !fs::is_symlink(entry)) {
-                fs::path rel_path = fs::relative(entry.path(), base_path);
-                if (addFileOrDirToTar(a, entry.path(), base_path, rel_path.string())) {
-                    file_count++;
+        fs::path output_path = fs::path(dst_path) / target_name;
+        
+        try {
+            if (!fs::exists(source_archive)) {
+                throw std::runtime_error("源归档不存在: " + source_archive);
+            }
+            if (fs::exists(output_path) && fs::equivalent(source_archive, output_path)) {
+                throw std::runtime_error("目标与源归档是同一个文件");
+            }
+            std::cout << "正在转换: " << source_archive << " -> " << output_path.string() << std::endl;
+            
+            OutputStage output(output_path);
+            BoundedQueue<TranscodeItem> items(TRANSCODE_QUEUE_ITEMS);
+            std::string read_error;
+            std::thread reader(readSourceArchive, source_archive, std::ref(items), std::ref(read_error));
+            
+            TranscodeStats stats;
+            try {
+                if (isSolidTarget(target_name)) {
+                    transcodeToSolid(items, output, level < 0 ? 6 : static_cast<uint32_t>(level), stats);
+                } else {
+                    transcodeToLibarchive(source_archive, items, output, target_name, level, threads, stats);
                 }
+            } catch (...) {
+                items.abort();
+                reader.join();
+                output.abort();
+                throw;
+            }
+            reader.join();
+            if (!read_error.empty()) {
+                output.abort();
+                throw std::runtime_error("读取源归档失败: " + read_error);
             }
+            output.finish();
+            
+            std::cout << "转换完成: " << output_path.string() << " (共 " << stats.entries << " 个条目, "
+                      << stats.bytes << " 字节数据 -> " << output.written() << " 字节)" << std::endl;
+            if (stats.skipped > 0) {
+                std::cerr << "警告: " << stats.skipped << " 个条目无法以目标格式表示，已跳过" << std::endl;
+            }
+            
+        } catch (const std::exception& e) {
+            std::cerr << "格式转换错误: " << e.what() << std::endl;
+            std::error_code ec;
+            fs::remove(output_path, ec);
+            throw;
         }
-        
-        return file_count;
     }
+
+private:
+    static constexpr size_t TRANSCODE_CHUNK = 1024 * 1024;
+    static constexpr size_t TRANSCODE_QUEUE_ITEMS = 32;     // 读取阶段最多领先的数据块
+    static constexpr size_t OUTPUT_QUEUE_ITEMS = 16;        // 已压缩、等待写盘的数据块
+    static constexpr size_t TRANSCODE_BUFFER_LIMIT = 64 * 1024 * 1024;  // 大小未知的条目在内存中缓存的上限
     
-    // 添加文件或目录到TAR
-    static bool addFileOrDirToTar(struct archive* a, const fs::path& entry_path,
-                                 const fs::path& base_path, const std::string& relative_path) {
+    // 读取阶段交给压缩阶段的单元：条目的第一块带有条目头（深拷贝），之后是数据，last标记条目结束
+    struct TranscodeItem {
+        std::shared_ptr<struct archive_entry> entry;
+        std::vector<char> data;
+        bool last = false;
+    };
+    
+    struct TranscodeStats {
+        size_t entries = 0;
+        size_t skipped = 0;
+        uint64_t bytes = 0;
+    };
+    
+    // 写盘阶段：压缩后的数据按块交给独立线程顺序写出
+    class OutputStage {
+        fs::path path;
+        std::ofstream out;
+        BoundedQueue<std::vector<char>> queue;
+        std::thread writer;
+        std::vector<char> pending;
+        std::atomic<bool> failed{false};
+        uint64_t total = 0;
+        bool done = false;
         
-        // 创建归档条目
-        struct archive_entry* entry = archive_entry_new();
-        if (!entry) {
-            return false;
+        void writerLoop() {
+            std::vector<char> chunk;
+            while (queue.pop(chunk)) {
+                out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                if (!out) {
+                    failed = true;
+                    queue.abort();
+                    return;
+                }
+            }
+        }
+        
+    public:
+        explicit OutputStage(const fs::path& output_path)
+            : path(output_path), queue(OUTPUT_QUEUE_ITEMS) {
+            out.open(path, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                throw std::runtime_error("无法创建目标文件: " + path.string());
+            }
+            writer = std::thread(&OutputStage::writerLoop, this);
+        }
+        
+        ~OutputStage() {
+            abort();
+        }
+        
+        OutputStage(const OutputStage&) = delete;
+        OutputStage& operator=(const OutputStage&) = delete;
+        
+        // 追加数据；攒够一块再交给写盘线程。写盘失败后返回false
+        bool write(const void* data, size_t length) {
+            const char* p = static_cast<const char*>(data);
+            pending.insert(pending.end(), p, p + length);
+            total += length;
+            if (pending.size() >= TRANSCODE_CHUNK) {
+                return flush();
+            }
+            return !failed;
+        }
+        
+        bool flush() {
+            if (!pending.empty()) {
+                std::vector<char> chunk;
+                chunk.swap(pending);
+                if (!queue.push(std::move(chunk))) {
+                    return false;
+                }
+            }
+            return !failed;
         }
         
+        // 等待写盘线程把已排队的数据全部写出，之后可直接使用stream()追加尾部
+        void drain() {
+            if (done) return;
+            bool ok = flush();
+            queue.close();
+            writer.join();
+            done = true;
+            if (!ok || failed) {
+                throw std::runtime_error("写入目标文件失败: " + path.string());
+            }
+        }
+        
+        void finish() {
+            drain();
+            total = static_cast<uint64_t>(out.tellp());
+            out.close();
+            if (!out) {
+                throw std::runtime_error("写入目标文件失败: " + path.string());
+            }
+        }
+        
+        void abort() {
+            if (done) return;
+            queue.abort();
+            writer.join();
+            done = true;
+        }
+        
+        std::ofstream& stream() {
+            return out;
+        }
+        
+        uint64_t written() const {
+            return total;
+        }
+    };
+    
+    // 读取阶段（独立线程）：解压源归档，把条目头和数据块送入队列；出错时记录原因并结束队列
+    static void readSourceArchive(const std::string& source_archive, BoundedQueue<TranscodeItem>& items,
+                                  std::string& error) {
+        struct archive* a = archive_read_new();
+        archive_read_support_format_all(a);
+        archive_read_support_filter_all(a);
+        
         try {
-            // 设置条目名称（使用基本文件名或完整路径）
-            // 根据原始Python代码的行为，这里使用基本文件名
-            std::string entry_name = fs::path(relative_path).filename().string();
-            archive_entry_set_pathname(entry, entry_name.c_str());
-            
-            // 获取文件状态
-            struct stat st;
-            if (stat(entry_path.string().c_str(), &st) != 0) {
-                archive_entry_free(entry);
-                return false;
+            if (archive_read_open_filename(a, source_archive.c_str(), TRANSCODE_CHUNK) != ARCHIVE_OK) {
+                throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "无法打开");
             }
             
-            // 设置条目属性
-            archive_entry_copy_stat(entry, &st);
-            
-            // 处理符号链接
-            if (S_ISLNK(st.st_mode)) {
-                char link_target[1024];
-                ssize_t len = readlink(entry_path.string().c_str(), link_target, sizeof(link_target) - 1);
-                if (len > 0) {
-                    link_target[len] = '\0';
-                    archive_entry_set_symlink(entry, link_target);
+            struct archive_entry* entry;
+            int r = ARCHIVE_OK;
+            bool running = true;
+            while (running && (r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+                TranscodeItem item;
+                item.entry.reset(archive_entry_clone(entry), archive_entry_free);
+                // 读出的数据已按逻辑偏移补齐空洞
+                archive_entry_sparse_clear(item.entry.get());
+                
+                bool has_data = archive_entry_filetype(entry) == AE_IFREG && archive_entry_hardlink(entry) == nullptr;
+                // 流式ZIP条目的大小要到数据读完才知道，而目标格式需要先写出大小，只能整体缓存；
+                // 超过内存上限后转存到临时文件
+                bool buffer_all = has_data && !archive_entry_size_is_set(entry);
+                std::unique_ptr<FILE, decltype(&fclose)> spill(nullptr, fclose);
+                uint64_t spilled = 0;
+                
+                while (has_data) {
+                    size_t used = item.data.size();
+                    item.data.resize(used + TRANSCODE_CHUNK);
+                    la_ssize_t n = archive_read_data(a, item.data.data() + used, TRANSCODE_CHUNK);
+                    if (n < 0) {
+                        throw std::runtime_error(std::string(archive_entry_pathname(entry)) + ": " +
+                                                 (archive_error_string(a) ? archive_error_string(a) : "数据损坏"));
+                    }
+                    item.data.resize(used + static_cast<size_t>(n));
+                    if (n == 0) {
+                        break;
+                    }
+                    if (!buffer_all) {
+                        if (!items.push(std::move(item))) {
+                            running = false;
+                            break;
+                        }
+                        item = TranscodeItem();
+                    } else if (item.data.size() >= TRANSCODE_BUFFER_LIMIT) {
+                        if (!spill) {
+                            spill.reset(tmpfile());
+                            if (!spill) {
+                                throw std::runtime_error("无法创建临时文件");
+                            }
+                        }
+                        if (fwrite(item.data.data(), 1, item.data.size(), spill.get()) != item.data.size()) {
+                            throw std::runtime_error("写入临时文件失败");
+                        }
+                        spilled += item.data.size();
+                        item.data.clear();
+                    }
+                }
+                if (buffer_all) {
+                    archive_entry_set_size(item.entry.get(), static_cast<la_int64_t>(spilled + item.data.size()));
+                }
+                if (running && spill) {
+                    running = pushSpilled(items, item, spill.get());
+                }
+                item.last = true;
+                if (running && !items.push(std::move(item))) {
+                    running = false;
                 }
             }
-            
-            // 写入条目头部
-            if (archive_write_header(a, entry) != ARCHIVE_OK) {
-                archive_entry_free(entry);
+            if (running && r != ARCHIVE_EOF) {
+                throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "归档损坏");
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        archive_read_free(a);
+        items.close();
+    }
+    
+    // 先交出条目头和临时文件中的数据，内存中剩余的数据留在item中由调用者作为最后一块交出
+    static bool pushSpilled(BoundedQueue<TranscodeItem>& items, TranscodeItem& item, FILE* spill) {
+        std::vector<char> tail;
+        tail.swap(item.data);
+        rewind(spill);
+        while (true) {
+            item.data.resize(TRANSCODE_CHUNK);
+            size_t n = fread(item.data.data(), 1, item.data.size(), spill);
+            if (n == 0) {
+                if (ferror(spill)) {
+                    throw std::runtime_error("读取临时文件失败");
+                }
+                break;
+            }
+            item.data.resize(n);
+            if (!items.push(std::move(item))) {
                 return false;
             }
-            
-            // 如果是普通文件，写入内容
-            if (S_ISREG(st.st_mode)) {
-                std::ifstream file(entry_path, std::ios::binary);
-                if (file.is_open()) {
-                    char buffer[8192];
-                    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
-                        archive_write_data(a, buffer, file.gcount());
+            item = TranscodeItem();
+        }
+        item.data.swap(tail);
+        return true;
+    }
+    
+    static bool isSolidTarget(const std::string& name) {
+        return fs::path(name).extension() == ".solid";
+    }
+    
+    static la_ssize_t outputWriteCallback(struct archive*, void* client_data, const void* buffer, size_t length) {
+        OutputStage& output = *static_cast<OutputStage*>(client_data);
+        return output.write(buffer, length) ? static_cast<la_ssize_t>(length) : -1;
+    }
+    
+    // 按目标文件名选择libarchive的格式和过滤器
+    static struct archive* openTranscodeTarget(const std::string& target_name, OutputStage& output,
+                                               int level, unsigned threads) {
+        std::string name = target_name;
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        auto endsWith = [&](const std::string& suffix) {
+            return name.size() >= suffix.size() &&
+                   name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+        
+        struct archive* a = archive_write_new();
+        std::string options;
+        int ret;
+        if (endsWith(".zip")) {
+            ret = archive_write_set_format_zip(a);
+            if (level >= 0) options = "zip:compression-level=" + std::to_string(level);
+        } else {
+            ret = archive_write_set_format_pax_restricted(a);
+            std::string filter;
+            if (endsWith(".tar.xz") || endsWith(".txz")) {
+                ret = ret == ARCHIVE_OK ? archive_write_add_filter_xz(a) : ret;
+                filter = "xz";
+                unsigned thread_count = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+                options = "xz:threads=" + std::to_string(thread_count);
+            } else if (endsWith(".tar.gz") || endsWith(".tgz")) {
+                ret = ret == ARCHIVE_OK ? archive_write_add_filter_gzip(a) : ret;
+                filter = "gzip";
+            } else if (endsWith(".tar.bz2") || endsWith(".tbz2")) {
+                ret = ret == ARCHIVE_OK ? archive_write_add_filter_bzip2(a) : ret;
+                filter = "bzip2";
+            } else if (endsWith(".tar.zst") || endsWith(".tzst")) {
+                ret = ret == ARCHIVE_OK ? archive_write_add_filter_zstd(a) : ret;
+                filter = "zstd";
+            } else if (!endsWith(".tar")) {
+                archive_write_free(a);
+                throw std::runtime_error("不支持的目标格式: " + target_name);
+            }
+            if (level >= 0 && !filter.empty()) {
+                options += (options.empty() ? "" : ",") + filter + ":compression-level=" + std::to_string(level);
+            }
+        }
+        if (ret != ARCHIVE_OK) {
+            std::string error = archive_error_string(a) ? archive_error_string(a) : "格式不可用";
+            archive_write_free(a);
+            throw std::runtime_error("无法设置目标格式: " + error);
+        }
+        // 压缩输出不需要把最后一块补齐到10240字节
+        archive_write_set_bytes_in_last_block(a, 1);
+        if (!options.empty() && archive_write_set_options(a, options.c_str()) < ARCHIVE_WARN) {
+            std::cerr << "警告: 压缩参数未生效: " << options << std::endl;
+        }
+        if (archive_write_open(a, &output, nullptr, outputWriteCallback, nullptr) != ARCHIVE_OK) {
+            std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+            archive_write_free(a);
+            throw std::runtime_error("无法创建目标归档: " + error);
+        }
+        return a;
+    }
+    
+    // 硬链接条目按最终指向的数据条目分组
+    using DeferredLinks = std::map<std::string, std::deque<std::shared_ptr<struct archive_entry>>>;
+    
+    // 压缩阶段（libarchive目标）：条目头和数据原样交给写归档对象，由其过滤器重新压缩
+    static void transcodeToLibarchive(const std::string& source_archive,
+                                      BoundedQueue<TranscodeItem>& items, OutputStage& output,
+                                      const std::string& target_name, int level, unsigned threads,
+                                      TranscodeStats& stats) {
+        struct archive* a = openTranscodeTarget(target_name, output, level, threads);
+        // ZIP没有硬链接，libarchive会把硬链接写成空的普通文件，因此先记下，
+        // 最后从源归档重新读出原件的数据，写为普通文件
+        std::string lower_name = target_name;
+        std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+        bool hardlinks_supported = fs::path(lower_name).extension() != ".zip";
+        DeferredLinks deferred;
+        std::map<std::string, std::string> link_targets;
+        try {
+            TranscodeItem item;
+            bool skipping = false;
+            while (items.pop(item)) {
+                if (item.entry && !hardlinks_supported && archive_entry_hardlink(item.entry.get())) {
+                    // 指向另一个硬链接时沿链找到带数据的条目
+                    std::string target = archive_entry_hardlink(item.entry.get());
+                    auto chained = link_targets.find(target);
+                    if (chained != link_targets.end()) {
+                        target = chained->second;
+                    }
+                    link_targets[archive_entry_pathname(item.entry.get())] = target;
+                    deferred[target].push_back(item.entry);
+                    skipping = true;
+                } else if (item.entry) {
+                    int ret = archive_write_header(a, item.entry.get());
+                    if (ret == ARCHIVE_FATAL) {
+                        throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "写入条目失败");
+                    }
+                    skipping = ret < ARCHIVE_WARN;
+                    if (skipping) {
+                        std::cerr << "警告: 跳过条目 " << archive_entry_pathname(item.entry.get()) << ": "
+                                  << (archive_error_string(a) ? archive_error_string(a) : "") << std::endl;
+                        stats.skipped++;
+                    } else {
+                        stats.entries++;
+                    }
+                }
+                if (!skipping && !item.data.empty()) {
+                    if (archive_write_data(a, item.data.data(), item.data.size()) < 0) {
+                        throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "写入数据失败");
                     }
+                    stats.bytes += item.data.size();
                 }
             }
-            
-            std::cout << "  -> TAR添加: " << entry_name 
-                      << " (" << st.st_size << " 字节)" << std::endl;
-            
-            archive_entry_free(entry);
-            return true;
-            
+            writeDeferredLinks(source_archive, a, deferred, stats);
+            if (archive_write_close(a) != ARCHIVE_OK) {
+                throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "关闭目标归档失败");
+            }
         } catch (...) {
-            archive_entry_free(entry);
+            archive_write_free(a);
             throw;
         }
+        archive_write_free(a);
+    }
+    
+    // 把记下的硬链接写为普通文件：重新顺序读取源归档，遇到原件时为它的一个硬链接写出数据。
+    // 每遍每个原件只能读出一次数据，同一原件有多个硬链接时再读一遍，直到全部写完
+    static void writeDeferredLinks(const std::string& source_archive, struct archive* a,
+                                   DeferredLinks& deferred, TranscodeStats& stats) {
+        std::vector<char> buffer(TRANSCODE_CHUNK);
+        while (!deferred.empty()) {
+            struct archive* src = archive_read_new();
+            archive_read_support_format_all(src);
+            archive_read_support_filter_all(src);
+            try {
+                if (archive_read_open_filename(src, source_archive.c_str(), TRANSCODE_CHUNK) != ARCHIVE_OK) {
+                    throw std::runtime_error(std::string("无法重新读取源归档: ") +
+                                             (archive_error_string(src) ? archive_error_string(src) : "无法打开"));
+                }
+                
+                struct archive_entry* source_entry;
+                bool progress = false;
+                while (!deferred.empty() && archive_read_next_header(src, &source_entry) == ARCHIVE_OK) {
+                    auto it = deferred.find(archive_entry_pathname(source_entry));
+                    if (it == deferred.end() || archive_entry_filetype(source_entry) != AE_IFREG ||
+                        archive_entry_hardlink(source_entry) || !archive_entry_size_is_set(source_entry)) {
+                        continue;
+                    }
+                    std::shared_ptr<struct archive_entry> link = it->second.front();
+                    it->second.pop_front();
+                    if (it->second.empty()) {
+                        deferred.erase(it);
+                    }
+                    progress = true;
+                    
+                    archive_entry_copy_hardlink(link.get(), nullptr);
+                    archive_entry_set_filetype(link.get(), AE_IFREG);
+                    archive_entry_sparse_clear(link.get());
+                    archive_entry_set_size(link.get(), archive_entry_size(source_entry));
+                    if (archive_write_header(a, link.get()) != ARCHIVE_OK) {
+                        throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "写入条目失败");
+                    }
+                    la_ssize_t n;
+                    while ((n = archive_read_data(src, buffer.data(), buffer.size())) > 0) {
+                        if (archive_write_data(a, buffer.data(), static_cast<size_t>(n)) < 0) {
+                            throw std::runtime_error(archive_error_string(a) ? archive_error_string(a) : "写入数据失败");
+                        }
+                        stats.bytes += static_cast<uint64_t>(n);
+                    }
+                    if (n < 0) {
+                        throw std::runtime_error(std::string(archive_entry_pathname(source_entry)) + ": " +
+                                                 (archive_error_string(src) ? archive_error_string(src) : "数据损坏"));
+                    }
+                    std::cout << "  -> 硬链接写为普通文件: " << archive_entry_pathname(link.get()) << std::endl;
+                    stats.entries++;
+                }
+                
+                // 找不到原件（或原件大小未知）的硬链接无法还原内容
+                if (!progress) {
+                    for (const auto& [target, links] : deferred) {
+                        for (const auto& link : links) {
+                            std::cerr << "警告: 找不到硬链接的原件，跳过: " << archive_entry_pathname(link.get())
+                                      << " -> " << target << std::endl;
+                            stats.skipped++;
+                        }
+                    }
+                    deferred.clear();
+                }
+            } catch (...) {
+                archive_read_free(src);
+                throw;
+            }
+            archive_read_free(src);
+        }
+    }
+    
+    // 压缩阶段（固实目标）：数据按源归档中的顺序首尾相接切块压缩（不再按扩展名重排，
+    // 那需要先读完整个源归档）；硬链接指向已写入条目的数据范围。固实格式只能表示目录和普通文件
+    static void transcodeToSolid(BoundedQueue<TranscodeItem>& items, OutputStage& output, uint32_t preset,
+                                 TranscodeStats& stats) {
+        size_t block_size = SOLID_DEFAULT_BLOCK;
+        std::string header = "SOLIDARC";
+        for (uint64_t value : {static_cast<uint64_t>(SOLID_VERSION), static_cast<uint64_t>(block_size)}) {
+            for (int i = 0; i < 4; i++) header.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+        output.write(header.data(), header.size());
+        
+        std::vector<SolidBlock> blocks;
+        std::vector<SolidEntry> entries;
+        std::map<std::string, size_t> entry_index;
+        std::vector<uint8_t> block;
+        block.reserve(block_size);
+        uint64_t stream_offset = 0;
+        
+        auto emitBlock = [&]() {
+            std::vector<uint8_t> compressed = compressSolidBlock(block, preset);
+            SolidBlock info;
+            info.offset = output.written();
+            info.compressed_size = compressed.size();
+            info.raw_size = block.size();
+            if (!output.write(compressed.data(), compressed.size())) {
+                throw std::runtime_error("写入目标文件失败");
+            }
+            blocks.push_back(info);
+            block.clear();
+        };
+        
+        TranscodeItem item;
+        SolidEntry entry;
+        bool keep = false;
+        while (items.pop(item)) {
+            if (item.entry) {
+                struct archive_entry* source = item.entry.get();
+                const char* hardlink = archive_entry_hardlink(source);
+                auto original = hardlink ? entry_index.find(hardlink) : entry_index.end();
+                entry.path = archive_entry_pathname(source);
+                entry.mode = archive_entry_mode(source);
+                entry.mtime = archive_entry_mtime(source);
+                entry.offset = stream_offset;
+                entry.size = 0;
+                if (original != entry_index.end()) {
+                    entry.mode = entries[original->second].mode;
+                    entry.offset = entries[original->second].offset;
+                    entry.size = entries[original->second].size;
+                }
+                keep = (S_ISDIR(entry.mode) || S_ISREG(entry.mode)) && (!hardlink || original != entry_index.end());
+                if (!keep) {
+                    std::cerr << "警告: 固实格式不支持该条目，跳过: " << entry.path << std::endl;
+                    stats.skipped++;
+                }
+            }
+            if (keep) {
+                const char* data = item.data.data();
+                size_t remaining = item.data.size();
+                while (remaining > 0) {
+                    size_t n = std::min(remaining, block_size - block.size());
+                    block.insert(block.end(), data, data + n);
+                    data += n;
+                    remaining -= n;
+                    entry.size += n;
+                    if (block.size() == block_size) {
+                        emitBlock();
+                    }
+                }
+                stats.bytes += item.data.size();
+            }
+            if (keep && item.last) {
+                if (entry.offset == stream_offset) {
+                    stream_offset += entry.size;
+                }
+                entry_index[entry.path] = entries.size();
+                entries.push_back(entry);
+                stats.entries++;
+            }
+        }
+        if (!block.empty()) {
+            emitBlock();
+        }
+        
+        // 尾部索引在写盘线程结束后直接写入
+        uint64_t index_offset = output.written();
+        output.drain();
+        std::ofstream& out = output.stream();
+        writeLE(out, blocks.size(), 8);
+        for (const auto& b : blocks) {
+            writeLE(out, b.offset, 8);
+            writeLE(out, b.compressed_size, 8);
+            writeLE(out, b.raw_size, 8);
+        }
+        writeLE(out, entries.size(), 8);
+        for (const auto& e : entries) {
+            writeLE(out, e.path.size(), 4);
+            out.write(e.path.data(), e.path.size());
+            writeLE(out, e.mode, 4);
+            writeLE(out, static_cast<uint64_t>(e.mtime), 8);
+            writeLE(out, e.size, 8);
+            writeLE(out, e.offset, 8);
+        }
+        writeLE(out, index_offset, 8);
+        out.write("SOLIDEND", 8);
+        std::cout << "固实索引: " << blocks.size() << " 个块, " << entries.size() << " 个条目" << std::endl;
     }
 
 public:
@@ -417,12 +3115,28 @@ int main() {
         std::cout << "\n=== ZIP打包测试 ===\n";
         ArchivePacker::packZipFile(base_path, file_list, dst_path, "test_archive.zip");
         
+        std::cout << "\n=== ZIP更新测试 ===\n";
+        std::ofstream(fs::path(base_path) / "dir2/file6.txt") << "Added after the first pack.\n";
+        ArchivePacker::updateZipFile(base_path, file_list, dst_path, "test_archive.zip");
+        ArchivePacker::compactZipFile(dst_path, "test_archive.zip");
+        
         std::cout << "\n=== TAR.GZ打包测试（递归）===\n";
         ArchivePacker::packTarFile(base_path, file_list, dst_path, "test_archive.tar.gz", true);
         
+        std::cout << "\n=== TAR.GZ打包测试（按物理布局读取）===\n";
+        ArchivePacker::packTarFile(base_path, file_list, dst_path, "test_archive_ordered.tar.gz", true,
+                                   ArchivePacker::ReadOrder::PHYSICAL);
+        
         std::cout << "\n=== TAR.GZ打包测试（非递归）===\n";
         ArchivePacker::packTarFile(base_path, file_list, dst_path, "test_archive_flat.tar.gz", false);
         
+        std::cout << "\n=== 固实打包测试 ===\n";
+        ArchivePacker::packSolidFile(base_path, file_list, dst_path, "test_archive.solid");
+        
+        std::cout << "\n=== 格式转换（ZIP -> TAR.XZ / 固实） ===\n";
+        ArchivePacker::transcodeArchive("test_archive.zip", dst_path, "test_archive_converted.tar.xz");
+        ArchivePacker::transcodeArchive("test_archive.zip", dst_path, "test_archive_converted.solid");
+        
         std::cout << "\n=== 查看归档内容 ===\n";
         ArchivePacker::listArchiveContents("test_archive.zip");
         
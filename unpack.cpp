@@ -7,416 +7,3909 @@
 #include <stdexcept>
 #include <iomanip>
 #include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string_view>
+#include <set>
+#include <map>
+#include <list>
+#include <cstdlib>
+#include <cstdio>
 
 // 第三方库头文件
 #include <zip.h>
 #include <archive.h>
 #include <archive_entry.h>
+#include <lzma.h>
+#include <zlib.h>
 #include <cstring>
+#include <cerrno>
+
+// 恢复文件时间、映射中央目录、通配符匹配、内核内拷贝
+#include <fcntl.h>
+#include <unistd.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
 
 namespace fs = std::filesystem;
 
-class ArchiveExtractor {
+// ZIP中央目录索引：mmap整个归档，自行定位EOCD/ZIP64记录，条目名直接引用映射内存（零拷贝），
+// 并按名称排序建立索引。列出、按名查找和通配符匹配都不再逐条经过libzip
+class ZipCentralIndex {
+public:
+    // 条目信息，按需从中央目录记录中解析
+    struct EntryInfo {
+        std::string_view name;
+        uint64_t size = 0;
+        uint64_t compressed_size = 0;
+        uint64_t local_offset = 0;
+        uint32_t crc = 0;
+        uint16_t method = 0;
+        uint16_t flags = 0;
+        uint32_t external_attr = 0;
+        bool is_dir = false;
+    };
+
 private:
-    // 解压进度回调函数类型
-    using ProgressCallback = void(*)(const std::string&, size_t, size_t, void*);
+    static constexpr uint32_t LOCAL_HEADER_SIG = 0x04034b50;
+    static constexpr uint32_t CENTRAL_HEADER_SIG = 0x02014b50;
+    static constexpr uint32_t EOCD_SIG = 0x06054b50;
+    static constexpr uint32_t ZIP64_EOCD_SIG = 0x06064b50;
+    static constexpr uint32_t ZIP64_LOCATOR_SIG = 0x07064b50;
+
+    int fd = -1;
+    const unsigned char* data = nullptr;
+    size_t length = 0;
+
+    std::vector<uint64_t> records;      // 各条目中央目录记录在文件中的偏移（与libzip的条目序号一致）
+    std::vector<uint32_t> sorted;       // 按名称排序的条目序号
+
+    static uint16_t get16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+    static uint32_t get32(const unsigned char* p) { return get16(p) | (static_cast<uint32_t>(get16(p + 2)) << 16); }
+    static uint64_t get64(const unsigned char* p) { return get32(p) | (static_cast<uint64_t>(get32(p + 4)) << 32); }
+
+    void check(uint64_t offset, uint64_t size) const {
+        if (offset > length || size > length - offset) {
+            throw std::runtime_error("ZIP中央目录越界，文件可能已损坏");
+        }
+    }
+
+    void parse() {
+        if (length < 22) {
+            throw std::runtime_error("不是有效的ZIP文件");
+        }
+
+        // EOCD位于文件末尾，其后最多跟65535字节的注释
+        size_t search_start = length > 22 + 65535 ? length - 22 - 65535 : 0;
+        size_t eocd = SIZE_MAX;
+        for (size_t i = length - 22 + 1; i-- > search_start;) {
+            if (get32(data + i) == EOCD_SIG && i + 22 + get16(data + i + 20) == length) {
+                eocd = i;
+                break;
+            }
+        }
+        if (eocd == SIZE_MAX) {
+            throw std::runtime_error("找不到ZIP中央目录结束记录");
+        }
+
+        uint64_t count = get16(data + eocd + 10);
+        uint64_t cd_size = get32(data + eocd + 12);
+        uint64_t cd_offset = get32(data + eocd + 16);
+
+        // ZIP64：定位记录紧挨在EOCD之前
+        if (eocd >= 20 && get32(data + eocd - 20) == ZIP64_LOCATOR_SIG) {
+            uint64_t record = get64(data + eocd - 20 + 8);
+            check(record, 56);
+            if (get32(data + record) != ZIP64_EOCD_SIG) {
+                throw std::runtime_error("ZIP64中央目录结束记录损坏");
+            }
+            count = get64(data + record + 32);
+            cd_size = get64(data + record + 40);
+            cd_offset = get64(data + record + 48);
+        }
+        check(cd_offset, cd_size);
+
+        records.reserve(static_cast<size_t>(count));
+        uint64_t pos = cd_offset;
+        uint64_t end = cd_offset + cd_size;
+        for (uint64_t i = 0; i < count; i++) {
+            if (pos + 46 > end || get32(data + pos) != CENTRAL_HEADER_SIG) {
+                throw std::runtime_error("ZIP中央目录损坏");
+            }
+            records.push_back(pos);
+            pos += 46 + static_cast<uint64_t>(get16(data + pos + 28)) + get16(data + pos + 30) + get16(data + pos + 32);
+        }
+        if (pos > end) {
+            throw std::runtime_error("ZIP中央目录损坏");
+        }
+
+        sorted.resize(records.size());
+        for (size_t i = 0; i < sorted.size(); i++) {
+            sorted[i] = static_cast<uint32_t>(i);
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [this](uint32_t a, uint32_t b) { return name(a) < name(b); });
+    }
+
+public:
+    explicit ZipCentralIndex(const fs::path& path) {
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("无法打开ZIP文件: " + path.string());
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("无法读取ZIP文件: " + path.string());
+        }
+        length = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("无法映射ZIP文件: " + path.string());
+        }
+        data = static_cast<const unsigned char*>(mapped);
+
+        try {
+            parse();
+        } catch (...) {
+            munmap(const_cast<unsigned char*>(data), length);
+            close(fd);
+            throw;
+        }
+    }
+
+    ~ZipCentralIndex() {
+        munmap(const_cast<unsigned char*>(data), length);
+        close(fd);
+    }
+
+    ZipCentralIndex(const ZipCentralIndex&) = delete;
+    ZipCentralIndex& operator=(const ZipCentralIndex&) = delete;
+
+    size_t size() const {
+        return records.size();
+    }
+
+    // 归档文件描述符，供内核内拷贝使用（只用带偏移的读取，不改变文件位置）
+    int fileDescriptor() const {
+        return fd;
+    }
+
+    // 条目数据的起始偏移（跳过本地文件头，其扩展字段长度可能与中央目录不同）；
+    // 本地文件头无效或数据超出文件范围时返回-1
+    int64_t dataOffset(size_t index) const {
+        EntryInfo info = entry(index);
+        uint64_t local = info.local_offset;
+        if (local + 30 > length || get32(data + local) != LOCAL_HEADER_SIG) {
+            return -1;
+        }
+        uint64_t start = local + 30 + get16(data + local + 26) + get16(data + local + 28);
+        if (start + info.compressed_size > length) {
+            return -1;
+        }
+        return static_cast<int64_t>(start);
+    }
+
+    // 条目名，直接指向映射内存
+    std::string_view name(size_t index) const {
+        const unsigned char* p = data + records[index];
+        return std::string_view(reinterpret_cast<const char*>(p + 46), get16(p + 28));
+    }
+
+    EntryInfo entry(size_t index) const {
+        const unsigned char* p = data + records[index];
+        EntryInfo info;
+        info.name = name(index);
+        info.flags = get16(p + 8);
+        info.method = get16(p + 10);
+        info.crc = get32(p + 16);
+        info.compressed_size = get32(p + 20);
+        info.size = get32(p + 24);
+        info.external_attr = get32(p + 38);
+        info.local_offset = get32(p + 42);
+        info.is_dir = !info.name.empty() && info.name.back() == '/';
+
+        // ZIP64扩展字段只包含标记为0xFFFFFFFF的值，顺序固定
+        const unsigned char* extra = p + 46 + get16(p + 28);
+        const unsigned char* extra_end = extra + get16(p + 30);
+        while (extra + 4 <= extra_end) {
+            uint16_t id = get16(extra);
+            uint16_t len = get16(extra + 2);
+            const unsigned char* field = extra + 4;
+            const unsigned char* field_end = std::min(field + len, extra_end);
+            if (id == 0x0001) {
+                if (info.size == 0xFFFFFFFF && field + 8 <= field_end) { info.size = get64(field); field += 8; }
+                if (info.compressed_size == 0xFFFFFFFF && field + 8 <= field_end) { info.compressed_size = get64(field); field += 8; }
+                if (info.local_offset == 0xFFFFFFFF && field + 8 <= field_end) { info.local_offset = get64(field); }
+                break;
+            }
+            extra += 4 + len;
+        }
+        return info;
+    }
+
+    // 按名称二分查找，返回条目序号（与libzip一致）；不存在时返回-1
+    int64_t find(std::string_view entry_name) const {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), entry_name,
+                                   [this](uint32_t i, std::string_view value) { return name(i) < value; });
+        if (it != sorted.end() && name(*it) == entry_name) {
+            return *it;
+        }
+        return -1;
+    }
+
+    // 通配符匹配（fnmatch语法），结果按名称排序；模式中第一个通配符之前的前缀用于缩小二分查找范围
+    std::vector<size_t> glob(const std::string& pattern) const {
+        size_t wildcard = pattern.find_first_of("*?[\\");
+        std::string_view prefix(pattern.data(), wildcard == std::string::npos ? pattern.size() : wildcard);
+
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), prefix,
+                                   [this](uint32_t i, std::string_view value) { return name(i) < value; });
+        std::vector<size_t> matches;
+        std::string candidate;
+        for (; it != sorted.end(); ++it) {
+            std::string_view entry_name = name(*it);
+            if (entry_name.compare(0, prefix.size(), prefix) != 0) {
+                break;
+            }
+            candidate.assign(entry_name.data(), entry_name.size());
+            if (fnmatch(pattern.c_str(), candidate.c_str(), 0) == 0) {
+                matches.push_back(*it);
+            }
+        }
+        return matches;
+    }
+};
+
+// TAR.GZ随机访问索引（zran方式）：顺序解压一遍，每隔span字节在deflate块边界处记录检查点
+// （压缩偏移、位偏移和此前32KB的解压窗口），同时记录每个tar成员在解压流中的起始偏移。
+// 索引保存在归档旁的 .seekidx 文件中；提取单个成员时从最近的检查点开始解压
+class TarGzSeekIndex {
+public:
+    static constexpr uint64_t DEFAULT_SPAN = 8ULL * 1024 * 1024;
+
+    struct Member {
+        std::string name;
+        uint64_t header_offset = 0;    // 成员头部（含pax扩展头）在解压流中的偏移
+        uint64_t size = 0;
+    };
+
+private:
+    static constexpr size_t WINDOW_SIZE = 32768;
+    static constexpr size_t CHUNK_SIZE = 256 * 1024;
+    static constexpr char MAGIC[] = "TGZSEEK1";
+
+    struct Point {
+        uint64_t out = 0;                  // 解压流偏移
+        uint64_t in = 0;                   // 压缩数据偏移
+        int bits = 0;                      // in之前一个字节中尚未消耗的位数
+        std::vector<unsigned char> window; // 窗口（zlib压缩后保存）
+    };
+
+    uint64_t archive_size = 0;
+    int64_t archive_mtime = 0;
+    uint64_t span = DEFAULT_SPAN;
+    std::vector<Point> points;
+    std::vector<Member> members;
+
+public:
+    // 顺序解压器：建立索引时从头解压gzip流，并在块边界记录检查点；
+    // 提取时从检查点恢复原始deflate流
+    class Inflater {
+        int fd = -1;
+        z_stream strm{};
+        std::vector<unsigned char> input;
+        uint64_t base_out = 0;
+        bool finished = false;
+
+        TarGzSeekIndex* recorder = nullptr;
+        std::vector<unsigned char> ring;   // 最近32KB输出，按流偏移取模存放
+        uint64_t last_point = 0;
+
+    public:
+        Inflater(const fs::path& path, TarGzSeekIndex* recorder_index)
+            : input(CHUNK_SIZE), recorder(recorder_index), ring(WINDOW_SIZE) {
+            openFile(path);
+            if (inflateInit2(&strm, 47) != Z_OK) {      // 15位窗口 + 自动识别gzip头
+                close(fd);
+                throw std::runtime_error("无法初始化解压");
+            }
+        }
+
+        Inflater(const fs::path& path, const Point& point)
+            : input(CHUNK_SIZE), base_out(point.out) {
+            openFile(path);
+            if (inflateInit2(&strm, -15) != Z_OK) {
+                close(fd);
+                throw std::runtime_error("无法初始化解压");
+            }
+            try {
+                off_t start = static_cast<off_t>(point.in) - (point.bits ? 1 : 0);
+                if (lseek(fd, start, SEEK_SET) != start) {
+                    throw std::runtime_error("无法定位到检查点");
+                }
+                if (point.bits) {
+                    unsigned char c;
+                    if (::read(fd, &c, 1) != 1) {
+                        throw std::runtime_error("无法读取检查点数据");
+                    }
+                    inflatePrime(&strm, point.bits, c >> (8 - point.bits));
+                }
+                std::vector<unsigned char> dict = windowOf(point);
+                if (!dict.empty()) {
+                    inflateSetDictionary(&strm, dict.data(), static_cast<uInt>(dict.size()));
+                }
+            } catch (...) {
+                inflateEnd(&strm);
+                close(fd);
+                throw;
+            }
+        }
+
+        ~Inflater() {
+            inflateEnd(&strm);
+            close(fd);
+        }
+
+        Inflater(const Inflater&) = delete;
+        Inflater& operator=(const Inflater&) = delete;
+
+        uint64_t position() const {
+            return base_out + strm.total_out;
+        }
+
+        // 读出最多len字节解压数据，返回0表示流结束
+        size_t read(unsigned char* buf, size_t len) {
+            strm.next_out = buf;
+            strm.avail_out = static_cast<uInt>(len);
+            while (strm.avail_out == len && !finished) {
+                if (strm.avail_in == 0) {
+                    ssize_t n = ::read(fd, input.data(), input.size());
+                    if (n < 0) {
+                        throw std::runtime_error("读取归档失败: " + std::string(strerror(errno)));
+                    }
+                    if (n == 0) {
+                        throw std::runtime_error("gzip数据意外结束");
+                    }
+                    strm.next_in = input.data();
+                    strm.avail_in = static_cast<uInt>(n);
+                }
+
+                unsigned char* produced_from = strm.next_out;
+                int ret = inflate(&strm, recorder ? Z_BLOCK : Z_NO_FLUSH);
+                if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+                    throw std::runtime_error("gzip数据损坏");
+                }
+                if (ret == Z_STREAM_END) {
+                    finished = true;
+                }
+                if (recorder) {
+                    remember(produced_from, static_cast<size_t>(strm.next_out - produced_from));
+                    // 位于块边界且不是最后一块时才能作为检查点
+                    if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+                        (recorder->points.empty() || strm.total_out - last_point >= recorder->span)) {
+                        addPoint();
+                    }
+                }
+            }
+            return len - strm.avail_out;
+        }
+
+        // 丢弃数据直到解压流偏移到达target
+        void skipTo(uint64_t target) {
+            std::vector<unsigned char> scratch(CHUNK_SIZE);
+            while (position() < target) {
+                size_t want = static_cast<size_t>(std::min<uint64_t>(scratch.size(), target - position()));
+                if (read(scratch.data(), want) == 0) {
+                    throw std::runtime_error("索引偏移超出数据范围");
+                }
+            }
+        }
+
+    private:
+        void openFile(const fs::path& path) {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("无法打开归档: " + path.string());
+            }
+        }
+
+        void remember(const unsigned char* data, size_t n) {
+            if (n > WINDOW_SIZE) {
+                data += n - WINDOW_SIZE;
+                n = WINDOW_SIZE;
+            }
+            size_t pos = static_cast<size_t>((strm.total_out - n) % WINDOW_SIZE);
+            size_t first = std::min(n, WINDOW_SIZE - pos);
+            memcpy(ring.data() + pos, data, first);
+            memcpy(ring.data(), data + first, n - first);
+        }
+
+        void addPoint() {
+            size_t have = static_cast<size_t>(std::min<uint64_t>(strm.total_out, WINDOW_SIZE));
+            std::vector<unsigned char> window(have);
+            size_t pos = static_cast<size_t>((strm.total_out - have) % WINDOW_SIZE);
+            size_t first = std::min(have, WINDOW_SIZE - pos);
+            memcpy(window.data(), ring.data() + pos, first);
+            memcpy(window.data() + first, ring.data(), have - first);
+
+            Point point;
+            point.out = strm.total_out;
+            point.in = strm.total_in;
+            point.bits = strm.data_type & 7;
+            uLongf packed_len = compressBound(have);
+            point.window.resize(packed_len);
+            if (compress2(point.window.data(), &packed_len, window.data(), have, 6) != Z_OK) {
+                throw std::runtime_error("无法压缩检查点窗口");
+            }
+            point.window.resize(packed_len);
+
+            recorder->points.push_back(std::move(point));
+            last_point = strm.total_out;
+        }
+    };
+
+private:
+    static std::vector<unsigned char> windowOf(const Point& point) {
+        uLongf have = static_cast<uLongf>(std::min<uint64_t>(point.out, WINDOW_SIZE));
+        std::vector<unsigned char> window(have);
+        if (have > 0 && (uncompress(window.data(), &have, point.window.data(), point.window.size()) != Z_OK ||
+                         have != window.size())) {
+            throw std::runtime_error("检查点窗口损坏");
+        }
+        return window;
+    }
+
+    // libarchive读取回调：数据来自Inflater
+    struct Feed {
+        Inflater* inflater;
+        std::vector<unsigned char> buffer;
+    };
+
+    static la_ssize_t feedRead(struct archive* a, void* client_data, const void** buffer) {
+        Feed* feed = static_cast<Feed*>(client_data);
+        try {
+            *buffer = feed->buffer.data();
+            return static_cast<la_ssize_t>(feed->inflater->read(feed->buffer.data(), feed->buffer.size()));
+        } catch (const std::exception& e) {
+            archive_set_error(a, EIO, "%s", e.what());
+            return -1;
+        }
+    }
+
+    static void writeLE(std::ostream& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    static uint64_t readLE(std::istream& in, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            int c = in.get();
+            if (c == EOF) {
+                throw std::runtime_error("索引文件已截断");
+            }
+            value |= static_cast<uint64_t>(c) << (8 * i);
+        }
+        return value;
+    }
+
+    static bool statArchive(const fs::path& archive_path, uint64_t& size, int64_t& mtime) {
+        struct stat st;
+        if (stat(archive_path.c_str(), &st) != 0) {
+            return false;
+        }
+        size = static_cast<uint64_t>(st.st_size);
+        mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return true;
+    }
+
+public:
+    static fs::path indexPath(const fs::path& archive_path) {
+        return fs::path(archive_path.string() + ".seekidx");
+    }
+
+    // 顺序解压整个归档一次，建立检查点和成员表
+    static TarGzSeekIndex build(const fs::path& archive_path, uint64_t span = DEFAULT_SPAN) {
+        TarGzSeekIndex index;
+        index.span = std::max<uint64_t>(span, 1024 * 1024);
+        if (!statArchive(archive_path, index.archive_size, index.archive_mtime)) {
+            throw std::runtime_error("归档文件不存在: " + archive_path.string());
+        }
+
+        Inflater inflater(archive_path, &index);
+        Feed feed{&inflater, std::vector<unsigned char>(CHUNK_SIZE)};
+
+        struct archive* a = archive_read_new();
+        archive_read_support_format_tar(a);
+        if (archive_read_open(a, &feed, nullptr, feedRead, nullptr) != ARCHIVE_OK) {
+            std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+            archive_read_free(a);
+            throw std::runtime_error("无法读取TAR数据: " + error);
+        }
+
+        struct archive_entry* entry;
+        int r;
+        while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+            Member member;
+            member.name = archive_entry_pathname(entry);
+            member.header_offset = static_cast<uint64_t>(archive_read_header_position(a));
+            member.size = static_cast<uint64_t>(archive_entry_size(entry));
+            index.members.push_back(std::move(member));
+            archive_read_data_skip(a);
+        }
+        std::string error = (r != ARCHIVE_EOF && archive_error_string(a)) ? archive_error_string(a) : "";
+        archive_read_free(a);
+        if (r != ARCHIVE_EOF) {
+            throw std::runtime_error("建立索引失败: " + error);
+        }
+        return index;
+    }
+
+    void save(const fs::path& index_path) const {
+        std::ofstream out(index_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("无法写入索引文件: " + index_path.string());
+        }
+        out.write(MAGIC, 8);
+        writeLE(out, archive_size, 8);
+        writeLE(out, static_cast<uint64_t>(archive_mtime), 8);
+        writeLE(out, span, 8);
+        writeLE(out, points.size(), 8);
+        for (const auto& point : points) {
+            writeLE(out, point.out, 8);
+            writeLE(out, point.in, 8);
+            writeLE(out, static_cast<uint64_t>(point.bits), 1);
+            writeLE(out, point.window.size(), 4);
+            out.write(reinterpret_cast<const char*>(point.window.data()), point.window.size());
+        }
+        writeLE(out, members.size(), 8);
+        for (const auto& member : members) {
+            writeLE(out, member.name.size(), 4);
+            out.write(member.name.data(), member.name.size());
+            writeLE(out, member.header_offset, 8);
+            writeLE(out, member.size, 8);
+        }
+        if (!out) {
+            throw std::runtime_error("写入索引文件失败: " + index_path.string());
+        }
+    }
+
+    // 读取索引文件；文件不存在、格式不符或归档已变化（大小/修改时间不同）时返回false
+    static bool load(const fs::path& archive_path, TarGzSeekIndex& index) {
+        std::ifstream in(indexPath(archive_path), std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+        char magic[8];
+        if (!in.read(magic, 8) || memcmp(magic, MAGIC, 8) != 0) {
+            return false;
+        }
+
+        uint64_t size;
+        int64_t mtime;
+        if (!statArchive(archive_path, size, mtime)) {
+            return false;
+        }
+        try {
+            index.archive_size = readLE(in, 8);
+            index.archive_mtime = static_cast<int64_t>(readLE(in, 8));
+            if (index.archive_size != size || index.archive_mtime != mtime) {
+                return false;
+            }
+            index.span = readLE(in, 8);
+
+            uint64_t point_count = readLE(in, 8);
+            index.points.clear();
+            for (uint64_t i = 0; i < point_count; i++) {
+                Point point;
+                point.out = readLE(in, 8);
+                point.in = readLE(in, 8);
+                point.bits = static_cast<int>(readLE(in, 1));
+                point.window.resize(static_cast<size_t>(readLE(in, 4)));
+                if (!in.read(reinterpret_cast<char*>(point.window.data()), point.window.size())) {
+                    return false;
+                }
+                index.points.push_back(std::move(point));
+            }
+
+            uint64_t member_count = readLE(in, 8);
+            index.members.clear();
+            for (uint64_t i = 0; i < member_count; i++) {
+                Member member;
+                member.name.resize(static_cast<size_t>(readLE(in, 4)));
+                if (!in.read(&member.name[0], member.name.size())) {
+                    return false;
+                }
+                member.header_offset = readLE(in, 8);
+                member.size = readLE(in, 8);
+                index.members.push_back(std::move(member));
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+        return !index.points.empty();
+    }
+
+    // 优先使用已有索引，否则建立并保存（目录不可写时只在内存中使用）
+    static TarGzSeekIndex open(const fs::path& archive_path, uint64_t span = DEFAULT_SPAN) {
+        TarGzSeekIndex index;
+        if (load(archive_path, index)) {
+            return index;
+        }
+        std::cout << "正在建立随机访问索引: " << archive_path.string() << std::endl;
+        index = build(archive_path, span);
+        try {
+            index.save(indexPath(archive_path));
+        } catch (const std::exception& e) {
+            std::cerr << "警告: " << e.what() << std::endl;
+        }
+        return index;
+    }
+
+    const std::vector<Member>& entries() const {
+        return members;
+    }
+
+    size_t pointCount() const {
+        return points.size();
+    }
+
+    const Member* find(const std::string& name) const {
+        auto it = std::find_if(members.begin(), members.end(),
+                               [&](const Member& m) { return m.name == name; });
+        return it == members.end() ? nullptr : &*it;
+    }
+
+    // 从不超过offset的最近检查点恢复解压并丢弃到offset；start_out返回检查点位置
+    std::unique_ptr<Inflater> inflaterAt(const fs::path& archive_path, uint64_t offset,
+                                         uint64_t* start_out = nullptr) const {
+        auto it = std::upper_bound(points.begin(), points.end(), offset,
+                                   [](uint64_t value, const Point& p) { return value < p.out; });
+        if (it == points.begin()) {
+            throw std::runtime_error("索引中没有可用的检查点");
+        }
+        const Point& point = *(it - 1);
+        if (start_out) {
+            *start_out = point.out;
+        }
+        std::unique_ptr<Inflater> inflater(new Inflater(archive_path, point));
+        inflater->skipTo(offset);
+        return inflater;
+    }
+
+    // 定位到某个成员的读取会话：从不超过成员偏移的最近检查点恢复解压，丢弃到成员头部后
+    // 交给libarchive按tar格式读取，因此只解压该成员之前不到span字节的数据和成员本身
+    class MemberReader {
+        std::unique_ptr<Inflater> inflater;
+        std::unique_ptr<Feed> feed;
+        struct archive* a = nullptr;
+        uint64_t start_out = 0;
+
+    public:
+        MemberReader(const TarGzSeekIndex& index, const fs::path& archive_path, const Member& member) {
+            inflater = index.inflaterAt(archive_path, member.header_offset, &start_out);
+            feed.reset(new Feed{inflater.get(), std::vector<unsigned char>(CHUNK_SIZE)});
+
+            a = archive_read_new();
+            archive_read_support_format_tar(a);
+            if (archive_read_open(a, feed.get(), nullptr, feedRead, nullptr) != ARCHIVE_OK) {
+                std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+                archive_read_free(a);
+                a = nullptr;
+                throw std::runtime_error("无法读取TAR数据: " + error);
+            }
+        }
+
+        ~MemberReader() {
+            if (a) {
+                archive_read_free(a);
+            }
+        }
+
+        MemberReader(const MemberReader&) = delete;
+        MemberReader& operator=(const MemberReader&) = delete;
+
+        struct archive* archive() const {
+            return a;
+        }
+
+        // 本次实际解压的字节数
+        uint64_t inflatedBytes() const {
+            return inflater->position() - start_out;
+        }
+    };
+};
+
+// 解压写入器：缓存已创建的目录，按已知大小预分配文件，经大块对齐缓冲写入，
+// 权限和时间在全部数据写完后批量设置。可由多个解压线程共享
+class ExtractionWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+    static constexpr size_t BUFFER_ALIGN = 4096;
+
+    // 单个输出文件，数据先进入本线程的缓冲，满后一次pwrite
+    class File {
+        int fd = -1;
+        char* buffer = nullptr;
+        size_t used = 0;
+        uint64_t buffer_offset = 0;    // 缓冲起始处对应的文件偏移
+        uint64_t end = 0;              // 已写出数据的最大偏移
+        uint64_t preallocated = 0;
+        enum CopyMode { COPY_RANGE, SENDFILE, BUFFERED } copy_mode = COPY_RANGE;
+        bool kernel_copied = false;    // 是否有数据经copy_file_range/sendfile拷贝（未经过用户态）
+
+    public:
+        File() = default;
+        ~File() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+
+        // 创建新文件；已存在的文件或符号链接先删除再创建（与libarchive相同），
+        // 不在原处截断，以免改写与其他硬链接共享的inode
+        bool open(const fs::path& path, uint64_t size) {
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+            if (fd < 0 && errno == EEXIST && unlink(path.c_str()) == 0) {
+                fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+            }
+            if (fd < 0) {
+                return false;
+            }
+            buffer = threadBuffer();
+            // 不超过一个缓冲的文件只需一次写入，预分配反而多一次系统调用
+            if (size > BUFFER_SIZE && fallocate(fd, 0, 0, static_cast<off_t>(size)) == 0) {
+                preallocated = size;
+            }
+            return true;
+        }
+
+        // 缓冲中的空闲区域，供解压器直接写入，写入后调用commit
+        char* space() {
+            return buffer + used;
+        }
+
+        size_t spaceSize() const {
+            return BUFFER_SIZE - used;
+        }
+
+        bool commit(size_t len) {
+            used += len;
+            return used < BUFFER_SIZE || flush();
+        }
+
+        // 在指定偏移写入；与缓冲内容不连续时先写出缓冲
+        bool writeAt(const void* data, size_t len, uint64_t offset) {
+            if (offset != buffer_offset + used) {
+                if (!flush()) {
+                    return false;
+                }
+                buffer_offset = offset;
+            }
+            // 缓冲为空时大块数据直接写出，省去一次拷贝
+            if (used == 0 && len >= BUFFER_SIZE) {
+                if (!writeFully(static_cast<const char*>(data), len, offset)) {
+                    return false;
+                }
+                buffer_offset = offset + len;
+                return true;
+            }
+            const char* p = static_cast<const char*>(data);
+            while (len > 0) {
+                size_t n = std::min(len, spaceSize());
+                memcpy(space(), p, n);
+                if (!commit(n)) {
+                    return false;
+                }
+                p += n;
+                len -= n;
+            }
+            return true;
+        }
+
+        bool write(const void* data, size_t len) {
+            return writeAt(data, len, buffer_offset + used);
+        }
+
+        // 从另一个文件的指定区间追加数据，不经过用户态缓冲：优先copy_file_range
+        // （支持的文件系统上可在内核内完成或成为reflink），不支持时退回sendfile，最后退回缓冲拷贝。
+        // crc非空时累计缓冲拷贝部分的CRC32；内核拷贝的部分见kernelCopied()
+        bool copyFrom(int src_fd, uint64_t src_offset, uint64_t len, uLong* crc = nullptr) {
+            if (!flush()) {
+                return false;
+            }
+            loff_t in_off = static_cast<loff_t>(src_offset);
+            loff_t out_off = static_cast<loff_t>(buffer_offset);
+            while (len > 0 && copy_mode == COPY_RANGE) {
+                ssize_t n = copy_file_range(src_fd, &in_off, fd, &out_off, len, 0);
+                if (n > 0) {
+                    len -= static_cast<uint64_t>(n);
+                    kernel_copied = true;
+                } else if (n < 0 && errno == EINTR) {
+                    continue;
+                } else if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP ||
+                                     errno == EINVAL || errno == EBADF)) {
+                    copy_mode = SENDFILE;
+                } else {
+                    return false;
+                }
+            }
+            // sendfile写入输出文件的当前位置
+            if (len > 0 && copy_mode == SENDFILE && lseek(fd, out_off, SEEK_SET) != out_off) {
+                copy_mode = BUFFERED;
+            }
+            while (len > 0 && copy_mode == SENDFILE) {
+                ssize_t n = sendfile(fd, src_fd, &in_off, len);
+                if (n > 0) {
+                    len -= static_cast<uint64_t>(n);
+                    kernel_copied = true;
+                    out_off += n;
+                } else if (n < 0 && errno == EINTR) {
+                    continue;
+                } else if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                    copy_mode = BUFFERED;
+                } else {
+                    return false;
+                }
+            }
+            while (len > 0) {
+                ssize_t n = pread(src_fd, buffer, static_cast<size_t>(std::min<uint64_t>(len, BUFFER_SIZE)), in_off);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0 || !writeFully(buffer, static_cast<size_t>(n), static_cast<uint64_t>(out_off))) {
+                    return false;
+                }
+                if (crc) {
+                    *crc = crc32(*crc, reinterpret_cast<const Bytef*>(buffer), static_cast<uInt>(n));
+                }
+                len -= static_cast<uint64_t>(n);
+                in_off += n;
+                out_off += n;
+            }
+            buffer_offset = static_cast<uint64_t>(out_off);
+            end = std::max(end, buffer_offset);
+            return true;
+        }
+
+        bool kernelCopied() const {
+            return kernel_copied;
+        }
+
+        // 写出剩余数据；实际长度小于预分配长度时截断
+        bool close() {
+            bool ok = flush();
+            if (ok && preallocated > end) {
+                ok = ftruncate(fd, static_cast<off_t>(end)) == 0;
+            }
+            if (::close(fd) != 0) {
+                ok = false;
+            }
+            fd = -1;
+            return ok;
+        }
+
+    private:
+        bool flush() {
+            if (used == 0) {
+                return true;
+            }
+            if (!writeFully(buffer, used, buffer_offset)) {
+                return false;
+            }
+            buffer_offset += used;
+            used = 0;
+            return true;
+        }
+
+        bool writeFully(const char* data, size_t len, uint64_t offset) {
+            while (len > 0) {
+                ssize_t n = pwrite(fd, data, len, static_cast<off_t>(offset));
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += n;
+                len -= static_cast<size_t>(n);
+                offset += static_cast<uint64_t>(n);
+            }
+            end = std::max(end, offset);
+            return true;
+        }
+    };
+
+private:
+    struct PendingMetadata {
+        std::string path;
+        mode_t mode;                   // 0表示不修改权限
+        struct timespec times[2];      // atime、mtime，UTIME_OMIT表示不修改
+    };
+
+    std::mutex mutex;
+    std::set<std::string> directories;
+    std::vector<PendingMetadata> pending;
+
+    // 每个线程一块对齐缓冲，跨文件复用，避免逐文件分配
+    static char* threadBuffer() {
+        struct AlignedBuffer {
+            char* data = nullptr;
+            ~AlignedBuffer() { free(data); }
+        };
+        static thread_local AlignedBuffer buffer;
+        if (!buffer.data) {
+            void* p = nullptr;
+            if (posix_memalign(&p, BUFFER_ALIGN, BUFFER_SIZE) != 0) {
+                throw std::bad_alloc();
+            }
+            buffer.data = static_cast<char*>(p);
+        }
+        return buffer.data;
+    }
+
+    static std::string directoryKey(const fs::path& dir) {
+        std::string key = dir.lexically_normal().string();
+        while (key.size() > 1 && key.back() == '/') {
+            key.pop_back();
+        }
+        return key;
+    }
+
+public:
+    // 确保目录存在；已创建或确认过的目录不再触发系统调用。
+    // 路径中已存在的非目录（如符号链接）视为错误，避免写到解压目录之外
+    void ensureDirectory(const fs::path& dir) {
+        std::string key = directoryKey(dir);
+        if (key.empty() || key == "." || key == "/") {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (directories.count(key)) {
+                return;
+            }
+        }
+
+        fs::path parent = fs::path(key).parent_path();
+        if (!parent.empty() && parent != fs::path(key)) {
+            ensureDirectory(parent);
+        }
+
+        if (mkdir(key.c_str(), 0777) != 0) {
+            if (errno != EEXIST) {
+                throw std::runtime_error("无法创建目录: " + key + ": " + strerror(errno));
+            }
+            struct stat st;
+            if (lstat(key.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+                throw std::runtime_error("路径已存在且不是目录: " + key);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        directories.insert(key);
+    }
+
+    // 登记解压根目录：根目录由用户指定，它自身或上级目录是符号链接都是正常的，
+    // 因此创建后把它和全部上级目录直接记为已确认，非目录检查只作用于根目录以下的路径。
+    // 根目录来自归档内容时（如内层归档），调用前须已由外层writer的ensureDirectory检查过
+    void addRoot(const fs::path& root) {
+        fs::create_directories(root);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (fs::path dir = directoryKey(root); !dir.empty(); dir = dir.parent_path()) {
+            directories.insert(directoryKey(dir));
+            if (dir == dir.parent_path()) {
+                break;
+            }
+        }
+    }
+
+    // 路径被其他方式替换（如创建为符号链接）后，从缓存中移除它及其下的目录
+    void forget(const fs::path& path) {
+        std::string key = directoryKey(path);
+        if (key.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = directories.lower_bound(key);
+        while (it != directories.end() &&
+               (*it == key || (it->compare(0, key.size(), key) == 0 && (*it)[key.size()] == '/'))) {
+            it = directories.erase(it);
+        }
+    }
+
+    // 记录待设置的权限和时间，积累到一批后统一处理。分批而不是全部留到最后，
+    // 解压中断时已完成的文件也带有正确的修改时间，续传时可以据此跳过
+    void deferMetadata(const fs::path& path, mode_t mode,
+                       const struct timespec& atime, const struct timespec& mtime) {
+        PendingMetadata item;
+        item.path = path.string();
+        item.mode = mode;
+        item.times[0] = atime;
+        item.times[1] = mtime;
+        std::vector<PendingMetadata> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(std::move(item));
+            if (pending.size() >= METADATA_BATCH) {
+                batch.swap(pending);
+            }
+        }
+        if (!batch.empty()) {
+            applyMetadata(batch);
+        }
+    }
+
+    // 设置剩余的权限和时间；返回失败的条目数
+    size_t finish() {
+        std::vector<PendingMetadata> items;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.swap(pending);
+        }
+        return applyMetadata(items);
+    }
+
+private:
+    static constexpr size_t METADATA_BATCH = 4096;
+
+    // 批量设置权限和时间，按路径排序使同一目录的条目相邻
+    static size_t applyMetadata(std::vector<PendingMetadata>& items) {
+        std::sort(items.begin(), items.end(),
+                  [](const PendingMetadata& a, const PendingMetadata& b) { return a.path < b.path; });
+
+        size_t failed = 0;
+        for (const auto& item : items) {
+            bool ok = true;
+            if (item.mode != 0 && fchmodat(AT_FDCWD, item.path.c_str(), item.mode & 07777, 0) != 0) {
+                ok = false;
+            }
+            if ((item.times[0].tv_nsec != UTIME_OMIT || item.times[1].tv_nsec != UTIME_OMIT) &&
+                utimensat(AT_FDCWD, item.path.c_str(), item.times, AT_SYMLINK_NOFOLLOW) != 0) {
+                ok = false;
+            }
+            if (!ok) {
+                failed++;
+            }
+        }
+        if (failed > 0) {
+            std::cerr << "警告: " << failed << " 个文件的权限或时间设置失败" << std::endl;
+        }
+        return failed;
+    }
+};
+
+// 归档成员随机读取（按需恢复）：把ZIP条目、多块tar.xz或已建立索引的tar.gz中的成员当作可定位的只读流，
+// read(offset, len)只解码覆盖所需范围的压缩块，最近解码的块保存在LRU缓存中。
+// 不是线程安全的，多线程读取时每个线程各自打开一个ArchiveReader
+class ArchiveReader {
+public:
+    static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+    static constexpr size_t DEFAULT_CACHE_BLOCKS = 16;
+
+    struct MemberInfo {
+        std::string name;
+        uint64_t size = 0;
+    };
+
+private:
+    using Block = std::shared_ptr<const std::vector<unsigned char>>;
+
+    // 解码单元的来源：把某段逻辑偏移映射到所在块的起点，并解码该块
+    class Source {
+    public:
+        virtual ~Source() = default;
+        // 返回false表示offset已超出数据末尾
+        virtual bool locate(uint64_t offset, uint64_t& start) = 0;
+        virtual Block decode(uint64_t start) = 0;
+    };
+
+    // 归档原始字节（ZIP存储条目），按CHUNK_SIZE分块读取
+    class RawChunks : public Source {
+        int fd;
+        uint64_t length;
+
+    public:
+        RawChunks(int archive_fd, uint64_t archive_size) : fd(archive_fd), length(archive_size) {}
+
+        bool locate(uint64_t offset, uint64_t& start) override {
+            start = offset / CHUNK_SIZE * CHUNK_SIZE;
+            return offset < length;
+        }
+
+        Block decode(uint64_t start) override {
+            auto block = std::make_shared<std::vector<unsigned char>>(
+                static_cast<size_t>(std::min<uint64_t>(CHUNK_SIZE, length - start)));
+            size_t done = 0;
+            while (done < block->size()) {
+                ssize_t n = pread(fd, block->data() + done, block->size() - done, static_cast<off_t>(start + done));
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    throw std::runtime_error("读取归档失败: " + std::string(n < 0 ? strerror(errno) : "数据意外结束"));
+                }
+                done += static_cast<size_t>(n);
+            }
+            return block;
+        }
+    };
+
+    // ZIP deflate条目：每解出CHUNK_SIZE字节用inflateCopy保存一次解压状态（含32KB窗口），
+    // 之后定位时从不超过目标的最近检查点继续，顺序读取时直接沿用当前解压器。
+    // 检查点数量有上限，达到上限时隔一个释放一个并把间隔加倍，内存不随条目大小增长
+    class ZipDeflateChunks : public Source {
+        int fd;
+        uint64_t data_offset;
+        uint64_t compressed_size;
+        uint64_t size;
+        static constexpr size_t MAX_CHECKPOINTS = 64;
+        std::vector<std::unique_ptr<z_stream>> checkpoints;   // 第k项对应解压偏移k*spacing*CHUNK_SIZE
+        uint64_t spacing = 1;
+        std::unique_ptr<z_stream> live;
+        uint64_t live_chunk = 0;
+        std::vector<unsigned char> input;
+
+    public:
+        ZipDeflateChunks(int archive_fd, uint64_t offset, uint64_t packed_size, uint64_t unpacked_size)
+            : fd(archive_fd), data_offset(offset), compressed_size(packed_size), size(unpacked_size),
+              input(256 * 1024) {
+            std::unique_ptr<z_stream> first(new z_stream{});
+            if (inflateInit2(first.get(), -15) != Z_OK) {
+                throw std::runtime_error("无法初始化解压");
+            }
+            checkpoints.push_back(std::move(first));
+        }
+
+        ~ZipDeflateChunks() override {
+            for (auto& checkpoint : checkpoints) {
+                inflateEnd(checkpoint.get());
+            }
+            if (live) {
+                inflateEnd(live.get());
+            }
+        }
+
+        bool locate(uint64_t offset, uint64_t& start) override {
+            start = offset / CHUNK_SIZE * CHUNK_SIZE;
+            return offset < size;
+        }
+
+        Block decode(uint64_t start) override {
+            uint64_t chunk = start / CHUNK_SIZE;
+            uint64_t nearest = std::min<uint64_t>(chunk / spacing, checkpoints.size() - 1);
+            if (!live || live_chunk > chunk || nearest * spacing > live_chunk) {
+                restore(nearest);
+            }
+            auto block = std::make_shared<std::vector<unsigned char>>();
+            while (live_chunk < chunk) {
+                decodeChunk(*block);
+            }
+            decodeChunk(*block);
+            return block;
+        }
+
+    private:
+        void restore(uint64_t k) {
+            if (live) {
+                inflateEnd(live.get());
+                live.reset();
+            }
+            std::unique_ptr<z_stream> copy(new z_stream{});
+            if (inflateCopy(copy.get(), checkpoints[k].get()) != Z_OK) {
+                throw std::runtime_error("无法恢复解压检查点");
+            }
+            // 检查点里未消耗的输入不再有效，从total_in处重新读取
+            copy->next_in = input.data();
+            copy->avail_in = 0;
+            live = std::move(copy);
+            live_chunk = k * spacing;
+        }
+
+        void decodeChunk(std::vector<unsigned char>& out) {
+            uint64_t start = live_chunk * CHUNK_SIZE;
+            out.resize(static_cast<size_t>(std::min<uint64_t>(CHUNK_SIZE, size - start)));
+            live->next_out = out.data();
+            live->avail_out = static_cast<uInt>(out.size());
+            while (live->avail_out > 0) {
+                if (live->avail_in == 0) {
+                    uint64_t remaining = compressed_size - live->total_in;
+                    size_t want = static_cast<size_t>(std::min<uint64_t>(input.size(), remaining));
+                    ssize_t n = want == 0 ? 0 : pread(fd, input.data(), want,
+                                                      static_cast<off_t>(data_offset + live->total_in));
+                    if (n < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (n <= 0) {
+                        throw std::runtime_error("压缩数据意外结束");
+                    }
+                    live->next_in = input.data();
+                    live->avail_in = static_cast<uInt>(n);
+                }
+                int ret = inflate(live.get(), Z_NO_FLUSH);
+                if (ret == Z_STREAM_END) {
+                    break;
+                }
+                if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                    throw std::runtime_error("deflate数据损坏");
+                }
+            }
+            if (live->avail_out > 0) {
+                throw std::runtime_error("解压数据少于条目大小");
+            }
+
+            live_chunk++;
+            if (live_chunk == checkpoints.size() * spacing && live_chunk * CHUNK_SIZE < size) {
+                std::unique_ptr<z_stream> checkpoint(new z_stream{});
+                if (inflateCopy(checkpoint.get(), live.get()) != Z_OK) {
+                    throw std::runtime_error("无法保存解压检查点");
+                }
+                checkpoints.push_back(std::move(checkpoint));
+                if (checkpoints.size() >= MAX_CHECKPOINTS) {
+                    thinCheckpoints();
+                }
+            }
+        }
+
+        // 保留偶数项，间隔加倍；之后定位最多比原来多解压spacing-1个块
+        void thinCheckpoints() {
+            size_t kept = 0;
+            for (size_t k = 0; k < checkpoints.size(); k++) {
+                if (k % 2 == 0) {
+                    checkpoints[kept++] = std::move(checkpoints[k]);
+                } else {
+                    inflateEnd(checkpoints[k].get());
+                }
+            }
+            checkpoints.resize(kept);
+            spacing *= 2;
+        }
+    };
+
+    // 多块xz：从流尾读取索引，按解压偏移定位块后单独解码整块。
+    // 单块xz（未使用--block-size或-T压缩）整个流就是一个块
+    class XzBlocks : public Source {
+        int fd = -1;
+        lzma_index* index = nullptr;
+
+    public:
+        explicit XzBlocks(const fs::path& path) {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("无法打开归档: " + path.string());
+            }
+            try {
+                readIndex();
+            } catch (...) {
+                close(fd);
+                throw;
+            }
+        }
+
+        ~XzBlocks() override {
+            lzma_index_end(index, nullptr);
+            close(fd);
+        }
+
+        XzBlocks(const XzBlocks&) = delete;
+        XzBlocks& operator=(const XzBlocks&) = delete;
+
+        size_t blockCount() const {
+            return static_cast<size_t>(lzma_index_block_count(index));
+        }
+
+        bool locate(uint64_t offset, uint64_t& start) override {
+            lzma_index_iter iter;
+            lzma_index_iter_init(&iter, index);
+            if (lzma_index_iter_locate(&iter, offset)) {
+                return false;
+            }
+            start = iter.block.uncompressed_file_offset;
+            return true;
+        }
+
+        Block decode(uint64_t start) override {
+            lzma_index_iter iter;
+            lzma_index_iter_init(&iter, index);
+            if (lzma_index_iter_locate(&iter, start) || iter.block.uncompressed_file_offset != start) {
+                throw std::runtime_error("xz块索引不一致");
+            }
+
+            std::vector<uint8_t> packed(static_cast<size_t>(iter.block.total_size));
+            size_t done = 0;
+            while (done < packed.size()) {
+                ssize_t n = pread(fd, packed.data() + done, packed.size() - done,
+                                  static_cast<off_t>(iter.block.compressed_file_offset + done));
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    throw std::runtime_error("读取xz块失败");
+                }
+                done += static_cast<size_t>(n);
+            }
+
+            lzma_filter filters[LZMA_FILTERS_MAX + 1];
+            lzma_block block{};
+            block.version = 1;
+            block.check = iter.stream.flags->check;
+            block.filters = filters;
+            block.header_size = lzma_block_header_size_decode(packed[0]);
+            if (block.header_size > packed.size() ||
+                lzma_block_header_decode(&block, nullptr, packed.data()) != LZMA_OK) {
+                throw std::runtime_error("xz块头损坏");
+            }
+
+            auto out = std::make_shared<std::vector<unsigned char>>(static_cast<size_t>(iter.block.uncompressed_size));
+            size_t in_pos = block.header_size;
+            size_t out_pos = 0;
+            lzma_ret ret = lzma_block_compressed_size(&block, iter.block.unpadded_size);
+            if (ret == LZMA_OK) {
+                ret = lzma_block_buffer_decode(&block, nullptr, packed.data(), &in_pos, packed.size(),
+                                               out->data(), &out_pos, out->size());
+            }
+            for (size_t i = 0; filters[i].id != LZMA_VLI_UNKNOWN; i++) {
+                free(filters[i].options);
+            }
+            if (ret != LZMA_OK || out_pos != out->size()) {
+                throw std::runtime_error("xz块解码失败，错误代码: " + std::to_string(ret));
+            }
+            return out;
+        }
+
+    private:
+        void readIndex() {
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                throw std::runtime_error("无法读取归档大小");
+            }
+            lzma_stream strm = LZMA_STREAM_INIT;
+            if (lzma_file_info_decoder(&strm, &index, UINT64_MAX, static_cast<uint64_t>(st.st_size)) != LZMA_OK) {
+                throw std::runtime_error("无法初始化xz索引解码器");
+            }
+            std::vector<uint8_t> input(64 * 1024);
+            uint64_t pos = 0;
+            lzma_ret ret;
+            while (true) {
+                if (strm.avail_in == 0) {
+                    ssize_t n = pread(fd, input.data(), input.size(), static_cast<off_t>(pos));
+                    if (n < 0) {
+                        lzma_end(&strm);
+                        throw std::runtime_error("读取归档失败: " + std::string(strerror(errno)));
+                    }
+                    strm.next_in = input.data();
+                    strm.avail_in = static_cast<size_t>(n);
+                    pos += static_cast<uint64_t>(n);
+                }
+                ret = lzma_code(&strm, LZMA_RUN);
+                if (ret == LZMA_SEEK_NEEDED) {
+                    pos = strm.seek_pos;
+                    strm.avail_in = 0;
+                } else if (ret != LZMA_OK) {
+                    break;
+                }
+            }
+            lzma_end(&strm);
+            if (ret != LZMA_STREAM_END) {
+                throw std::runtime_error("无法读取xz索引，错误代码: " + std::to_string(ret));
+            }
+        }
+    };
+
+    // 带检查点索引的tar.gz：按CHUNK_SIZE分块，从最近的检查点恢复解压；
+    // 顺序读取下一块时沿用当前解压器
+    class GzChunks : public Source {
+        fs::path archive_path;
+        const TarGzSeekIndex& seek_index;
+        std::unique_ptr<TarGzSeekIndex::Inflater> live;
+
+    public:
+        GzChunks(const fs::path& path, const TarGzSeekIndex& index) : archive_path(path), seek_index(index) {}
+
+        bool locate(uint64_t offset, uint64_t& start) override {
+            start = offset / CHUNK_SIZE * CHUNK_SIZE;
+            return true;
+        }
+
+        Block decode(uint64_t start) override {
+            if (!live || live->position() != start) {
+                live = seek_index.inflaterAt(archive_path, start);
+            }
+            auto block = std::make_shared<std::vector<unsigned char>>(CHUNK_SIZE);
+            size_t done = 0;
+            while (done < block->size()) {
+                size_t n = live->read(block->data() + done, block->size() - done);
+                if (n == 0) {
+                    break;
+                }
+                done += n;
+            }
+            block->resize(done);
+            return block;
+        }
+    };
+
+    // 供libarchive解析tar头的虚拟流：数据取自块缓存，跳过的成员数据不会被解码
+    struct TarCursor {
+        ArchiveReader* reader;
+        size_t source;
+        uint64_t pos;
+        Block hold;
+    };
+
+    static la_ssize_t cursorRead(struct archive* a, void* client_data, const void** buffer) {
+        TarCursor* cursor = static_cast<TarCursor*>(client_data);
+        try {
+            uint64_t start;
+            if (!cursor->reader->sources[cursor->source]->locate(cursor->pos, start)) {
+                return 0;
+            }
+            cursor->hold = cursor->reader->block(cursor->source, start);
+            if (cursor->pos - start >= cursor->hold->size()) {
+                return 0;
+            }
+            size_t offset = static_cast<size_t>(cursor->pos - start);
+            *buffer = cursor->hold->data() + offset;
+            cursor->pos += cursor->hold->size() - offset;
+            return static_cast<la_ssize_t>(cursor->hold->size() - offset);
+        } catch (const std::exception& e) {
+            archive_set_error(a, EIO, "%s", e.what());
+            return -1;
+        }
+    }
+
+    static la_int64_t cursorSkip(struct archive*, void* client_data, la_int64_t request) {
+        static_cast<TarCursor*>(client_data)->pos += static_cast<uint64_t>(request);
+        return request;
+    }
+
+    struct Entry {
+        std::string name;
+        uint64_t size = 0;
+        uint64_t location = 0;     // ZIP条目序号 / tar成员数据偏移（tar.gz未解析时为成员头偏移）
+        bool resolved = true;
+    };
+
+    enum class Format { ZIP, TAR_XZ, TAR_GZ };
+
+    Format format;
+    fs::path archive_path;
+    std::unique_ptr<ZipCentralIndex> central;
+    TarGzSeekIndex seek_index;
+    std::vector<std::unique_ptr<Source>> sources;
+    std::map<size_t, size_t> zip_sources;    // ZIP条目序号 -> 已创建的解压来源
+    std::vector<Entry> entries;
+    std::vector<MemberInfo> infos;
+
+    // LRU块缓存，键为(来源, 块起点)
+    using CacheKey = std::pair<size_t, uint64_t>;
+    size_t cache_capacity;
+    std::list<std::pair<CacheKey, Block>> lru;
+    std::map<CacheKey, std::list<std::pair<CacheKey, Block>>::iterator> cache;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    Block block(size_t source, uint64_t start) {
+        CacheKey key(source, start);
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            hits++;
+            lru.splice(lru.begin(), lru, it->second);
+            return it->second->second;
+        }
+        misses++;
+        Block data = sources[source]->decode(start);
+        lru.emplace_front(key, data);
+        cache[key] = lru.begin();
+        if (lru.size() > cache_capacity) {
+            cache.erase(lru.back().first);
+            lru.pop_back();
+        }
+        return data;
+    }
+
+    size_t readAt(size_t source, uint64_t pos, unsigned char* buf, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+            uint64_t start;
+            if (!sources[source]->locate(pos, start)) {
+                break;
+            }
+            Block data = block(source, start);
+            if (pos - start >= data->size()) {
+                break;
+            }
+            size_t offset = static_cast<size_t>(pos - start);
+            size_t n = std::min(len - done, data->size() - offset);
+            memcpy(buf + done, data->data() + offset, n);
+            done += n;
+            pos += n;
+        }
+        return done;
+    }
+
+    // 在解压流start处打开只解析tar头的libarchive读取器
+    struct archive* openTarAt(TarCursor& cursor) {
+        struct archive* a = archive_read_new();
+        archive_read_support_format_tar(a);
+        archive_read_set_read_callback(a, cursorRead);
+        archive_read_set_skip_callback(a, cursorSkip);
+        archive_read_set_callback_data(a, &cursor);
+        if (archive_read_open1(a) != ARCHIVE_OK) {
+            std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+            archive_read_free(a);
+            throw std::runtime_error("无法读取TAR数据: " + error);
+        }
+        return a;
+    }
+
+    // 只有普通文件能按偏移直接读取：硬链接没有数据，稀疏文件的数据在tar中不连续
+    static bool isPlainFile(struct archive_entry* entry) {
+        return archive_entry_filetype(entry) == AE_IFREG && archive_entry_hardlink(entry) == nullptr &&
+               archive_entry_sparse_count(entry) == 0;
+    }
+
+    void openZip() {
+        central.reset(new ZipCentralIndex(archive_path));
+        sources.emplace_back(new RawChunks(central->fileDescriptor(), fs::file_size(archive_path)));
+        for (size_t i = 0; i < central->size(); i++) {
+            ZipCentralIndex::EntryInfo info = central->entry(i);
+            if (info.is_dir) {
+                continue;
+            }
+            entries.push_back({std::string(info.name), info.size, i});
+        }
+    }
+
+    void openTarXz() {
+        XzBlocks* blocks = new XzBlocks(archive_path);
+        sources.emplace_back(blocks);
+
+        TarCursor cursor{this, 0, 0, nullptr};
+        struct archive* a = openTarAt(cursor);
+        struct archive_entry* entry;
+        int r;
+        while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+            if (isPlainFile(entry)) {
+                entries.push_back({archive_entry_pathname(entry), static_cast<uint64_t>(archive_entry_size(entry)),
+                                   static_cast<uint64_t>(archive_filter_bytes(a, 0))});
+            }
+            archive_read_data_skip(a);
+        }
+        std::string error = (r != ARCHIVE_EOF && archive_error_string(a)) ? archive_error_string(a) : "";
+        archive_read_free(a);
+        if (r != ARCHIVE_EOF) {
+            throw std::runtime_error("读取成员表失败: " + error);
+        }
+        std::cout << "xz索引: " << blocks->blockCount() << " 个块, " << entries.size() << " 个成员" << std::endl;
+    }
+
+    void openTarGz() {
+        seek_index = TarGzSeekIndex::open(archive_path);
+        sources.emplace_back(new GzChunks(archive_path, seek_index));
+        for (const auto& member : seek_index.entries()) {
+            if (!member.name.empty() && member.name.back() != '/') {
+                entries.push_back({member.name, member.size, member.header_offset, false});
+            }
+        }
+    }
+
+public:
+    // 成员的只读视图，依赖创建它的ArchiveReader
+    class Member {
+        ArchiveReader* reader;
+        size_t source;
+        uint64_t data_offset;
+        uint64_t length;
+
+    public:
+        Member(ArchiveReader* owner, size_t source_id, uint64_t offset, uint64_t size)
+            : reader(owner), source(source_id), data_offset(offset), length(size) {}
+
+        uint64_t size() const {
+            return length;
+        }
+
+        // 从成员内offset处读取最多len字节，返回实际读取的字节数（到达成员末尾时变少）
+        size_t read(uint64_t offset, void* buf, size_t len) {
+            if (offset >= length) {
+                return 0;
+            }
+            len = static_cast<size_t>(std::min<uint64_t>(len, length - offset));
+            size_t n = reader->readAt(source, data_offset + offset, static_cast<unsigned char*>(buf), len);
+            if (n != len) {
+                throw std::runtime_error("成员数据不完整");
+            }
+            return n;
+        }
+    };
+
+    explicit ArchiveReader(const fs::path& path, size_t cache_blocks = DEFAULT_CACHE_BLOCKS)
+        : archive_path(path), cache_capacity(std::max<size_t>(cache_blocks, 1)) {
+        if (!fs::exists(archive_path)) {
+            throw std::runtime_error("归档文件不存在: " + archive_path.string());
+        }
+        std::string name = archive_path.filename().string();
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        auto endsWith = [&](const std::string& suffix) {
+            return name.size() >= suffix.size() &&
+                   name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+        };
+
+        if (endsWith(".zip")) {
+            format = Format::ZIP;
+            openZip();
+        } else if (endsWith(".tar.xz") || endsWith(".txz")) {
+            format = Format::TAR_XZ;
+            openTarXz();
+        } else if (endsWith(".tar.gz") || endsWith(".tgz")) {
+            format = Format::TAR_GZ;
+            openTarGz();
+        } else {
+            throw std::runtime_error("不支持随机读取的归档格式: " + archive_path.string());
+        }
+
+        for (const auto& entry : entries) {
+            infos.push_back({entry.name, entry.size});
+        }
+    }
+
+    ArchiveReader(const ArchiveReader&) = delete;
+    ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+    const std::vector<MemberInfo>& members() const {
+        return infos;
+    }
+
+    // 打开成员；ZIP的deflate条目在首次打开时创建解压来源，tar.gz成员在此时解析头部以确定数据偏移
+    Member open(const std::string& member_name) {
+        auto it = std::find_if(entries.begin(), entries.end(),
+                               [&](const Entry& e) { return e.name == member_name; });
+        if (it == entries.end()) {
+            throw std::runtime_error("归档中没有该成员: " + member_name);
+        }
+
+        if (format == Format::ZIP) {
+            size_t index = static_cast<size_t>(it->location);
+            ZipCentralIndex::EntryInfo info = central->entry(index);
+            int64_t data_offset = central->dataOffset(index);
+            if (data_offset < 0) {
+                throw std::runtime_error("ZIP本地文件头损坏: " + member_name);
+            }
+            if (info.flags & 1) {
+                throw std::runtime_error("加密条目不支持随机读取: " + member_name);
+            }
+            if (info.method == ZIP_CM_STORE) {
+                return Member(this, 0, static_cast<uint64_t>(data_offset), info.size);
+            }
+            if (info.method != ZIP_CM_DEFLATE) {
+                throw std::runtime_error("不支持的压缩方法: " + std::to_string(info.method));
+            }
+            auto known = zip_sources.find(index);
+            if (known == zip_sources.end()) {
+                sources.emplace_back(new ZipDeflateChunks(central->fileDescriptor(), static_cast<uint64_t>(data_offset),
+                                                          info.compressed_size, info.size));
+                known = zip_sources.emplace(index, sources.size() - 1).first;
+            }
+            return Member(this, known->second, 0, info.size);
+        }
+
+        if (!it->resolved) {
+            TarCursor cursor{this, 0, it->location, nullptr};
+            struct archive* a = openTarAt(cursor);
+            struct archive_entry* entry;
+            int r = archive_read_next_header(a, &entry);
+            bool plain = r == ARCHIVE_OK && isPlainFile(entry);
+            uint64_t data_offset = it->location + static_cast<uint64_t>(archive_filter_bytes(a, 0));
+            std::string error = (r != ARCHIVE_OK && archive_error_string(a)) ? archive_error_string(a) : "";
+            archive_read_free(a);
+            if (r != ARCHIVE_OK) {
+                throw std::runtime_error("无法解析成员头部: " + error);
+            }
+            if (!plain) {
+                throw std::runtime_error("只能随机读取普通文件: " + member_name);
+            }
+            it->location = data_offset;
+            it->resolved = true;
+        }
+
+        return Member(this, 0, it->location, it->size);
+    }
+
+    // 缓存命中/解码次数，用于观察随机读取的开销
+    uint64_t cacheHits() const {
+        return hits;
+    }
+
+    uint64_t blocksDecoded() const {
+        return misses;
+    }
+};
+
+class ArchiveExtractor {
+private:
+    // 解压进度回调函数类型
+    using ProgressCallback = void(*)(const std::string&, size_t, size_t, void*);
+    
+    // 默认进度回调函数
+    static void defaultProgressCallback(const std::string& filename, 
+                                       size_t current, size_t total, void* userdata) {
+        if (total > 0) {
+            int percent = static_cast<int>((current * 100) / total);
+            std::cout << "\r解压中: " << std::setw(50) << std::left 
+                      << (filename.length() > 50 ? filename.substr(0, 47) + "..." : filename)
+                      << " " << percent << "% (" << current << "/" << total << " 字节)";
+            std::cout.flush();
+        }
+    }
+
+public:
+    // 恢复策略：OVERWRITE覆盖全部文件；SKIP_SAME_SIZE_MTIME跳过大小和修改时间与条目一致的已有文件，
+    // 不解压其数据；SKIP_SAME_CRC在此基础上再计算已有文件的CRC32与条目记录比对（tar不记录数据校验值，
+    // 退化为只比较大小和时间）。中断后重新执行时只需恢复缺失或不同的文件
+    enum class RestorePolicy {
+        OVERWRITE,
+        SKIP_SAME_SIZE_MTIME,
+        SKIP_SAME_CRC
+    };
+    
+    // ZIP解包
+    static void unpackZipFile(const std::string& path, const std::string& file,
+                             const std::string& output_dir = "",
+                             ProgressCallback progress_cb = nullptr,
+                             void* userdata = nullptr,
+                             RestorePolicy policy = RestorePolicy::OVERWRITE) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        fs::path extract_path = output_dir.empty() ? path : output_dir;
+        
+        try {
+            // 检查文件是否存在
+            if (!fs::exists(archive_path)) {
+                throw std::runtime_error("归档文件不存在: " + archive_path.string());
+            }
+            
+            // 创建解压目录
+            fs::create_directories(extract_path);
+            
+            std::cout << "正在解压ZIP文件: " << archive_path.string() << std::endl;
+            std::cout << "解压到: " << extract_path.string() << std::endl;
+            
+            // 打开ZIP文件
+            int error = 0;
+            zip_t* zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &error);
+            if (!zip) {
+                throw std::runtime_error("无法打开ZIP文件，错误代码: " + std::to_string(error));
+            }
+            
+            // 获取文件数量
+            zip_int64_t num_entries = zip_get_num_entries(zip, ZIP_FL_UNCHANGED);
+            std::cout << "包含 " << num_entries << " 个文件" << std::endl;
+            
+            // 遍历并解压所有文件
+            zip_int64_t total_extracted = 0;
+            zip_int64_t total_skipped = 0;
+            zip_int64_t total_unchanged = 0;
+            ExtractionWriter writer;
+            writer.addRoot(extract_path);
+            std::unique_ptr<ZipCentralIndex> central = openCentralIndex(archive_path, num_entries);
+            
+            for (zip_int64_t i = 0; i < num_entries; i++) {
+                const char* name = zip_get_name(zip, i, ZIP_FL_ENC_RAW);
+                if (!name) {
+                    std::cerr << "警告: 无法获取第 " << i << " 个条目的名称" << std::endl;
+                    continue;
+                }
+                
+                // 安全检查：防止路径遍历攻击
+                if (!isSafePath(name)) {
+                    std::cerr << "警告: 跳过不安全路径: " << name << std::endl;
+                    total_skipped++;
+                    continue;
+                }
+                
+                fs::path full_path = extract_path / name;
+                
+                // 获取文件信息
+                struct zip_stat st;
+                zip_stat_init(&st);
+                if (zip_stat_index(zip, i, 0, &st) != 0) {
+                    std::cerr << "警告: 无法获取文件信息: " << name << std::endl;
+                    continue;
+                }
+                
+                // 检查是否是目录
+                if (st.name[strlen(st.name) - 1] == '/') {
+                    // 创建目录
+                    try {
+                        writer.ensureDirectory(full_path);
+                        std::cout << "创建目录: " << name << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cerr << "警告: " << e.what() << std::endl;
+                    }
+                } else if (policy != RestorePolicy::OVERWRITE && isUnchangedZipEntry(full_path, st, policy)) {
+                    // 目标文件已存在且一致，不打开条目
+                    total_unchanged++;
+                } else if (isZipSymlink(zip, i)) {
+                    // 符号链接（打包时重复文件以指向原件的链接保存）
+                    if (extractZipSymlink(zip, i, st, full_path, writer)) {
+                        total_extracted++;
+                    } else {
+                        std::cerr << "错误: 解压失败: " << name << std::endl;
+                    }
+                } else {
+                    // 解压文件
+                    if (extractZipEntry(zip, i, st, full_path, writer, central.get(), progress_cb, userdata)) {
+                        total_extracted++;
+                    } else {
+                        std::cerr << "错误: 解压失败: " << name << std::endl;
+                    }
+                }
+            }
+            
+            // 关闭ZIP文件
+            zip_close(zip);
+            writer.finish();
+            
+            std::cout << "\n解压完成!" << std::endl;
+            std::cout << "成功解压: " << total_extracted << " 个文件" << std::endl;
+            if (total_unchanged > 0) {
+                std::cout << "未变化: " << total_unchanged << " 个文件" << std::endl;
+            }
+            if (total_skipped > 0) {
+                std::cout << "跳过: " << total_skipped << " 个不安全文件" << std::endl;
+            }
+            
+        } catch (const std::exception& e) {
+            std::cerr << "\nZIP解压错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+    // ZIP并行解包：目录先由主线程统一创建，文件条目按大小从大到小由各工作线程领取，
+    // 每个线程使用独立的zip_t读取句柄同时解压和写入；进度回调经互斥锁串行调用
+    static void unpackZipFileParallel(const std::string& path, const std::string& file,
+                                     const std::string& output_dir = "",
+                                     size_t thread_count = 0,
+                                     ProgressCallback progress_cb = nullptr,
+                                     void* userdata = nullptr,
+                                     RestorePolicy policy = RestorePolicy::OVERWRITE) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        fs::path extract_path = output_dir.empty() ? path : output_dir;
+        
+        try {
+            // 检查文件是否存在
+            if (!fs::exists(archive_path)) {
+                throw std::runtime_error("归档文件不存在: " + archive_path.string());
+            }
+            
+            // 创建解压目录
+            fs::create_directories(extract_path);
+            
+            std::cout << "正在并行解压ZIP文件: " << archive_path.string() << std::endl;
+            std::cout << "解压到: " << extract_path.string() << std::endl;
+            
+            // 打开ZIP文件
+            int error = 0;
+            zip_t* zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &error);
+            if (!zip) {
+                throw std::runtime_error("无法打开ZIP文件，错误代码: " + std::to_string(error));
+            }
+            
+            // 扫描条目：创建全部目录，收集待解压的文件和符号链接
+            std::vector<ZipTask> tasks;
+            std::vector<ZipTask> links;
+            ExtractionWriter writer;
+            writer.addRoot(extract_path);
+            zip_int64_t num_entries = zip_get_num_entries(zip, ZIP_FL_UNCHANGED);
+            std::unique_ptr<ZipCentralIndex> central = openCentralIndex(archive_path, num_entries);
+            size_t total_skipped = 0;
+            size_t total_unchanged = 0;
+            for (zip_int64_t i = 0; i < num_entries; i++) {
+                const char* name = zip_get_name(zip, i, ZIP_FL_ENC_RAW);
+                if (!name) {
+                    std::cerr << "警告: 无法获取第 " << i << " 个条目的名称" << std::endl;
+                    continue;
+                }
+                
+                // 安全检查：防止路径遍历攻击
+                if (!isSafePath(name)) {
+                    std::cerr << "警告: 跳过不安全路径: " << name << std::endl;
+                    total_skipped++;
+                    continue;
+                }
+                
+                ZipTask task;
+                task.index = i;
+                task.full_path = extract_path / name;
+                zip_stat_init(&task.st);
+                if (zip_stat_index(zip, i, 0, &task.st) != 0) {
+                    std::cerr << "警告: 无法获取文件信息: " << name << std::endl;
+                    continue;
+                }
+                
+                bool is_dir = name[strlen(name) - 1] == '/';
+                try {
+                    writer.ensureDirectory(is_dir ? task.full_path : task.full_path.parent_path());
+                } catch (const std::exception& e) {
+                    // 目录条目就此跳过；文件条目仍交给工作线程，在那里再次检查并计为失败
+                    std::cerr << "警告: " << e.what() << std::endl;
+                }
+                if (is_dir) {
+                    continue;
+                }
+                if (policy != RestorePolicy::OVERWRITE && isUnchangedZipEntry(task.full_path, task.st, policy)) {
+                    total_unchanged++;
+                    continue;
+                }
+                if (isZipSymlink(zip, i)) {
+                    links.push_back(task);
+                } else {
+                    tasks.push_back(task);
+                }
+            }
+            
+            // 大文件先解压，避免最后只剩一个线程处理大文件
+            std::sort(tasks.begin(), tasks.end(),
+                      [](const ZipTask& a, const ZipTask& b) { return a.st.size > b.st.size; });
+            
+            if (thread_count == 0) {
+                thread_count = std::max(1u, std::thread::hardware_concurrency());
+            }
+            thread_count = std::max<size_t>(1, std::min(thread_count, tasks.size()));
+            std::cout << "包含 " << tasks.size() + links.size() << " 个文件, 使用 " << thread_count << " 个线程" << std::endl;
+            
+            LockedProgress progress;
+            progress.callback = progress_cb;
+            progress.userdata = userdata;
+            
+            std::atomic<size_t> next_task{0};
+            std::atomic<size_t> total_extracted{0};
+            std::atomic<size_t> total_failed{0};
+            
+            auto worker = [&]() {
+                // 每个线程独立打开归档，libzip的zip_t不能跨线程共享
+                int worker_error = 0;
+                zip_t* worker_zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &worker_error);
+                if (!worker_zip) {
+                    std::cerr << ("错误: 工作线程无法打开ZIP文件，错误代码: " + std::to_string(worker_error) + "\n");
+                    return;
+                }
+                
+                size_t i;
+                while ((i = next_task++) < tasks.size()) {
+                    const ZipTask& task = tasks[i];
+                    bool ok = false;
+                    try {
+                        ok = extractZipEntry(worker_zip, task.index, task.st, task.full_path,
+                                             writer, central.get(),
+                                             progress_cb ? lockedProgressCallback : nullptr, &progress);
+                    } catch (const std::exception& e) {
+                        std::cerr << ("错误: " + std::string(task.st.name) + ": " + e.what() + "\n");
+                    }
+                    if (ok) {
+                        total_extracted++;
+                    } else {
+                        total_failed++;
+                        std::cerr << ("错误: 解压失败: " + std::string(task.st.name) + "\n");
+                    }
+                }
+                
+                zip_close(worker_zip);
+            };
+            
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < thread_count; t++) {
+                workers.emplace_back(worker);
+            }
+            for (auto& w : workers) {
+                w.join();
+            }
+            
+            // 符号链接在全部文件写完后再创建（与libarchive相同）：工作线程打开文件时只有最后一级
+            // 受O_NOFOLLOW保护，不能让上级目录在写入期间被替换为链接
+            for (const ZipTask& task : links) {
+                bool ok = false;
+                try {
+                    ok = extractZipSymlink(zip, task.index, task.st, task.full_path, writer);
+                } catch (const std::exception& e) {
+                    std::cerr << "错误: " << task.st.name << ": " << e.what() << std::endl;
+                }
+                if (ok) {
+                    total_extracted++;
+                } else {
+                    total_failed++;
+                    std::cerr << "错误: 解压失败: " << task.st.name << std::endl;
+                }
+            }
+            
+            // 条目名称由扫描用的句柄持有，全部完成后再关闭
+            zip_close(zip);
+            writer.finish();
+            
+            // 工作线程打开失败时剩余的条目未被处理
+            size_t unprocessed = tasks.size() + links.size() -
+                                 std::min(tasks.size() + links.size(), total_extracted + total_failed);
+            
+            std::cout << "\n解压完成!" << std::endl;
+            std::cout << "成功解压: " << total_extracted << " 个文件" << std::endl;
+            if (total_unchanged > 0) {
+                std::cout << "未变化: " << total_unchanged << " 个文件" << std::endl;
+            }
+            if (total_failed + unprocessed > 0) {
+                std::cout << "失败: " << total_failed + unprocessed << " 个文件" << std::endl;
+            }
+            if (total_skipped > 0) {
+                std::cout << "跳过: " << total_skipped << " 个不安全文件" << std::endl;
+            }
+            
+        } catch (const std::exception& e) {
+            std::cerr << "\nZIP并行解压错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+private:
+    // 并行解包的一个文件条目
+    struct ZipTask {
+        zip_int64_t index = 0;
+        struct zip_stat st;
+        fs::path full_path;
+    };
+    
+    // 把用户的进度回调包装为串行调用
+    struct LockedProgress {
+        std::mutex mutex;
+        ProgressCallback callback = nullptr;
+        void* userdata = nullptr;
+    };
+    
+    static void lockedProgressCallback(const std::string& filename,
+                                       size_t current, size_t total, void* userdata) {
+        LockedProgress* progress = static_cast<LockedProgress*>(userdata);
+        std::lock_guard<std::mutex> lock(progress->mutex);
+        progress->callback(filename, current, total, progress->userdata);
+    }
+    
+    // 目标是否为与条目一致的普通文件：大小相同、修改时间相差不超过mtime_tolerance秒，
+    // crc非空时再比较已有文件的CRC32
+    static bool isUnchangedFile(const fs::path& target, uint64_t size, time_t mtime,
+                                time_t mtime_tolerance, const uint32_t* crc) {
+        struct stat st;
+        if (lstat(target.c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+            static_cast<uint64_t>(st.st_size) != size) {
+            return false;
+        }
+        time_t diff = st.st_mtime > mtime ? st.st_mtime - mtime : mtime - st.st_mtime;
+        if (diff > mtime_tolerance) {
+            return false;
+        }
+        return !crc || fileCrc32(target) == *crc;
+    }
+    
+    // ZIP的修改时间为DOS格式，精度2秒
+    static bool isUnchangedZipEntry(const fs::path& target, const struct zip_stat& st, RestorePolicy policy) {
+        if (!(st.valid & ZIP_STAT_SIZE) || !(st.valid & ZIP_STAT_MTIME)) {
+            return false;
+        }
+        uint32_t crc = st.crc;
+        bool check_crc = policy == RestorePolicy::SKIP_SAME_CRC && (st.valid & ZIP_STAT_CRC);
+        return isUnchangedFile(target, st.size, st.mtime, 2, check_crc ? &crc : nullptr);
+    }
+    
+    static uint32_t fileCrc32(const fs::path& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return 0;
+        }
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        std::vector<Bytef> buffer(ExtractionWriter::BUFFER_SIZE);
+        uLong crc = crc32(0L, Z_NULL, 0);
+        ssize_t n;
+        while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) {
+            crc = crc32(crc, buffer.data(), static_cast<uInt>(n));
+        }
+        close(fd);
+        return static_cast<uint32_t>(crc);
+    }
+    
+private:
+    // 提取ZIP条目
+    static bool extractZipEntry(zip_t* zip, zip_int64_t index, 
+                               const struct zip_stat& st,
+                               const fs::path& output_path,
+                               ExtractionWriter& writer,
+                               const ZipCentralIndex* central,
+                               ProgressCallback progress_cb,
+                               void* userdata) {
+        
+        // 确保父目录存在（已创建过的目录由写入器缓存）；路径中有非目录时只跳过该条目
+        try {
+            writer.ensureDirectory(output_path.parent_path());
+        } catch (const std::exception& e) {
+            std::cerr << ("警告: " + std::string(e.what()) + "\n");
+            return false;
+        }
+        
+        // 未压缩且未加密的条目直接从归档文件拷贝数据区间
+        int64_t stored_offset = central ? storedDataOffset(*central, index, st) : -1;
+        if (stored_offset >= 0) {
+            return copyStoredEntry(zip, index, *central, stored_offset, st, output_path, writer, progress_cb, userdata);
+        }
+        
+        // 打开ZIP条目
+        zip_file_t* zf = zip_fopen_index(zip, index, 0);
+        if (!zf) {
+            return false;
+        }
+        
+        try {
+            // 整行一次输出，并行解压时不会与其他线程交错
+            std::cout << ("解压文件: " + std::string(st.name) + " (" + std::to_string(st.size) + " 字节)\n");
+            
+            // 创建输出文件，按条目大小预分配
+            ExtractionWriter::File out_file;
+            if (!out_file.open(output_path, st.size)) {
+                zip_fclose(zf);
+                return false;
+            }
+            
+            // 直接解压到写入缓冲中
+            zip_uint64_t total_read = 0;
+            
+            while (total_read < st.size) {
+                zip_int64_t bytes_read = zip_fread(zf, out_file.space(), out_file.spaceSize());
+                if (bytes_read < 0) {
+                    zip_fclose(zf);
+                    return false;
+                }
+                
+                if (bytes_read == 0) {
+                    break;
+                }
+                if (!out_file.commit(static_cast<size_t>(bytes_read))) {
+                    zip_fclose(zf);
+                    return false;
+                }
+                total_read += bytes_read;
+                
+                // 调用进度回调
+                if (progress_cb) {
+                    progress_cb(st.name, total_read, st.size, userdata);
+                }
+            }
+            
+            zip_fclose(zf);
+            if (!out_file.close()) {
+                return false;
+            }
+            
+            deferZipMetadata(zip, index, st, output_path, writer);
+            
+            return true;
+            
+        } catch (...) {
+            zip_fclose(zf);
+            throw;
+        }
+    }
+    
+    // 权限取自Unix外部属性，时间取自条目修改时间，全部解压完成后统一设置
+    static void deferZipMetadata(zip_t* zip, zip_int64_t index,
+                                 const struct zip_stat& st,
+                                 const fs::path& output_path,
+                                 ExtractionWriter& writer) {
+        mode_t mode = 0;
+        zip_uint8_t opsys = 0;
+        zip_uint32_t attributes = 0;
+        if (zip_file_get_external_attributes(zip, index, 0, &opsys, &attributes) == 0 &&
+            opsys == ZIP_OPSYS_UNIX) {
+            mode = (attributes >> 16) & 07777;
+        }
+        struct timespec atime = {0, UTIME_OMIT};
+        struct timespec mtime = {0, UTIME_OMIT};
+        if (st.valid & ZIP_STAT_MTIME) {
+            mtime.tv_sec = st.mtime;
+            mtime.tv_nsec = 0;
+        }
+        writer.deferMetadata(output_path, mode, atime, mtime);
+    }
+    
+    // 打开中央目录索引用于定位未压缩条目；条目数与libzip不一致或无法解析时不使用
+    static std::unique_ptr<ZipCentralIndex> openCentralIndex(const fs::path& archive_path,
+                                                             zip_int64_t num_entries) {
+        try {
+            std::unique_ptr<ZipCentralIndex> central(new ZipCentralIndex(archive_path));
+            if (static_cast<zip_int64_t>(central->size()) == num_entries) {
+                return central;
+            }
+        } catch (const std::exception&) {
+        }
+        return nullptr;
+    }
+    
+    // 未压缩、未加密条目的数据偏移；其他条目返回-1
+    static int64_t storedDataOffset(const ZipCentralIndex& central, zip_int64_t index,
+                                    const struct zip_stat& st) {
+        if (!(st.valid & ZIP_STAT_COMP_METHOD) || st.comp_method != ZIP_CM_STORE ||
+            ((st.valid & ZIP_STAT_ENCRYPTION_METHOD) && st.encryption_method != ZIP_EM_NONE)) {
+            return -1;
+        }
+        ZipCentralIndex::EntryInfo info = central.entry(static_cast<size_t>(index));
+        if (info.method != 0 || (info.flags & 1) || info.compressed_size != st.size) {
+            return -1;
+        }
+        return central.dataOffset(static_cast<size_t>(index));
+    }
+    
+    // 拷贝未压缩条目；数据不经过libzip。不预分配，以便文件系统使用reflink。
+    // 与libzip一样校验CRC：缓冲拷贝时边拷贝边计算，内核拷贝时写完后重新读取输出文件计算，
+    // 不一致时删除输出并返回失败
+    static bool copyStoredEntry(zip_t* zip, zip_int64_t index,
+                               const ZipCentralIndex& central, int64_t data_offset,
+                               const struct zip_stat& st,
+                               const fs::path& output_path,
+                               ExtractionWriter& writer,
+                               ProgressCallback progress_cb,
+                               void* userdata) {
+        
+        std::cout << ("解压文件: " + std::string(st.name) + " (" + std::to_string(st.size) + " 字节, 直接拷贝)\n");
+        
+        ExtractionWriter::File out_file;
+        if (!out_file.open(output_path, 0)) {
+            return false;
+        }
+        
+        // 分段拷贝以便报告进度
+        const uint64_t chunk = 64ULL * 1024 * 1024;
+        uint64_t copied = 0;
+        uLong crc = crc32(0L, Z_NULL, 0);
+        while (copied < st.size) {
+            uint64_t n = std::min(chunk, st.size - copied);
+            if (!out_file.copyFrom(central.fileDescriptor(), static_cast<uint64_t>(data_offset) + copied, n, &crc)) {
+                return false;
+            }
+            copied += n;
+            if (progress_cb) {
+                progress_cb(st.name, copied, st.size, userdata);
+            }
+        }
+        if (!out_file.close()) {
+            return false;
+        }
+        if (st.valid & ZIP_STAT_CRC) {
+            uint32_t actual = out_file.kernelCopied() ? fileCrc32(output_path) : static_cast<uint32_t>(crc);
+            if (actual != st.crc) {
+                std::cerr << ("错误: CRC校验失败: " + std::string(st.name) + "\n");
+                unlink(output_path.c_str());
+                return false;
+            }
+        }
+        
+        deferZipMetadata(zip, index, st, output_path, writer);
+        return true;
+    }
+    
+    // 条目是否为Unix符号链接（外部属性高16位为st_mode）
+    static bool isZipSymlink(zip_t* zip, zip_int64_t index) {
+        zip_uint8_t opsys = 0;
+        zip_uint32_t attributes = 0;
+        if (zip_file_get_external_attributes(zip, index, 0, &opsys, &attributes) != 0) {
+            return false;
+        }
+        return opsys == ZIP_OPSYS_UNIX && S_ISLNK(attributes >> 16);
+    }
+    
+    // 恢复符号链接；链接内容为目标路径，目标不得指向解压目录之外
+    static bool extractZipSymlink(zip_t* zip, zip_int64_t index,
+                                 const struct zip_stat& st,
+                                 const fs::path& output_path,
+                                 ExtractionWriter& writer) {
+        
+        if (st.size == 0 || st.size > 4096) {
+            return false;
+        }
+        
+        zip_file_t* zf = zip_fopen_index(zip, index, 0);
+        if (!zf) {
+            return false;
+        }
+        std::string target(st.size, '\0');
+        zip_int64_t bytes_read = zip_fread(zf, &target[0], st.size);
+        zip_fclose(zf);
+        if (bytes_read != static_cast<zip_int64_t>(st.size)) {
+            return false;
+        }
+        
+        // 只按字面检查不够：目标经过已有的链接时，其后的..会相对链接指向的位置回溯。
+        // 因此..只允许出现在开头（打包重复文件时生成的相对路径即为此形式），
+        // 此时回溯的都是真实的上级目录，其后只向下进入各级，经过的链接均已检查过
+        bool descending = false;
+        bool inner_dotdot = false;
+        for (const auto& part : fs::path(target)) {
+            if (part == "..") {
+                inner_dotdot = inner_dotdot || descending;
+            } else if (part != ".") {
+                descending = true;
+            }
+        }
+        fs::path resolved = (fs::path(st.name).parent_path() / target).lexically_normal();
+        if (fs::path(target).is_absolute() || inner_dotdot || resolved.empty() || *resolved.begin() == "..") {
+            std::cerr << "警告: 跳过指向解压目录之外的链接: " << st.name << " -> " << target << std::endl;
+            return false;
+        }
+        
+        try {
+            writer.ensureDirectory(output_path.parent_path());
+        } catch (const std::exception& e) {
+            std::cerr << ("警告: " + std::string(e.what()) + "\n");
+            return false;
+        }
+        writer.forget(output_path);
+        std::error_code ec;
+        fs::remove(output_path, ec);
+        fs::create_symlink(target, output_path, ec);
+        if (ec) {
+            return false;
+        }
+        
+        std::cout << "创建链接: " << st.name << " -> " << target << std::endl;
+        return true;
+    }
+    
+    // 检查路径是否安全
+    static bool isSafePath(const std::string& path) {
+        // 检查路径遍历攻击（如包含..或绝对路径）
+        if (path.find("..") != std::string::npos) {
+            return false;
+        }
+        
+        // 检查绝对路径
+        if (path.length() > 0 && (path[0] == '/' || path[0] == '\\')) {
+            return false;
+        }
+        
+        // 检查Windows驱动器路径
+        if (path.length() > 1 && path[1] == ':') {
+            return false;
+        }
+        
+        return true;
+    }
+
+public:
+    // TAR.GZ解包
+    static void unpackTarFile(const std::string& path, const std::string& file,
+                             const std::string& output_dir = "",
+                             bool strip_components = 0,
+                             ProgressCallback progress_cb = nullptr,
+                             void* userdata = nullptr,
+                             RestorePolicy policy = RestorePolicy::OVERWRITE) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        fs::path extract_path = output_dir.empty() ? path : output_dir;
+        
+        try {
+            // 检查文件是否存在
+            if (!fs::exists(archive_path)) {
+                throw std::runtime_error("归档文件不存在: " + archive_path.string());
+            }
+            
+            // 创建解压目录
+            fs::create_directories(extract_path);
+            
+            std::cout << "正在解压TAR.GZ文件: " << archive_path.string() << std::endl;
+            std::cout << "解压到: " << extract_path.string() << std::endl;
+            
+            // 创建读取归档对象
+            struct archive* a = archive_read_new();
+            archive_read_support_format_all(a);
+            archive_read_support_filter_all(a);
+            
+            // 打开归档文件
+            if (archive_read_open_filename(a, archive_path.string().c_str(), 10240) != ARCHIVE_OK) {
+                archive_read_free(a);
+                throw std::runtime_error("无法打开TAR.GZ文件");
+            }
+            
+            try {
+                extractEntries(a, extract_path, strip_components, 0, progress_cb, userdata, policy);
+            } catch (...) {
+                archive_read_free(a);
+                throw;
+            }
+            archive_read_close(a);
+            archive_read_free(a);
+            
+        } catch (const std::exception& e) {
+            std::cerr << "\nTAR解压错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+    // 递归解压：外层条目中的归档（按魔数识别，最多展开max_depth层）直接从数据流展开到
+    // 去掉扩展名的同名目录，中间归档不写入磁盘
+    static void unpackRecursive(const std::string& path, const std::string& file,
+                               const std::string& output_dir = "",
+                               int max_depth = 4,
+                               ProgressCallback progress_cb = nullptr,
+                               void* userdata = nullptr) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        fs::path extract_path = output_dir.empty() ? fs::path(path) : fs::path(output_dir);
+        
+        try {
+            if (!fs::exists(archive_path)) {
+                throw std::runtime_error("归档文件不存在: " + archive_path.string());
+            }
+            fs::create_directories(extract_path);
+            
+            std::cout << "正在递归解压: " << archive_path.string() << std::endl;
+            std::cout << "解压到: " << extract_path.string() << std::endl;
+            
+            struct archive* a = archive_read_new();
+            archive_read_support_format_all(a);
+            archive_read_support_filter_all(a);
+            if (archive_read_open_filename(a, archive_path.string().c_str(), 10240) != ARCHIVE_OK) {
+                archive_read_free(a);
+                throw std::runtime_error("无法打开归档文件");
+            }
+            
+            try {
+                extractEntries(a, extract_path, 0, max_depth, progress_cb, userdata);
+            } catch (...) {
+                archive_read_free(a);
+                throw;
+            }
+            archive_read_close(a);
+            archive_read_free(a);
+            
+        } catch (const std::exception& e) {
+            std::cerr << "\n递归解压错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+    
+    // 输入流读取回调：返回读到的字节数，0表示结束，-1表示出错
+    using ReadCallback = ssize_t(*)(void* buffer, size_t size, void* userdata);
+    
+    // 从文件描述符（管道、套接字等不可定位的输入）流式解压，不需要先落盘
+    static void unpackStream(int fd, const std::string& output_dir,
+                            ProgressCallback progress_cb = nullptr,
+                            void* userdata = nullptr) {
+        unpackStream(readDescriptor, &fd, output_dir, progress_cb, userdata);
+    }
+    
+    // 从读取回调流式解压，解密、网络等前级可以直接供数。格式和压缩方式由数据自动识别：
+    // tar及tar.gz/bz2/xz等按流顺序读取；ZIP按本地文件头和数据描述符读取，不依赖中央目录
+    // （因此无法还原只记录在中央目录中的属性，如符号链接）
+    static void unpackStream(ReadCallback read_cb, void* read_userdata,
+                            const std::string& output_dir,
+                            ProgressCallback progress_cb = nullptr,
+                            void* userdata = nullptr) {
+        
+        fs::path extract_path = output_dir;
+        
+        try {
+            fs::create_directories(extract_path);
+            std::cout << "正在流式解压到: " << extract_path.string() << std::endl;
+            
+            StreamSource source{read_cb, read_userdata, std::vector<char>(ExtractionWriter::BUFFER_SIZE)};
+            
+            struct archive* a = archive_read_new();
+            archive_read_support_format_all(a);
+            archive_read_support_filter_all(a);
+            
+            // 不提供seek回调，libarchive只能顺序读取（ZIP使用流式读取器）
+            if (archive_read_open(a, &source, nullptr, readStreamSource, nullptr) != ARCHIVE_OK) {
+                std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+                archive_read_free(a);
+                throw std::runtime_error("无法识别输入流格式: " + error);
+            }
+            
+            try {
+                extractEntries(a, extract_path, 0, 0, progress_cb, userdata);
+            } catch (...) {
+                archive_read_free(a);
+                throw;
+            }
+            archive_read_close(a);
+            archive_read_free(a);
+            
+        } catch (const std::exception& e) {
+            std::cerr << "\n流式解压错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+    // 为TAR.GZ建立随机访问索引（<归档>.seekidx），span_mb为检查点间隔（MiB）
+    static void buildTarIndex(const std::string& path, const std::string& file, size_t span_mb = 8) {
+        fs::path archive_path = fs::path(path) / file;
+        
+        try {
+            auto start = std::chrono::steady_clock::now();
+            TarGzSeekIndex index = TarGzSeekIndex::build(archive_path, static_cast<uint64_t>(span_mb) * 1024 * 1024);
+            index.save(TarGzSeekIndex::indexPath(archive_path));
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            
+            std::cout << "索引已建立: " << TarGzSeekIndex::indexPath(archive_path).string() << std::endl;
+            std::cout << "成员: " << index.entries().size() << " 个, 检查点: " << index.pointCount()
+                      << " 个, 耗时 " << elapsed << " ms" << std::endl;
+            
+        } catch (const std::exception& e) {
+            std::cerr << "建立TAR索引错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+    
+    // 从TAR.GZ中提取单个成员：借助随机访问索引（不存在时先建立）从最近的检查点开始解压，
+    // 不再解压该成员之前的全部数据
+    static void extractTarMember(const std::string& path, const std::string& file,
+                                const std::string& member,
+                                const std::string& output_dir = "",
+                                ProgressCallback progress_cb = nullptr,
+                                void* userdata = nullptr) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        fs::path extract_path = output_dir.empty() ? fs::path(path) : fs::path(output_dir);
+        
+        try {
+            if (!isSafePath(member)) {
+                throw std::runtime_error("不安全的路径: " + member);
+            }
+            
+            TarGzSeekIndex index = TarGzSeekIndex::open(archive_path);
+            const TarGzSeekIndex::Member* target = index.find(member);
+            if (!target) {
+                throw std::runtime_error("TAR归档中不存在: " + member);
+            }
+            
+            TarGzSeekIndex::MemberReader reader(index, archive_path, *target);
+            struct archive* a = reader.archive();
+            struct archive_entry* entry;
+            if (archive_read_next_header(a, &entry) != ARCHIVE_OK || member != archive_entry_pathname(entry)) {
+                throw std::runtime_error("索引与归档内容不一致，请删除 " +
+                                         TarGzSeekIndex::indexPath(archive_path).string() + " 后重试");
+            }
+            
+            fs::create_directories(extract_path);
+            fs::path full_path = extract_path / member;
+            archive_entry_set_pathname(entry, full_path.string().c_str());
+            
+            struct archive* ext = archive_write_disk_new();
+            archive_write_disk_set_options(ext, 
+                ARCHIVE_EXTRACT_TIME |
+                ARCHIVE_EXTRACT_PERM |
+                ARCHIVE_EXTRACT_ACL |
+                ARCHIVE_EXTRACT_FFLAGS |
+                ARCHIVE_EXTRACT_SPARSE |
+                ARCHIVE_EXTRACT_SECURE_SYMLINKS |
+                ARCHIVE_EXTRACT_SECURE_NODOTDOT);
+            archive_write_disk_set_standard_lookup(ext);
+            
+            ExtractionWriter writer;
+            writer.addRoot(extract_path);
+            bool ok = extractArchiveEntry(a, ext, entry, writer, progress_cb, userdata);
+            writer.finish();
+            archive_write_close(ext);
+            archive_write_free(ext);
+            if (!ok) {
+                throw std::runtime_error("解压失败: " + member);
+            }
+            
+            std::cout << "已提取: " << member << " (解压 " << reader.inflatedBytes() << " 字节)" << std::endl;
+            
+        } catch (const std::exception& e) {
+            std::cerr << "TAR成员提取错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+
+private:
+    // 去除路径的前几个组件
+    static std::string stripPathComponents(const std::string& path, int components) {
+        std::string result = path;
+        
+        for (int i = 0; i < components; i++) {
+            size_t pos = result.find_first_of("/\\");
+            if (pos == std::string::npos) {
+                return "";  // 没有足够的组件可以去除
+            }
+            result = result.substr(pos + 1);
+        }
+        
+        return result;
+    }
+
+    struct StreamSource {
+        ReadCallback read;
+        void* userdata;
+        std::vector<char> buffer;
+    };
+    
+    static la_ssize_t readStreamSource(struct archive* a, void* client_data, const void** buffer) {
+        StreamSource* source = static_cast<StreamSource*>(client_data);
+        ssize_t n = source->read(source->buffer.data(), source->buffer.size(), source->userdata);
+        if (n < 0) {
+            archive_set_error(a, EIO, "读取输入流失败");
+            return -1;
+        }
+        *buffer = source->buffer.data();
+        return static_cast<la_ssize_t>(n);
+    }
+    
+    static ssize_t readDescriptor(void* buffer, size_t size, void* userdata) {
+        int fd = *static_cast<int*>(userdata);
+        ssize_t n;
+        do {
+            n = ::read(fd, buffer, size);
+        } while (n < 0 && errno == EINTR);
+        return n;
+    }
+    
+    // 解压已打开的libarchive读取对象中的全部条目（文件、管道或回调输入共用）
+    // nested_depth大于0时，普通文件若为归档则展开到同名目录（见extractNestedOrRegular）
+    static void extractEntries(struct archive* a, const fs::path& extract_path,
+                               int strip_components,
+                               int nested_depth,
+                               ProgressCallback progress_cb,
+                               void* userdata,
+                               RestorePolicy policy = RestorePolicy::OVERWRITE) {
+        
+        // 创建写入归档对象（用于提取）；数据块按偏移写入，稀疏条目的空洞通过跳过偏移重建，
+        // ARCHIVE_EXTRACT_SPARSE使成段的零数据同样写成空洞
+        struct archive* ext = archive_write_disk_new();
+        archive_write_disk_set_options(ext, 
+            ARCHIVE_EXTRACT_TIME |
+            ARCHIVE_EXTRACT_PERM |
+            ARCHIVE_EXTRACT_ACL |
+            ARCHIVE_EXTRACT_FFLAGS |
+            ARCHIVE_EXTRACT_SPARSE |
+            ARCHIVE_EXTRACT_SECURE_SYMLINKS |
+            ARCHIVE_EXTRACT_SECURE_NODOTDOT);
+        
+        // 设置解压目录
+        archive_write_disk_set_standard_lookup(ext);
+        
+        // 遍历并解压所有文件
+        size_t total_extracted = 0;
+        size_t total_skipped = 0;
+        size_t total_unchanged = 0;
+        ExtractionWriter writer;
+        writer.addRoot(extract_path);
+        
+        struct archive_entry* entry;
+        int r;
+        while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK) {
+            const char* entry_path = archive_entry_pathname(entry);
+            
+            // 安全检查
+            if (!isSafePath(entry_path)) {
+                std::cerr << "警告: 跳过不安全路径: " << entry_path << std::endl;
+                archive_read_data_skip(a);
+                total_skipped++;
+                continue;
+            }
+            
+            // 去除指定层级的目录（strip_components）
+            std::string adjusted_path = entry_path;
+            if (strip_components > 0) {
+                adjusted_path = stripPathComponents(entry_path, strip_components);
+                if (adjusted_path.empty()) {
+                    archive_read_data_skip(a);
+                    continue;
+                }
+            }
+            
+            // 构建完整输出路径
+            fs::path full_path = extract_path / adjusted_path;
+            
+            // 已有文件与条目一致时跳过（不可定位的压缩流仍需解码跳过的数据，但不再写盘）
+            if (policy != RestorePolicy::OVERWRITE &&
+                archive_entry_filetype(entry) == AE_IFREG && !archive_entry_hardlink(entry) &&
+                archive_entry_size_is_set(entry) && archive_entry_mtime_is_set(entry) &&
+                isUnchangedFile(full_path, static_cast<uint64_t>(archive_entry_size(entry)),
+                                archive_entry_mtime(entry), 0, nullptr)) {
+                archive_read_data_skip(a);
+                total_unchanged++;
+                continue;
+            }
+            
+            // 更新归档条目路径
+            archive_entry_set_pathname(entry, full_path.string().c_str());
+            
+            // 提取文件；允许展开内层归档时，普通文件先检查开头是否为归档
+            bool nested_candidate = nested_depth > 0 &&
+                archive_entry_filetype(entry) == AE_IFREG && !archive_entry_hardlink(entry) &&
+                (!archive_entry_size_is_set(entry) || archive_entry_size(entry) > 0);
+            if (nested_candidate
+                    ? extractNestedOrRegular(a, entry, writer, nested_depth, progress_cb, userdata)
+                    : extractArchiveEntry(a, ext, entry, writer, progress_cb, userdata)) {
+                total_extracted++;
+            } else {
+                std::cerr << "错误: 解压失败: " << entry_path << std::endl;
+            }
+        }
+        
+        // 先设置文件元数据，目录时间由libarchive在关闭时设置
+        writer.finish();
+        archive_write_close(ext);
+        archive_write_free(ext);
+        
+        // 流式输入中断或数据损坏时不能当作正常结束
+        if (r != ARCHIVE_EOF) {
+            const char* error = archive_error_string(a);
+            throw std::runtime_error(std::string("读取归档失败: ") + (error ? error : "未知错误"));
+        }
+        
+        std::cout << "\n解压完成!" << std::endl;
+        std::cout << "成功解压: " << total_extracted << " 个文件" << std::endl;
+        if (total_unchanged > 0) {
+            std::cout << "未变化: " << total_unchanged << " 个文件" << std::endl;
+        }
+        if (total_skipped > 0) {
+            std::cout << "跳过: " << total_skipped << " 个不安全文件" << std::endl;
+        }
+    }
+    
+    // 提取归档条目
+    static bool extractArchiveEntry(struct archive* a, struct archive* ext,
+                                   struct archive_entry* entry,
+                                   ExtractionWriter& writer,
+                                   ProgressCallback progress_cb,
+                                   void* userdata) {
+        
+        // 普通文件（硬链接和稀疏文件除外）由写入器直接写出，其余类型交给libarchive
+        if (archive_entry_filetype(entry) == AE_IFREG && !archive_entry_hardlink(entry) &&
+            archive_entry_sparse_count(entry) == 0) {
+            return extractRegularEntry(a, entry, writer, progress_cb, userdata);
+        }
+        if (archive_entry_filetype(entry) != AE_IFDIR) {
+            writer.forget(archive_entry_pathname(entry));
+        }
+        
+        // 写入条目头部
+        int r = archive_write_header(ext, entry);
+        if (r != ARCHIVE_OK) {
+            std::cerr << "警告: 无法写入文件头: " 
+                      << archive_entry_pathname(entry) 
+                      << " - " << archive_error_string(ext) << std::endl;
+            return false;
+        }
+        
+        // 如果是普通文件，写入内容
+        const void* buff;
+        size_t size;
+        la_int64_t offset;
+        
+        if (archive_entry_size(entry) > 0) {
+            const char* filename = archive_entry_pathname(entry);
+            la_int64_t total_size = archive_entry_size(entry);
+            la_int64_t bytes_written = 0;
+            
+            while (true) {
+                r = archive_read_data_block(a, &buff, &size, &offset);
+                if (r == ARCHIVE_EOF) {
+                    break;
+                }
+                if (r != ARCHIVE_OK) {
+                    std::cerr << "警告: 读取数据块失败: " 
+                              << archive_error_string(a) << std::endl;
+                    return false;
+                }
+                
+                r = archive_write_data_block(ext, buff, size, offset);
+                if (r != ARCHIVE_OK) {
+                    std::cerr << "警告: 写入数据块失败: " 
+                              << archive_error_string(ext) << std::endl;
+                    return false;
+                }
+                
+                bytes_written += size;
+                
+                // 调用进度回调
+                if (progress_cb) {
+                    progress_cb(filename, bytes_written, total_size, userdata);
+                }
+            }
+        }
+        
+        // 完成条目写入
+        r = archive_write_finish_entry(ext);
+        if (r != ARCHIVE_OK) {
+            std::cerr << "警告: 完成条目失败: " 
+                      << archive_error_string(ext) << std::endl;
+            return false;
+        }
+        
+        std::cout << "解压文件: " << archive_entry_pathname(entry) 
+                  << " (" << archive_entry_size(entry) << " 字节)" << std::endl;
+        
+        return true;
+    }
+    
+    // 经写入器解压普通文件：预分配、缓冲写入，权限和时间延后批量设置
+    // prefix为已从条目开头读出的数据（识别内层归档时读取），先于其余数据写入
+    static bool extractRegularEntry(struct archive* a, struct archive_entry* entry,
+                                   ExtractionWriter& writer,
+                                   ProgressCallback progress_cb,
+                                   void* userdata,
+                                   const std::vector<char>* prefix = nullptr) {
+        
+        const char* filename = archive_entry_pathname(entry);
+        fs::path full_path = filename;
+        la_int64_t total_size = archive_entry_size(entry);
+        
+        ExtractionWriter::File out_file;
+        try {
+            writer.ensureDirectory(full_path.parent_path());
+        } catch (const std::exception& e) {
+            std::cerr << "警告: " << e.what() << std::endl;
+            return false;
+        }
+        if (!out_file.open(full_path, total_size > 0 ? static_cast<uint64_t>(total_size) : 0)) {
+            std::cerr << "警告: 无法创建文件: " << filename << " - " << strerror(errno) << std::endl;
+            return false;
+        }
+        
+        const void* buff;
+        size_t size;
+        la_int64_t offset;
+        la_int64_t bytes_written = 0;
+        
+        if (prefix && !prefix->empty()) {
+            if (!out_file.writeAt(prefix->data(), prefix->size(), 0)) {
+                std::cerr << "警告: 写入数据块失败: " << filename << " - " << strerror(errno) << std::endl;
+                return false;
+            }
+            bytes_written = static_cast<la_int64_t>(prefix->size());
+        }
+        
+        while (true) {
+            int r = archive_read_data_block(a, &buff, &size, &offset);
+            if (r == ARCHIVE_EOF) {
+                break;
+            }
+            if (r != ARCHIVE_OK) {
+                std::cerr << "警告: 读取数据块失败: " 
+                          << archive_error_string(a) << std::endl;
+                return false;
+            }
+            
+            if (!out_file.writeAt(buff, size, static_cast<uint64_t>(offset))) {
+                std::cerr << "警告: 写入数据块失败: " << filename << " - " << strerror(errno) << std::endl;
+                return false;
+            }
+            
+            bytes_written += size;
+            
+            // 调用进度回调
+            if (progress_cb) {
+                progress_cb(filename, bytes_written, total_size, userdata);
+            }
+        }
+        
+        if (!out_file.close()) {
+            std::cerr << "警告: 写入文件失败: " << filename << " - " << strerror(errno) << std::endl;
+            return false;
+        }
+        
+        struct timespec atime = {0, UTIME_OMIT};
+        struct timespec mtime = {0, UTIME_OMIT};
+        if (archive_entry_atime_is_set(entry)) {
+            atime.tv_sec = archive_entry_atime(entry);
+            atime.tv_nsec = archive_entry_atime_nsec(entry);
+        }
+        if (archive_entry_mtime_is_set(entry)) {
+            mtime.tv_sec = archive_entry_mtime(entry);
+            mtime.tv_nsec = archive_entry_mtime_nsec(entry);
+        }
+        writer.deferMetadata(full_path, archive_entry_perm(entry), atime, mtime);
+        
+        std::cout << "解压文件: " << filename << " (" << total_size << " 字节)\n";
+        
+        return true;
+    }
+
+    // 识别内层归档时读取的条目开头长度：压缩的内层归档也能在这段数据中解出第一个条目头
+    static constexpr size_t NESTED_PROBE_SIZE = 64 * 1024;
+    
+    // 普通文件条目：开头是可识别的归档时，以外层条目的数据流为输入直接展开到同名目录
+    // （内层归档不落盘，也不整体读入内存）；否则按普通文件写出
+    static bool extractNestedOrRegular(struct archive* a, struct archive_entry* entry,
+                                      ExtractionWriter& writer,
+                                      int nested_depth,
+                                      ProgressCallback progress_cb,
+                                      void* userdata) {
+        
+        std::vector<char> prefix;
+        if (!readPrefix(a, prefix, NESTED_PROBE_SIZE)) {
+            std::cerr << "警告: 读取数据块失败: " << archive_error_string(a) << std::endl;
+            return false;
+        }
+        if (!hasArchiveMagic(prefix) || !probeArchive(prefix)) {
+            return extractRegularEntry(a, entry, writer, progress_cb, userdata, &prefix);
+        }
+        
+        fs::path archive_file = archive_entry_pathname(entry);
+        fs::path inner_dir = nestedDirectory(archive_file);
+        std::cout << "展开内层归档: " << archive_file.string() << " -> " << inner_dir.string() << std::endl;
+        
+        // 内层归档的解压根目录由外层条目路径决定，必须先经外层writer逐级检查，
+        // 否则外层归档中的符号链接可把内层内容引到解压目录之外（内层addRoot不再检查）
+        try {
+            writer.ensureDirectory(inner_dir);
+        } catch (const std::exception& e) {
+            std::cerr << "警告: " << e.what() << std::endl;
+            return false;
+        }
+        
+        NestedSource source{a, &prefix, false};
+        struct archive* inner = archive_read_new();
+        supportNestedFormats(inner);
+        if (archive_read_open(inner, &source, nullptr, readNestedSource, nullptr) != ARCHIVE_OK) {
+            std::cerr << "警告: 无法读取内层归档: " << archive_error_string(inner) << std::endl;
+            archive_read_free(inner);
+            return false;
+        }
+        
+        bool ok = true;
+        try {
+            extractEntries(inner, inner_dir, 0, nested_depth - 1, progress_cb, userdata);
+        } catch (const std::exception& e) {
+            std::cerr << "警告: 内层归档解压失败: " << archive_file.string() << " - " << e.what() << std::endl;
+            ok = false;
+        }
+        archive_read_close(inner);
+        archive_read_free(inner);
+        return ok;
+    }
+    
+    // 内层归档只识别tar、zip和cpio；全部格式中的mtree等会把普通文本误认为归档
+    static void supportNestedFormats(struct archive* a) {
+        archive_read_support_format_tar(a);
+        archive_read_support_format_zip(a);
+        archive_read_support_format_cpio(a);
+        archive_read_support_filter_all(a);
+    }
+    
+    // 读取条目开头至少limit字节（不足时读到条目结束）；数据块之间的空洞补零
+    static bool readPrefix(struct archive* a, std::vector<char>& prefix, size_t limit) {
+        while (prefix.size() < limit) {
+            const void* buff;
+            size_t size;
+            la_int64_t offset;
+            int r = archive_read_data_block(a, &buff, &size, &offset);
+            if (r == ARCHIVE_EOF) {
+                break;
+            }
+            if (r != ARCHIVE_OK) {
+                return false;
+            }
+            if (static_cast<uint64_t>(offset) > prefix.size()) {
+                prefix.resize(static_cast<size_t>(offset), 0);
+            }
+            const char* data = static_cast<const char*>(buff);
+            prefix.insert(prefix.end(), data, data + size);
+        }
+        return true;
+    }
+    
+    // 压缩流（gzip、bzip2、xz、zstd、lz4）、zip或tar的魔数
+    static bool hasArchiveMagic(const std::vector<char>& prefix) {
+        auto starts = [&](const char* magic, size_t len) {
+            return prefix.size() >= len && memcmp(prefix.data(), magic, len) == 0;
+        };
+        return starts("\x1f\x8b", 2) ||
+               starts("BZh", 3) ||
+               starts("\xfd" "7zXZ\0", 6) ||
+               starts("\x28\xb5\x2f\xfd", 4) ||
+               starts("\x04\x22\x4d\x18", 4) ||
+               starts("PK\x03\x04", 4) ||
+               (prefix.size() >= 262 && memcmp(prefix.data() + 257, "ustar", 5) == 0);
+    }
+    
+    // 魔数可能只是单个压缩文件（如.log.gz），需能从开头数据中解出第一个条目头才按归档处理
+    static bool probeArchive(const std::vector<char>& prefix) {
+        struct archive* probe = archive_read_new();
+        supportNestedFormats(probe);
+        struct archive_entry* entry;
+        bool ok = archive_read_open_memory(probe, prefix.data(), prefix.size()) == ARCHIVE_OK &&
+                  archive_read_next_header(probe, &entry) == ARCHIVE_OK;
+        archive_read_free(probe);
+        return ok;
+    }
     
-    // 默认进度回调函数
-    static void defaultProgressCallback(const std::string& filename, 
-                                       size_t current, size_t total, void* userdata) {
-        if (total > 0) {
-            int percent = static_cast<int>((current * 100) / total);
-            std::cout << "\r解压中: " << std::setw(50) << std::left 
-                      << (filename.length() > 50 ? filename.substr(0, 47) + "..." : filename)
-                      << " " << percent << "% (" << current << "/" << total << " 字节)";
-            std::cout.flush();
+    // 内层归档展开到去掉扩展名的同名目录，无可识别扩展名时加.d后缀
+    static fs::path nestedDirectory(const fs::path& archive_file) {
+        static const char* suffixes[] = {
+            ".tar.gz", ".tar.bz2", ".tar.xz", ".tar.zst", ".tgz", ".tbz2", ".txz",
+            ".tar", ".zip", ".cpio", ".gz", ".bz2", ".xz", ".zst"
+        };
+        std::string name = archive_file.filename().string();
+        std::string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        for (const char* suffix : suffixes) {
+            size_t len = strlen(suffix);
+            if (lower.size() > len && lower.compare(lower.size() - len, len, suffix) == 0) {
+                return archive_file.parent_path() / name.substr(0, name.size() - len);
+            }
+        }
+        return archive_file.parent_path() / (name + ".d");
+    }
+    
+    // 内层归档的输入：先交出已读出的开头数据，再逐块读取外层条目的剩余数据
+    struct NestedSource {
+        struct archive* outer;
+        const std::vector<char>* prefix;
+        bool prefix_served;
+    };
+    
+    static la_ssize_t readNestedSource(struct archive* a, void* client_data, const void** buffer) {
+        NestedSource* source = static_cast<NestedSource*>(client_data);
+        if (!source->prefix_served) {
+            source->prefix_served = true;
+            if (!source->prefix->empty()) {
+                *buffer = source->prefix->data();
+                return static_cast<la_ssize_t>(source->prefix->size());
+            }
         }
+        size_t size;
+        la_int64_t offset;
+        int r = archive_read_data_block(source->outer, buffer, &size, &offset);
+        if (r == ARCHIVE_EOF) {
+            return 0;
+        }
+        if (r != ARCHIVE_OK) {
+            const char* error = archive_error_string(source->outer);
+            archive_set_error(a, EIO, "%s", error ? error : "读取外层归档失败");
+            return -1;
+        }
+        return static_cast<la_ssize_t>(size);
     }
 
 public:
-    // ZIP解包
-    static void unpackZipFile(const std::string& path, const std::string& file,
-                             const std::string& output_dir = "",
-                             ProgressCallback progress_cb = nullptr,
-                             void* userdata = nullptr) {
+    // 固实归档解包（格式见pack.cpp中的ArchivePacker::packSolidFile）
+    static void unpackSolidFile(const std::string& path, const std::string& file,
+                               const std::string& output_dir = "",
+                               ProgressCallback progress_cb = nullptr,
+                               void* userdata = nullptr) {
         
         fs::path archive_path = fs::path(path) / file;
-        fs::path extract_path = output_dir.empty() ? path : output_dir;
+        fs::path extract_path = output_dir.empty() ? fs::path(path) : fs::path(output_dir);
         
         try {
-            // 检查文件是否存在
-            if (!fs::exists(archive_path)) {
-                throw std::runtime_error("归档文件不存在: " + archive_path.string());
+            std::ifstream in(archive_path, std::ios::binary);
+            if (!in.is_open()) {
+                throw std::runtime_error("无法打开固实归档: " + archive_path.string());
             }
             
-            // 创建解压目录
+            SolidArchive archive = readSolidIndex(in);
             fs::create_directories(extract_path);
             
-            std::cout << "正在解压ZIP文件: " << archive_path.string() << std::endl;
-            std::cout << "解压到: " << extract_path.string() << std::endl;
-            
-            // 打开ZIP文件
-            int error = 0;
-            zip_t* zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &error);
-            if (!zip) {
-                throw std::runtime_error("无法打开ZIP文件，错误代码: " + std::to_string(error));
-            }
-            
-            // 获取文件数量
-            zip_int64_t num_entries = zip_get_num_entries(zip, ZIP_FL_UNCHANGED);
-            std::cout << "包含 " << num_entries << " 个文件" << std::endl;
-            
-            // 遍历并解压所有文件
-            zip_int64_t total_extracted = 0;
-            zip_int64_t total_skipped = 0;
+            std::cout << "正在解压固实归档: " << archive_path.string() << " 到 " 
+                      << extract_path.string() << std::endl;
             
-            for (zip_int64_t i = 0; i < num_entries; i++) {
-                const char* name = zip_get_name(zip, i, ZIP_FL_ENC_RAW);
-                if (!name) {
-                    std::cerr << "警告: 无法获取第 " << i << " 个条目的名称" << std::endl;
-                    continue;
-                }
-                
-                // 安全检查：防止路径遍历攻击
-                if (!isSafePath(name)) {
-                    std::cerr << "警告: 跳过不安全路径: " << name << std::endl;
-                    total_skipped++;
-                    continue;
-                }
-                
-                fs::path full_path = extract_path / name;
-                
-                // 获取文件信息
-                struct zip_stat st;
-                zip_stat_init(&st);
-                if (zip_stat_index(zip, i, 0, &st) != 0) {
-                    std::cerr << "警告: 无法获取文件信息: " << name << std::endl;
-                    continue;
-                }
-                
-                // 检查是否是目录
-                if (st.name[strlen(st.name) - 1] == '/') {
-                    // 创建目录
-                    fs::create_directories(full_path);
-                    std::cout << "创建目录: " << name << std::endl;
-                } else {
-                    // 解压文件
-                    if (extractZipEntry(zip, i, st, full_path, progress_cb, userdata)) {
-                        total_extracted++;
-                    } else {
-                        std::cerr << "错误: 解压失败: " << name << std::endl;
-                    }
+            // 条目按数据流顺序排列，顺序解压时每个块只解码一次
+            SolidBlockCache cache;
+            size_t extracted = 0;
+            for (const auto& entry : archive.entries) {
+                if (extractSolidEntry(in, archive, entry, extract_path, cache, progress_cb, userdata)) {
+                    extracted++;
                 }
             }
             
-            // 关闭ZIP文件
-            zip_close(zip);
-            
-            std::cout << "\n解压完成!" << std::endl;
-            std::cout << "成功解压: " << total_extracted << " 个文件" << std::endl;
-            if (total_skipped > 0) {
-                std::cout << "跳过: " << total_skipped << " 个不安全文件" << std::endl;
-            }
+            std::cout << "\n固实归档解压完成，共 " << extracted << " 个条目" << std::endl;
             
         } catch (const std::exception& e) {
-            std::cerr << "\nZIP解压错误: " << e.what() << std::endl;
+            std::cerr << "固实归档解压错误: " << e.what() << std::endl;
             throw;
         }
     }
+    
+    // 从固实归档中提取单个文件，只解码该文件所在的块
+    static void extractSolidMember(const std::string& path, const std::string& file,
+                                  const std::string& member,
+                                  const std::string& output_dir = "") {
+        
+        fs::path archive_path = fs::path(path) / file;
+        fs::path extract_path = output_dir.empty() ? fs::path(path) : fs::path(output_dir);
+        
+        std::ifstream in(archive_path, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("无法打开固实归档: " + archive_path.string());
+        }
+        
+        SolidArchive archive = readSolidIndex(in);
+        auto it = std::find_if(archive.entries.begin(), archive.entries.end(),
+                               [&](const SolidEntry& e) { return e.path == member; });
+        if (it == archive.entries.end()) {
+            throw std::runtime_error("固实归档中不存在: " + member);
+        }
+        
+        SolidBlockCache cache;
+        extractSolidEntry(in, archive, *it, extract_path, cache, nullptr, nullptr);
+        std::cout << "已提取: " << member << " (解码 " << cache.decoded_blocks << " 个块)" << std::endl;
+    }
 
 private:
-    // 提取ZIP条目
-    static bool extractZipEntry(zip_t* zip, zip_int64_t index, 
-                               const struct zip_stat& st,
-                               const fs::path& output_path,
-                               ProgressCallback progress_cb,
-                               void* userdata) {
+    struct SolidBlock {
+        uint64_t offset;
+        uint64_t compressed_size;
+        uint64_t raw_size;
+    };
+    
+    struct SolidEntry {
+        std::string path;
+        uint32_t mode;
+        int64_t mtime;
+        uint64_t size;
+        uint64_t offset;
+    };
+    
+    struct SolidArchive {
+        uint32_t block_size = 0;
+        std::vector<SolidBlock> blocks;
+        std::vector<SolidEntry> entries;
+    };
+    
+    // 最近解码的块，连续的小文件通常落在同一块中
+    struct SolidBlockCache {
+        size_t index = SIZE_MAX;
+        std::vector<uint8_t> data;
+        size_t decoded_blocks = 0;
+    };
+    
+    static uint64_t readLE(std::istream& in, int bytes) {
+        unsigned char buf[8] = {0};
+        if (!in.read(reinterpret_cast<char*>(buf), bytes)) {
+            throw std::runtime_error("固实归档索引不完整");
+        }
+        uint64_t value = 0;
+        for (int i = bytes - 1; i >= 0; i--) {
+            value = (value << 8) | buf[i];
+        }
+        return value;
+    }
+    
+    static SolidArchive readSolidIndex(std::ifstream& in) {
+        char magic[8];
+        if (!in.read(magic, 8) || std::memcmp(magic, "SOLIDARC", 8) != 0) {
+            throw std::runtime_error("不是固实归档文件");
+        }
+        uint32_t version = static_cast<uint32_t>(readLE(in, 4));
+        if (version != 1) {
+            throw std::runtime_error("不支持的固实归档版本: " + std::to_string(version));
+        }
         
-        // 确保父目录存在
-        fs::create_directories(output_path.parent_path());
+        SolidArchive archive;
+        archive.block_size = static_cast<uint32_t>(readLE(in, 4));
+        if (archive.block_size == 0) {
+            throw std::runtime_error("固实归档块大小无效");
+        }
         
-        // 打开ZIP条目
-        zip_file_t* zf = zip_fopen_index(zip, index, 0);
-        if (!zf) {
-            return false;
+        in.seekg(-16, std::ios::end);
+        uint64_t index_offset = readLE(in, 8);
+        if (!in.read(magic, 8) || std::memcmp(magic, "SOLIDEND", 8) != 0) {
+            throw std::runtime_error("固实归档尾部损坏");
         }
         
-        try {
-            std::cout << "解压文件: " << st.name << " (" << st.size << " 字节)" << std::endl;
-            
-            // 创建输出文件
-            std::ofstream out_file(output_path, std::ios::binary);
-            if (!out_file.is_open()) {
-                zip_fclose(zf);
-                return false;
-            }
-            
-            // 读取并写入数据
-            char buffer[8192];
-            zip_int64_t total_read = 0;
-            
-            while (total_read < st.size) {
-                zip_int64_t bytes_read = zip_fread(zf, buffer, sizeof(buffer));
-                if (bytes_read < 0) {
-                    zip_fclose(zf);
-                    return false;
-                }
-                
-                out_file.write(buffer, bytes_read);
-                total_read += bytes_read;
-                
-                // 调用进度回调
-                if (progress_cb) {
-                    progress_cb(st.name, total_read, st.size, userdata);
-                }
-            }
-            
-            zip_fclose(zf);
-            
-            // 设置文件权限（如果可用）
-            if (st.valid & ZIP_STAT_MTIME) {
-                // 设置修改时间
-                // 注意：fs::last_write_time需要C++20完全支持
+        in.seekg(static_cast<std::streamoff>(index_offset));
+        uint64_t block_count = readLE(in, 8);
+        for (uint64_t i = 0; i < block_count; i++) {
+            SolidBlock block;
+            block.offset = readLE(in, 8);
+            block.compressed_size = readLE(in, 8);
+            block.raw_size = readLE(in, 8);
+            archive.blocks.push_back(block);
+        }
+        
+        uint64_t entry_count = readLE(in, 8);
+        for (uint64_t i = 0; i < entry_count; i++) {
+            SolidEntry entry;
+            uint32_t path_len = static_cast<uint32_t>(readLE(in, 4));
+            entry.path.resize(path_len);
+            if (!in.read(&entry.path[0], path_len)) {
+                throw std::runtime_error("固实归档索引不完整");
             }
-            
-            return true;
-            
-        } catch (...) {
-            zip_fclose(zf);
-            throw;
+            entry.mode = static_cast<uint32_t>(readLE(in, 4));
+            entry.mtime = static_cast<int64_t>(readLE(in, 8));
+            entry.size = readLE(in, 8);
+            entry.offset = readLE(in, 8);
+            archive.entries.push_back(std::move(entry));
         }
+        
+        return archive;
     }
     
-    // 检查路径是否安全
-    static bool isSafePath(const std::string& path) {
-        // 检查路径遍历攻击（如包含..或绝对路径）
-        if (path.find("..") != std::string::npos) {
-            return false;
+    static const std::vector<uint8_t>& loadSolidBlock(std::ifstream& in, const SolidArchive& archive,
+                                                     size_t index, SolidBlockCache& cache) {
+        if (cache.index == index) {
+            return cache.data;
+        }
+        if (index >= archive.blocks.size()) {
+            throw std::runtime_error("固实归档块索引越界");
         }
         
-        // 检查绝对路径
-        if (path.length() > 0 && (path[0] == '/' || path[0] == '\\')) {
-            return false;
+        const SolidBlock& block = archive.blocks[index];
+        std::vector<uint8_t> compressed(block.compressed_size);
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(block.offset));
+        if (!in.read(reinterpret_cast<char*>(compressed.data()), compressed.size())) {
+            throw std::runtime_error("读取固实块失败");
         }
         
-        // 检查Windows驱动器路径
-        if (path.length() > 1 && path[1] == ':') {
+        cache.data.resize(block.raw_size);
+        uint64_t memlimit = UINT64_MAX;
+        size_t in_pos = 0, out_pos = 0;
+        lzma_ret ret = lzma_stream_buffer_decode(&memlimit, 0, nullptr,
+                                                 compressed.data(), &in_pos, compressed.size(),
+                                                 cache.data.data(), &out_pos, cache.data.size());
+        if (ret != LZMA_OK || out_pos != block.raw_size) {
+            cache.index = SIZE_MAX;
+            throw std::runtime_error("固实块解压失败，错误代码: " + std::to_string(ret));
+        }
+        
+        cache.index = index;
+        cache.decoded_blocks++;
+        return cache.data;
+    }
+    
+    static bool extractSolidEntry(std::ifstream& in, const SolidArchive& archive,
+                                 const SolidEntry& entry, const fs::path& extract_path,
+                                 SolidBlockCache& cache,
+                                 ProgressCallback progress_cb, void* userdata) {
+        
+        if (!isSafePath(entry.path)) {
+            std::cerr << "警告: 跳过不安全路径: " << entry.path << std::endl;
             return false;
         }
         
+        fs::path full_path = extract_path / entry.path;
+        if (S_ISDIR(entry.mode)) {
+            fs::create_directories(full_path);
+            return true;
+        }
+        
+        fs::create_directories(full_path.parent_path());
+        std::ofstream out(full_path, std::ios::binary);
+        if (!out.is_open()) {
+            throw std::runtime_error("无法创建文件: " + full_path.string());
+        }
+        
+        uint64_t offset = entry.offset;
+        uint64_t remaining = entry.size;
+        while (remaining > 0) {
+            size_t index = static_cast<size_t>(offset / archive.block_size);
+            size_t within = static_cast<size_t>(offset % archive.block_size);
+            const std::vector<uint8_t>& data = loadSolidBlock(in, archive, index, cache);
+            if (within >= data.size()) {
+                throw std::runtime_error("固实归档数据偏移无效: " + entry.path);
+            }
+            
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, data.size() - within));
+            out.write(reinterpret_cast<const char*>(data.data() + within), n);
+            offset += n;
+            remaining -= n;
+            
+            if (progress_cb) {
+                progress_cb(entry.path, entry.size - remaining, entry.size, userdata);
+            } else {
+                defaultProgressCallback(entry.path, entry.size - remaining, entry.size, nullptr);
+            }
+        }
+        out.close();
+        
+        // 恢复权限和修改时间
+        std::error_code ec;
+        fs::permissions(full_path, static_cast<fs::perms>(entry.mode & 07777), ec);
+        struct timespec times[2];
+        times[0].tv_sec = times[1].tv_sec = entry.mtime;
+        times[0].tv_nsec = times[1].tv_nsec = 0;
+        utimensat(AT_FDCWD, full_path.c_str(), times, 0);
+        
         return true;
     }
 
 public:
-    // TAR.GZ解包
-    static void unpackTarFile(const std::string& path, const std::string& file,
-                             const std::string& output_dir = "",
-                             bool strip_components = 0,
-                             ProgressCallback progress_cb = nullptr,
-                             void* userdata = nullptr) {
+    // 通用解压函数（自动检测格式）
+    static void unpackFile(const std::string& path, const std::string& file,
+                          const std::string& output_dir = "",
+                          ProgressCallback progress_cb = nullptr,
+                          void* userdata = nullptr,
+                          RestorePolicy policy = RestorePolicy::OVERWRITE) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        
+        // 检测文件类型
+        std::string ext = archive_path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        
+        if (ext == ".zip") {
+            unpackZipFile(path, file, output_dir, progress_cb, userdata, policy);
+        } else if (ext == ".tar" || ext == ".tar.gz" || ext == ".tgz" || 
+                   ext == ".tar.bz2" || ext == ".tbz2" || ext == ".tar.xz" || ext == ".txz") {
+            unpackTarFile(path, file, output_dir, 0, progress_cb, userdata, policy);
+        } else if (ext == ".solid") {
+            unpackSolidFile(path, file, output_dir, progress_cb, userdata);
+        } else {
+            throw std::runtime_error("不支持的文件格式: " + ext);
+        }
+    }
+    
+    // 按通配符（fnmatch语法）选择性解压ZIP条目；名称查找走中央目录索引
+    static void extractZipMembers(const std::string& path, const std::string& file,
+                                 const std::string& pattern,
+                                 const std::string& output_dir = "",
+                                 ProgressCallback progress_cb = nullptr,
+                                 void* userdata = nullptr) {
         
         fs::path archive_path = fs::path(path) / file;
         fs::path extract_path = output_dir.empty() ? path : output_dir;
         
         try {
-            // 检查文件是否存在
-            if (!fs::exists(archive_path)) {
-                throw std::runtime_error("归档文件不存在: " + archive_path.string());
+            ZipCentralIndex index(archive_path);
+            std::vector<size_t> matches = index.glob(pattern);
+            std::cout << "匹配 " << pattern << ": " << matches.size() << " 个条目" << std::endl;
+            if (matches.empty()) {
+                return;
             }
             
-            // 创建解压目录
-            fs::create_directories(extract_path);
-            
-            std::cout << "正在解压TAR.GZ文件: " << archive_path.string() << std::endl;
-            std::cout << "解压到: " << extract_path.string() << std::endl;
-            
-            // 创建读取归档对象
-            struct archive* a = archive_read_new();
-            archive_read_support_format_all(a);
-            archive_read_support_filter_all(a);
-            
-            // 打开归档文件
-            if (archive_read_open_filename(a, archive_path.string().c_str(), 10240) != ARCHIVE_OK) {
-                archive_read_free(a);
-                throw std::runtime_error("无法打开TAR.GZ文件");
+            int error = 0;
+            zip_t* zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &error);
+            if (!zip) {
+                throw std::runtime_error("无法打开ZIP文件，错误代码: " + std::to_string(error));
             }
             
-            // 创建写入归档对象（用于提取）
-            struct archive* ext = archive_write_disk_new();
-            archive_write_disk_set_options(ext, 
-                ARCHIVE_EXTRACT_TIME |
-                ARCHIVE_EXTRACT_PERM |
-                ARCHIVE_EXTRACT_ACL |
-                ARCHIVE_EXTRACT_FFLAGS |
-                ARCHIVE_EXTRACT_SECURE_SYMLINKS |
-                ARCHIVE_EXTRACT_SECURE_NODOTDOT);
-            
-            // 设置解压目录
-            archive_write_disk_set_standard_lookup(ext);
+            // 条目数与libzip一致时，索引也用于定位未压缩条目的数据
+            const ZipCentralIndex* central =
+                static_cast<zip_int64_t>(index.size()) == zip_get_num_entries(zip, ZIP_FL_UNCHANGED) ? &index : nullptr;
             
-            // 遍历并解压所有文件
             size_t total_extracted = 0;
-            size_t total_skipped = 0;
-            
-            struct archive_entry* entry;
-            while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
-                const char* entry_path = archive_entry_pathname(entry);
-                
-                // 安全检查
-                if (!isSafePath(entry_path)) {
-                    std::cerr << "警告: 跳过不安全路径: " << entry_path << std::endl;
-                    archive_read_data_skip(a);
-                    total_skipped++;
+            ExtractionWriter writer;
+            writer.addRoot(extract_path);
+            for (size_t i : matches) {
+                std::string name(index.name(i));
+                if (!isSafePath(name)) {
+                    std::cerr << "警告: 跳过不安全路径: " << name << std::endl;
                     continue;
                 }
                 
-                // 去除指定层级的目录（strip_components）
-                std::string adjusted_path = entry_path;
-                if (strip_components > 0) {
-                    adjusted_path = stripPathComponents(entry_path, strip_components);
-                    if (adjusted_path.empty()) {
-                        archive_read_data_skip(a);
-                        continue;
-                    }
+                fs::path full_path = extract_path / name;
+                struct zip_stat st;
+                zip_stat_init(&st);
+                if (zip_stat_index(zip, i, 0, &st) != 0) {
+                    std::cerr << "警告: 无法获取文件信息: " << name << std::endl;
+                    continue;
                 }
                 
-                // 构建完整输出路径
-                fs::path full_path = extract_path / adjusted_path;
-                
-                // 更新归档条目路径
-                archive_entry_set_pathname(entry, full_path.string().c_str());
-                
-                // 提取文件
-                if (extractArchiveEntry(a, ext, entry, progress_cb, userdata)) {
+                bool ok;
+                if (name.back() == '/') {
+                    try {
+                        writer.ensureDirectory(full_path);
+                        ok = true;
+                    } catch (const std::exception& e) {
+                        std::cerr << "警告: " << e.what() << std::endl;
+                        ok = false;
+                    }
+                } else if (isZipSymlink(zip, i)) {
+                    ok = extractZipSymlink(zip, i, st, full_path, writer);
+                } else {
+                    ok = extractZipEntry(zip, i, st, full_path, writer, central, progress_cb, userdata);
+                }
+                if (ok) {
                     total_extracted++;
                 } else {
-                    std::cerr << "错误: 解压失败: " << entry_path << std::endl;
+                    std::cerr << "错误: 解压失败: " << name << std::endl;
                 }
             }
             
-            // 清理资源
-            archive_read_close(a);
-            archive_read_free(a);
-            archive_write_close(ext);
-            archive_write_free(ext);
+            zip_close(zip);
+            writer.finish();
+            std::cout << "成功解压: " << total_extracted << " 个条目" << std::endl;
             
-            std::cout << "\n解压完成!" << std::endl;
-            std::cout << "成功解压: " << total_extracted << " 个文件" << std::endl;
-            if (total_skipped > 0) {
-                std::cout << "跳过: " << total_skipped << " 个不安全文件" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "ZIP选择性解压错误: " << e.what() << std::endl;
+            throw;
+        }
+    }
+    
+    // 校验归档完整性（测试模式）：所有条目解压到空输出，核对CRC和大小，不写磁盘。
+    // ZIP按条目、固实归档按块并行校验，xz使用多线程解码；max_read_mb_per_sec限制读取速率（0为不限）。
+    // 报告为JSON，写入report_path（为空时输出到标准输出）；全部通过时返回true
+    static bool verifyArchive(const std::string& path, const std::string& file,
+                             const std::string& report_path = "",
+                             size_t thread_count = 0,
+                             size_t max_read_mb_per_sec = 0) {
+        
+        fs::path archive_path = fs::path(path) / file;
+        VerifyReport report;
+        report.archive = archive_path.string();
+        
+        ReadThrottle throttle;
+        throttle.bytes_per_sec = static_cast<uint64_t>(max_read_mb_per_sec) * 1024 * 1024;
+        if (thread_count == 0) {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        try {
+            if (!fs::exists(archive_path)) {
+                throw std::runtime_error("归档文件不存在: " + archive_path.string());
             }
             
+            std::string name = archive_path.filename().string();
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            auto endsWith = [&](const std::string& suffix) {
+                return name.size() >= suffix.size() &&
+                       name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+            };
+            
+            if (endsWith(".zip")) {
+                report.format = "zip";
+                verifyZip(archive_path, report, thread_count, throttle);
+            } else if (endsWith(".solid")) {
+                report.format = "solid";
+                verifySolid(archive_path, report, thread_count, throttle);
+            } else if (endsWith(".tar.xz") || endsWith(".txz")) {
+                report.format = "tar.xz";
+                verifyXz(archive_path, true, report, thread_count, throttle);
+            } else if (endsWith(".xz")) {
+                report.format = "xz";
+                verifyXz(archive_path, false, report, thread_count, throttle);
+            } else {
+                report.format = "tar";
+                verifyTar(archive_path, report, throttle);
+            }
         } catch (const std::exception& e) {
-            std::cerr << "\nTAR解压错误: " << e.what() << std::endl;
-            throw;
+            report.addError("", e.what());
+        }
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        writeVerifyReport(report, report_path);
+        if (!report_path.empty()) {
+            std::cout << "校验" << (report.errors.empty() ? "通过" : "失败") << ": "
+                      << report.entries << " 个条目, " << report.bytes << " 字节, "
+                      << report.errors.size() << " 个错误, 报告: " << report_path << std::endl;
         }
+        return report.errors.empty();
     }
-
+    
 private:
-    // 去除路径的前几个组件
-    static std::string stripPathComponents(const std::string& path, int components) {
-        std::string result = path;
+    // 校验结果，可由多个校验线程同时更新
+    struct VerifyReport {
+        std::string archive;
+        std::string format;
+        std::atomic<size_t> entries{0};
+        std::atomic<uint64_t> bytes{0};
+        double seconds = 0;
+        std::mutex mutex;
+        std::vector<std::pair<std::string, std::string>> errors;     // 条目名、错误信息
         
-        for (int i = 0; i < components; i++) {
-            size_t pos = result.find_first_of("/\\");
-            if (pos == std::string::npos) {
-                return "";  // 没有足够的组件可以去除
+        void addError(const std::string& entry, const std::string& message) {
+            std::lock_guard<std::mutex> lock(mutex);
+            errors.emplace_back(entry, message);
+        }
+    };
+    
+    // 读取限速（令牌桶），多个线程共享；bytes_per_sec为0时不限速
+    struct ReadThrottle {
+        uint64_t bytes_per_sec = 0;
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+        
+        void acquire(uint64_t bytes) {
+            if (bytes_per_sec == 0 || bytes == 0) {
+                return;
             }
-            result = result.substr(pos + 1);
+            std::chrono::steady_clock::time_point wake;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto now = std::chrono::steady_clock::now();
+                if (next < now) {
+                    next = now;
+                }
+                wake = next;
+                next += std::chrono::nanoseconds(bytes * 1000000000ULL / bytes_per_sec);
+            }
+            std::this_thread::sleep_until(wake);
+        }
+    };
+    
+    // ZIP：扫描句柄做一致性检查（ZIP_CHECKCONS），各线程用独立句柄校验条目
+    static void verifyZip(const fs::path& archive_path, VerifyReport& report,
+                          size_t thread_count, ReadThrottle& throttle) {
+        int error = 0;
+        zip_t* zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY | ZIP_CHECKCONS, &error);
+        if (!zip) {
+            throw std::runtime_error("无法打开ZIP文件，错误代码: " + std::to_string(error));
         }
         
-        return result;
+        std::vector<ZipTask> tasks;
+        zip_int64_t num_entries = zip_get_num_entries(zip, ZIP_FL_UNCHANGED);
+        for (zip_int64_t i = 0; i < num_entries; i++) {
+            ZipTask task;
+            task.index = i;
+            zip_stat_init(&task.st);
+            if (zip_stat_index(zip, i, 0, &task.st) != 0) {
+                report.addError("#" + std::to_string(i), "无法获取条目信息");
+                continue;
+            }
+            if (task.st.name[strlen(task.st.name) - 1] == '/') {
+                continue;
+            }
+            tasks.push_back(task);
+        }
+        
+        std::sort(tasks.begin(), tasks.end(),
+                  [](const ZipTask& a, const ZipTask& b) { return a.st.size > b.st.size; });
+        thread_count = std::max<size_t>(1, std::min(thread_count, tasks.size()));
+        
+        std::atomic<size_t> next_task{0};
+        auto worker = [&]() {
+            int worker_error = 0;
+            zip_t* worker_zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &worker_error);
+            if (!worker_zip) {
+                report.addError("", "工作线程无法打开ZIP文件，错误代码: " + std::to_string(worker_error));
+                return;
+            }
+            std::vector<Bytef> buffer(256 * 1024);
+            size_t i;
+            while ((i = next_task++) < tasks.size()) {
+                verifyZipEntry(worker_zip, tasks[i], buffer, report, throttle);
+            }
+            zip_close(worker_zip);
+        };
+        
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < thread_count; t++) {
+            workers.emplace_back(worker);
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        zip_close(zip);
     }
     
-    // 提取归档条目
-    static bool extractArchiveEntry(struct archive* a, struct archive* ext,
-                                   struct archive_entry* entry,
-                                   ProgressCallback progress_cb,
-                                   void* userdata) {
+    static void verifyZipEntry(zip_t* zip, const ZipTask& task, std::vector<Bytef>& buffer,
+                               VerifyReport& report, ReadThrottle& throttle) {
+        const struct zip_stat& st = task.st;
+        zip_file_t* zf = zip_fopen_index(zip, task.index, 0);
+        if (!zf) {
+            report.addError(st.name, zip_strerror(zip));
+            return;
+        }
         
-        // 写入条目头部
-        int r = archive_write_header(ext, entry);
-        if (r != ARCHIVE_OK) {
-            std::cerr << "警告: 无法写入文件头: " 
-                      << archive_entry_pathname(entry) 
-                      << " - " << archive_error_string(ext) << std::endl;
-            return false;
+        uLong crc = crc32(0L, Z_NULL, 0);
+        uint64_t total = 0;
+        while (true) {
+            zip_int64_t n = zip_fread(zf, buffer.data(), buffer.size());
+            if (n < 0) {
+                report.addError(st.name, zip_file_strerror(zf));
+                zip_fclose(zf);
+                return;
+            }
+            if (n == 0) {
+                break;
+            }
+            // 限速按压缩后的数据量折算
+            if (st.size > 0) {
+                throttle.acquire(static_cast<uint64_t>(n) * st.comp_size / st.size);
+            }
+            crc = crc32(crc, buffer.data(), static_cast<uInt>(n));
+            total += static_cast<uint64_t>(n);
         }
+        zip_fclose(zf);
         
-        // 如果是普通文件，写入内容
-        const void* buff;
-        size_t size;
-        la_int64_t offset;
+        report.entries++;
+        report.bytes += total;
+        if ((st.valid & ZIP_STAT_SIZE) && total != st.size) {
+            report.addError(st.name, "大小不符: 应为 " + std::to_string(st.size) + ", 实际 " + std::to_string(total));
+        } else if ((st.valid & ZIP_STAT_CRC) && crc != st.crc) {
+            report.addError(st.name, "CRC不符");
+        }
+    }
+    
+    // 固实归档：各块独立解码（xz校验CRC32并核对原始大小），按块并行
+    static void verifySolid(const fs::path& archive_path, VerifyReport& report,
+                            size_t thread_count, ReadThrottle& throttle) {
+        SolidArchive archive;
+        {
+            std::ifstream in(archive_path, std::ios::binary);
+            if (!in.is_open()) {
+                throw std::runtime_error("无法打开固实归档: " + archive_path.string());
+            }
+            archive = readSolidIndex(in);
+        }
         
-        if (archive_entry_size(entry) > 0) {
-            const char* filename = archive_entry_pathname(entry);
-            la_int64_t total_size = archive_entry_size(entry);
-            la_int64_t bytes_written = 0;
-            
-            while (true) {
-                r = archive_read_data_block(a, &buff, &size, &offset);
-                if (r == ARCHIVE_EOF) {
-                    break;
-                }
-                if (r != ARCHIVE_OK) {
-                    std::cerr << "警告: 读取数据块失败: " 
-                              << archive_error_string(a) << std::endl;
-                    return false;
-                }
-                
-                r = archive_write_data_block(ext, buff, size, offset);
-                if (r != ARCHIVE_OK) {
-                    std::cerr << "警告: 写入数据块失败: " 
-                              << archive_error_string(ext) << std::endl;
-                    return false;
-                }
-                
-                bytes_written += size;
-                
-                // 调用进度回调
-                if (progress_cb) {
-                    progress_cb(filename, bytes_written, total_size, userdata);
-                }
+        uint64_t raw_total = 0;
+        for (const auto& block : archive.blocks) {
+            raw_total += block.raw_size;
+        }
+        for (const auto& entry : archive.entries) {
+            if (!S_ISDIR(entry.mode) && entry.offset + entry.size > raw_total) {
+                report.addError(entry.path, "数据范围超出归档");
             }
         }
         
-        // 完成条目写入
-        r = archive_write_finish_entry(ext);
-        if (r != ARCHIVE_OK) {
-            std::cerr << "警告: 完成条目失败: " 
-                      << archive_error_string(ext) << std::endl;
-            return false;
+        thread_count = std::max<size_t>(1, std::min(thread_count, archive.blocks.size()));
+        std::atomic<size_t> next_block{0};
+        auto worker = [&]() {
+            std::ifstream in(archive_path, std::ios::binary);
+            SolidBlockCache cache;
+            size_t i;
+            while ((i = next_block++) < archive.blocks.size()) {
+                throttle.acquire(archive.blocks[i].compressed_size);
+                try {
+                    report.bytes += loadSolidBlock(in, archive, i, cache).size();
+                } catch (const std::exception& e) {
+                    report.addError("块 " + std::to_string(i), e.what());
+                }
+            }
+        };
+        
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < thread_count; t++) {
+            workers.emplace_back(worker);
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+        report.entries = archive.entries.size();
+    }
+    
+    // tar及tar.gz/bz2等：单个压缩流只能顺序解码，由libarchive校验头部校验和及压缩流CRC
+    static void verifyTar(const fs::path& archive_path, VerifyReport& report, ReadThrottle& throttle) {
+        int fd = ::open(archive_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("无法打开归档: " + archive_path.string());
         }
+        ThrottledFile source{fd, &throttle, std::vector<char>(ExtractionWriter::BUFFER_SIZE)};
         
-        std::cout << "解压文件: " << archive_entry_pathname(entry) 
-                  << " (" << archive_entry_size(entry) << " 字节)" << std::endl;
+        struct archive* a = archive_read_new();
+        archive_read_support_format_all(a);
+        archive_read_support_filter_all(a);
+        if (archive_read_open(a, &source, nullptr, readThrottledFile, nullptr) != ARCHIVE_OK) {
+            std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+            archive_read_free(a);
+            close(fd);
+            throw std::runtime_error("无法读取归档: " + error);
+        }
+        verifyEntries(a, report);
+        archive_read_free(a);
+        close(fd);
+    }
+    
+    // xz：多线程解码各xz块（多块文件才能并行），liblzma校验每块的完整性校验值；
+    // tar.xz的解码输出再交给libarchive逐条目核对
+    static void verifyXz(const fs::path& archive_path, bool is_tar, VerifyReport& report,
+                         size_t thread_count, ReadThrottle& throttle) {
+        XzSource source(archive_path, thread_count, throttle);
+        if (!is_tar) {
+            std::vector<uint8_t> buffer(ExtractionWriter::BUFFER_SIZE);
+            size_t n;
+            while ((n = source.read(buffer.data(), buffer.size())) > 0) {
+                report.bytes += n;
+            }
+            report.entries = 1;
+            return;
+        }
         
-        return true;
+        XzFeed feed{&source, std::vector<uint8_t>(ExtractionWriter::BUFFER_SIZE), ""};
+        struct archive* a = archive_read_new();
+        archive_read_support_format_all(a);
+        if (archive_read_open(a, &feed, nullptr, readXzFeed, nullptr) != ARCHIVE_OK) {
+            std::string error = archive_error_string(a) ? archive_error_string(a) : "未知错误";
+            archive_read_free(a);
+            throw std::runtime_error("无法读取归档: " + error);
+        }
+        verifyEntries(a, report);
+        archive_read_free(a);
+        if (!feed.error.empty()) {
+            report.addError("", feed.error);
+        }
     }
-
-public:
-    // 通用解压函数（自动检测格式）
-    static void unpackFile(const std::string& path, const std::string& file,
-                          const std::string& output_dir = "",
-                          ProgressCallback progress_cb = nullptr,
-                          void* userdata = nullptr) {
+    
+    // 逐条目读完数据并核对大小（稀疏文件和硬链接除外）
+    static void verifyEntries(struct archive* a, VerifyReport& report) {
+        struct archive_entry* entry;
+        int r;
+        while ((r = archive_read_next_header(a, &entry)) == ARCHIVE_OK || r == ARCHIVE_WARN) {
+            std::string name = archive_entry_pathname(entry) ? archive_entry_pathname(entry) : "";
+            const void* buff;
+            size_t size;
+            la_int64_t offset;
+            uint64_t total = 0;
+            int rr;
+            while ((rr = archive_read_data_block(a, &buff, &size, &offset)) == ARCHIVE_OK) {
+                total += size;
+            }
+            
+            report.entries++;
+            report.bytes += total;
+            if (rr != ARCHIVE_EOF) {
+                const char* error = archive_error_string(a);
+                report.addError(name, error ? error : "读取数据失败");
+                if (rr == ARCHIVE_FATAL) {
+                    return;
+                }
+                continue;
+            }
+            if (archive_entry_filetype(entry) == AE_IFREG && !archive_entry_hardlink(entry) &&
+                archive_entry_sparse_count(entry) == 0 && archive_entry_size_is_set(entry) &&
+                total != static_cast<uint64_t>(archive_entry_size(entry))) {
+                report.addError(name, "大小不符: 应为 " + std::to_string(archive_entry_size(entry)) +
+                                      ", 实际 " + std::to_string(total));
+            }
+        }
+        if (r != ARCHIVE_EOF) {
+            const char* error = archive_error_string(a);
+            report.addError("", error ? error : "读取归档失败");
+        }
+    }
+    
+    struct ThrottledFile {
+        int fd;
+        ReadThrottle* throttle;
+        std::vector<char> buffer;
+    };
+    
+    static la_ssize_t readThrottledFile(struct archive* a, void* client_data, const void** buffer) {
+        ThrottledFile* source = static_cast<ThrottledFile*>(client_data);
+        ssize_t n;
+        do {
+            n = ::read(source->fd, source->buffer.data(), source->buffer.size());
+        } while (n < 0 && errno == EINTR);
+        if (n < 0) {
+            archive_set_error(a, errno, "读取归档失败");
+            return -1;
+        }
+        source->throttle->acquire(static_cast<uint64_t>(n));
+        *buffer = source->buffer.data();
+        return static_cast<la_ssize_t>(n);
+    }
+    
+    // 多线程xz解码器，按顺序输出解压数据
+    class XzSource {
+        int fd = -1;
+        lzma_stream strm = LZMA_STREAM_INIT;
+        std::vector<uint8_t> input;
+        ReadThrottle& throttle;
+        bool input_eof = false;
+        bool finished = false;
         
-        fs::path archive_path = fs::path(path) / file;
+    public:
+        XzSource(const fs::path& path, size_t threads, ReadThrottle& read_throttle)
+            : input(ExtractionWriter::BUFFER_SIZE), throttle(read_throttle) {
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("无法打开归档: " + path.string());
+            }
+            lzma_mt mt;
+            memset(&mt, 0, sizeof(mt));
+            mt.flags = LZMA_CONCATENATED;
+            mt.threads = static_cast<uint32_t>(threads);
+            mt.memlimit_threading = std::max<uint64_t>(lzma_physmem() / 4, 64ULL * 1024 * 1024);
+            mt.memlimit_stop = UINT64_MAX;
+            if (lzma_stream_decoder_mt(&strm, &mt) != LZMA_OK) {
+                close(fd);
+                throw std::runtime_error("无法初始化xz解码器");
+            }
+        }
         
-        // 检测文件类型
-        std::string ext = archive_path.extension().string();
-        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        ~XzSource() {
+            lzma_end(&strm);
+            close(fd);
+        }
         
-        if (ext == ".zip") {
-            unpackZipFile(path, file, output_dir, progress_cb, userdata);
-        } else if (ext == ".tar" || ext == ".tar.gz" || ext == ".tgz" || 
-                   ext == ".tar.bz2" || ext == ".tbz2" || ext == ".tar.xz" || ext == ".txz") {
-            unpackTarFile(path, file, output_dir, 0, progress_cb, userdata);
-        } else {
-            throw std::runtime_error("不支持的文件格式: " + ext);
+        XzSource(const XzSource&) = delete;
+        XzSource& operator=(const XzSource&) = delete;
+        
+        // 读出最多len字节解压数据，返回0表示流结束
+        size_t read(uint8_t* out, size_t len) {
+            strm.next_out = out;
+            strm.avail_out = len;
+            while (strm.avail_out == len && !finished) {
+                if (strm.avail_in == 0 && !input_eof) {
+                    ssize_t n = ::read(fd, input.data(), input.size());
+                    if (n < 0) {
+                        throw std::runtime_error("读取归档失败: " + std::string(strerror(errno)));
+                    }
+                    input_eof = n == 0;
+                    throttle.acquire(static_cast<uint64_t>(n));
+                    strm.next_in = input.data();
+                    strm.avail_in = static_cast<size_t>(n);
+                }
+                lzma_ret ret = lzma_code(&strm, input_eof ? LZMA_FINISH : LZMA_RUN);
+                if (ret == LZMA_STREAM_END) {
+                    finished = true;
+                } else if (ret != LZMA_OK) {
+                    throw std::runtime_error("xz数据校验失败，错误代码: " + std::to_string(ret));
+                }
+            }
+            return len - strm.avail_out;
         }
+    };
+    
+    struct XzFeed {
+        XzSource* source;
+        std::vector<uint8_t> buffer;
+        std::string error;      // 解码错误，libarchive只会报告为数据截断
+    };
+    
+    static la_ssize_t readXzFeed(struct archive* a, void* client_data, const void** buffer) {
+        XzFeed* feed = static_cast<XzFeed*>(client_data);
+        try {
+            *buffer = feed->buffer.data();
+            return static_cast<la_ssize_t>(feed->source->read(feed->buffer.data(), feed->buffer.size()));
+        } catch (const std::exception& e) {
+            feed->error = e.what();
+            archive_set_error(a, EIO, "%s", e.what());
+            return -1;
+        }
+    }
+    
+    static std::string jsonEscape(const std::string& value) {
+        std::string out;
+        for (unsigned char c : value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += static_cast<char>(c);
+            } else if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+        return out;
     }
     
+    static void writeVerifyReport(const VerifyReport& report, const std::string& report_path) {
+        char seconds[32];
+        snprintf(seconds, sizeof(seconds), "%.3f", report.seconds);
+        
+        std::string json = "{\n";
+        json += "  \"archive\": \"" + jsonEscape(report.archive) + "\",\n";
+        json += "  \"format\": \"" + jsonEscape(report.format) + "\",\n";
+        json += std::string("  \"status\": \"") + (report.errors.empty() ? "ok" : "failed") + "\",\n";
+        json += "  \"entries\": " + std::to_string(report.entries.load()) + ",\n";
+        json += "  \"bytes\": " + std::to_string(report.bytes.load()) + ",\n";
+        json += std::string("  \"seconds\": ") + seconds + ",\n";
+        json += "  \"errors\": [";
+        for (size_t i = 0; i < report.errors.size(); i++) {
+            json += i == 0 ? "\n" : ",\n";
+            json += "    {\"entry\": \"" + jsonEscape(report.errors[i].first) +
+                    "\", \"message\": \"" + jsonEscape(report.errors[i].second) + "\"}";
+        }
+        json += report.errors.empty() ? "]\n}\n" : "\n  ]\n}\n";
+        
+        if (report_path.empty()) {
+            std::cout << json;
+            return;
+        }
+        std::ofstream out(report_path);
+        if (!out.is_open()) {
+            throw std::runtime_error("无法写入校验报告: " + report_path);
+        }
+        out << json;
+    }
+
+public:
     // 列出归档内容
     static void listArchiveContents(const std::string& path, const std::string& file) {
         fs::path archive_path = fs::path(path) / file;
@@ -430,6 +3923,8 @@ public:
         } else if (ext == ".tar" || ext == ".tar.gz" || ext == ".tgz" || 
                    ext == ".tar.bz2" || ext == ".tbz2" || ext == ".tar.xz" || ext == ".txz") {
             listTarContents(path, file);
+        } else if (ext == ".solid") {
+            listSolidContents(path, file);
         } else {
             throw std::runtime_error("不支持的文件格式: " + ext);
         }
@@ -440,40 +3935,56 @@ private:
     static void listZipContents(const std::string& path, const std::string& file) {
         fs::path archive_path = fs::path(path) / file;
         
-        int error = 0;
-        zip_t* zip = zip_open(archive_path.string().c_str(), ZIP_RDONLY, &error);
-        if (!zip) {
-            throw std::runtime_error("无法打开ZIP文件");
-        }
+        // 直接读取映射的中央目录，不经过libzip逐条查询
+        ZipCentralIndex index(archive_path);
         
         std::cout << "ZIP文件内容: " << archive_path.string() << std::endl;
         std::cout << "=================================================================\n";
         
-        zip_int64_t num_entries = zip_get_num_entries(zip, ZIP_FL_UNCHANGED);
-        zip_int64_t total_size = 0;
-        
-        for (zip_int64_t i = 0; i < num_entries; i++) {
-            const char* name = zip_get_name(zip, i, ZIP_FL_ENC_RAW);
-            struct zip_stat st;
-            zip_stat_init(&st);
+        uint64_t total_size = 0;
+        for (size_t i = 0; i < index.size(); i++) {
+            ZipCentralIndex::EntryInfo info = index.entry(i);
+            std::string type = info.is_dir ? "目录" : "文件";
             
-            if (zip_stat_index(zip, i, 0, &st) == 0) {
-                std::string type = "文件";
-                if (name[strlen(name) - 1] == '/') type = "目录";
-                
-                std::cout << std::setw(10) << type 
-                          << " " << std::setw(10) << st.size << " 字节"
-                          << " " << name << std::endl;
-                
-                total_size += st.size;
-            }
+            std::cout << std::setw(10) << type 
+                      << " " << std::setw(10) << info.size << " 字节"
+                      << " " << info.name << '\n';
+            
+            total_size += info.size;
         }
         
         std::cout << "=================================================================\n";
-        std::cout << "总计: " << num_entries << " 个条目, " 
+        std::cout << "总计: " << index.size() << " 个条目, " 
                   << total_size << " 字节" << std::endl;
+    }
+    
+    // 列出固实归档内容
+    static void listSolidContents(const std::string& path, const std::string& file) {
+        fs::path archive_path = fs::path(path) / file;
         
-        zip_close(zip);
+        std::ifstream in(archive_path, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("无法打开固实归档");
+        }
+        SolidArchive archive = readSolidIndex(in);
+        
+        std::cout << "固实归档内容: " << archive_path.string() << std::endl;
+        std::cout << "=================================================================\n";
+        
+        uint64_t total_size = 0;
+        for (const auto& entry : archive.entries) {
+            std::string type = S_ISDIR(entry.mode) ? "目录" : "文件";
+            std::cout << std::setw(10) << type
+                      << " " << std::setw(10) << entry.size << " 字节"
+                      << " 块" << std::setw(4) << entry.offset / archive.block_size
+                      << " " << entry.path << std::endl;
+            total_size += entry.size;
+        }
+        
+        std::cout << "=================================================================\n";
+        std::cout << "总计: " << archive.entries.size() << " 个条目, " 
+                  << archive.blocks.size() << " 个块, "
+                  << total_size << " 字节" << std::endl;
     }
     
     // 列出TAR文件内容
@@ -590,6 +4101,23 @@ int main() {
                                            customProgressCallback, &progress_data);
         }
         
+        std::cout << "\n=== 并行解压ZIP文件 ===\n";
+        if (fs::exists("test.zip")) {
+            ArchiveExtractor::unpackZipFileParallel(path, "test.zip", "extracted_zip_parallel", 0,
+                                                   customProgressCallback, &progress_data);
+        }
+        
+        std::cout << "\n=== 按通配符解压ZIP条目 ===\n";
+        if (fs::exists("test.zip")) {
+            ArchiveExtractor::extractZipMembers(path, "test.zip", "*.txt", "extracted_zip_txt");
+        }
+        
+        std::cout << "\n=== 续传恢复ZIP文件（跳过已一致的文件） ===\n";
+        if (fs::exists("test.zip")) {
+            ArchiveExtractor::unpackZipFile(path, "test.zip", "extracted_zip", nullptr, nullptr,
+                                           ArchiveExtractor::RestorePolicy::SKIP_SAME_CRC);
+        }
+        
         std::cout << "\n=== 解压TAR.GZ文件 ===\n";
         // 解压TAR.GZ文件
         if (fs::exists("test.tar.gz")) {
@@ -597,6 +4125,41 @@ int main() {
                                           0, customProgressCallback, &progress_data);
         }
         
+        std::cout << "\n=== 借助索引从TAR.GZ提取单个文件 ===\n";
+        if (fs::exists("test.tar.gz")) {
+            ArchiveExtractor::buildTarIndex(path, "test.tar.gz");
+            ArchiveExtractor::extractTarMember(path, "test.tar.gz", "readme.txt", "extracted_tar_member");
+        }
+
+        std::cout << "\n=== 随机读取归档成员 ===\n";
+        if (fs::exists("test.tar.gz")) {
+            ArchiveReader reader(fs::path(path) / "test.tar.gz");
+            if (!reader.members().empty()) {
+                const auto& info = reader.members().front();
+                ArchiveReader::Member member = reader.open(info.name);
+                std::vector<char> slice(64);
+                size_t n = member.read(member.size() / 2, slice.data(), slice.size());
+                std::cout << info.name << " 中间位置读取 " << n << " 字节, 解码 "
+                          << reader.blocksDecoded() << " 个块" << std::endl;
+            }
+        }
+
+        std::cout << "\n=== 递归解压（展开内层归档） ===\n";
+        if (fs::exists("test.zip")) {
+            ArchiveExtractor::unpackRecursive(path, "test.zip", "extracted_recursive");
+        }
+        
+        std::cout << "\n=== 校验归档完整性 ===\n";
+        if (fs::exists("test.zip")) {
+            ArchiveExtractor::verifyArchive(path, "test.zip", "test.zip.verify.json");
+        }
+        
+        std::cout << "\n=== 从标准输入流式解压 ===\n";
+        // 例如: xz -dc backup.tar.xz | ./unpack，或由解密程序通过管道直接供数
+        if (!isatty(STDIN_FILENO)) {
+            ArchiveExtractor::unpackStream(STDIN_FILENO, "extracted_stream");
+        }
+        
         std::cout << "\n=== 使用通用解压函数 ===\n";
         // 通用解压
         if (fs::exists("test.zip")) {